@@ -0,0 +1,247 @@
+/*
+ * LayeredProperties.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef INCLUDE_PROPERTIES4CXX_LAYEREDPROPERTIES_H_
+#define INCLUDE_PROPERTIES4CXX_LAYEREDPROPERTIES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Properties4CXX/Properties.h"
+#include "Properties4CXX/Property.h"
+
+namespace Properties4CXX {
+
+/** \brief Read-only view of a stack of configurations, e.g. built-in defaults, a site file, a host file, and command line overrides
+ *
+ * The layers are not copied. A lookup searches the layers from the top down, and returns the property of the
+ * topmost layer which defines it.
+ * Properties are identified by their path like \ref Properties::searchPropertyPath(). Thus an upper layer can override a
+ * single property within a structure of a lower layer.
+ *
+ * Each layer has a Bloom filter of the paths of all its properties. A layer whose filter does not contain a path
+ * is skipped without searching it. Thus lookups of properties which are only defined in the lower layers
+ * cost little more than a lookup in a single configuration.
+ *
+ * The layers must outlive the view. When a layer is modified or read again call \ref refresh().
+ * Until then the filter of the modified layer is bypassed, i.e. lookups remain correct but become slower.
+ *
+ * Iterating over the view visits the properties of the merged configuration as if all layers were merged
+ * into one configuration. Structures are merged recursively. Only the leaves are visited, i.e. the properties
+ * which are no structures, in the order of their paths.
+ */
+class PROPERTIES4CXX_PUBLIC
+LayeredProperties {
+public:
+
+	/// \brief A property of the merged configuration
+	struct Entry {
+		/// Path of the property, e.g. "db.primary.port"
+		std::string path;
+		/// The property of the topmost layer which defines \ref path
+		Property const *property;
+	};
+
+	/** \brief Forward iterator over the leaves of the merged configuration
+	 *
+	 * The iterator merges the sorted property maps of the layers on the fly. It does not copy properties.
+	 * It is invalidated when a layer is modified.
+	 */
+	class PROPERTIES4CXX_PUBLIC
+	const_iterator {
+	public:
+
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Entry value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef Entry const *pointer;
+		typedef Entry const &reference;
+
+		/// \brief Constructor of the end iterator
+		const_iterator () = default;
+
+		reference operator * () const {
+			return current;
+		}
+
+		pointer operator -> () const {
+			return &current;
+		}
+
+		const_iterator &operator ++ () {
+			settle();
+			return *this;
+		}
+
+		const_iterator operator ++ (int) {
+			const_iterator rc = *this;
+			settle();
+			return rc;
+		}
+
+		bool operator == (const_iterator const &other) const {
+			return stack.empty() ? other.stack.empty() : (!other.stack.empty() && current.path == other.current.path);
+		}
+
+		bool operator != (const_iterator const &other) const {
+			return !(*this == other);
+		}
+
+	private:
+
+		friend class LayeredProperties;
+
+		/// \brief Position in the property maps of one structure level
+		struct Frame {
+			/// Path of the structure including the trailing dot. Empty on the top level.
+			std::string prefix;
+			/// Current position and end of the map of each layer on this level. The topmost layer is first.
+			std::vector<std::pair<Properties::PropertyCIterator,Properties::PropertyCIterator>> positions;
+		};
+
+		/// \brief Start at the first leaf of \p layers
+		const_iterator (std::vector<Properties const *> const &layers);
+
+		/// \brief Move to the next leaf, or to the end
+		void settle ();
+
+		std::vector<Frame> stack;
+		Entry current {std::string(),nullptr};
+
+	};
+
+	LayeredProperties () = default;
+
+	/** \brief Put a configuration on top of the stack of layers
+	 *
+	 * @param layer The configuration. It is not copied, and must outlive the view.
+	 */
+	void pushLayer (Properties const &layer);
+
+	/// \brief Return the number of layers
+	size_t getNumLayers () const {
+		return layers.size();
+	}
+
+	/** \brief Return a layer
+	 *
+	 * @param index Index of the layer. 0 is the bottom layer which was pushed first.
+	 * @return Reference to the configuration of the layer
+	 */
+	Properties const &getLayer (size_t index) const {
+		return *layers[index].properties;
+	}
+
+	/// \brief Rebuild the Bloom filters of the layers which were modified since they were pushed or refreshed
+	void refresh ();
+
+	/** \brief Search a property from the top layer down
+	 *
+	 * A structure is returned from the topmost layer which defines it. Its content is the content in this layer only.
+	 * Look up the properties in the structure by their paths to get the merged content.
+	 *
+	 * @param propertyPath Path of the property, e.g. "db.primary.port"
+	 * @return Pointer to the property of the topmost layer which defines it, or nullptr when no layer defines it
+	 */
+	Property const *findPropertyPath (std::string const &propertyPath) const;
+
+	/** \brief Search a property from the top layer down
+	 *
+	 * \see findPropertyPath()
+	 *
+	 * @param propertyPath Path of the property, e.g. "db.primary.port"
+	 * @return Pointer to the property of the topmost layer which defines it
+	 * @throws ExceptionPropertyNotFound when no layer defines the property
+	 */
+	Property const *searchPropertyPath (std::string const &propertyPath) const;
+
+	/** \brief Return a boolean value, or the default when no layer defines the property
+	 *
+	 * \see Properties::getPropertyValue(std::string const&,bool) const
+	 * @throws ExceptionWrongPropertyType
+	 */
+	bool getPropertyValue (std::string const &propertyPath,bool defaultVal = false) const;
+
+	/** \brief Return a double value, or the default when no layer defines the property
+	 *
+	 * \see Properties::getPropertyValue(std::string const&,double) const
+	 * @throws ExceptionWrongPropertyType
+	 */
+	double getPropertyValue (std::string const &propertyPath,double defaultVal = 0.0) const;
+
+	/** \brief Return an integer value, or the default when no layer defines the property
+	 *
+	 * \see Properties::getPropertyValue(std::string const&,long long) const
+	 * @throws ExceptionWrongPropertyType
+	 */
+	long long getPropertyValue (std::string const &propertyPath,long long defaultVal = 0L) const;
+
+	/** \brief Return a string value, or the default when no layer defines the property
+	 *
+	 * \see Properties::getPropertyValue(std::string const&,char const*) const
+	 * @throws ExceptionWrongPropertyType when the property is a structure
+	 */
+	char const * getPropertyValue (std::string const &propertyPath,char const * defaultVal = nullptr) const;
+
+	/// \brief Return an iterator to the first leaf of the merged configuration
+	const_iterator begin () const;
+
+	/// \brief Return the end iterator
+	const_iterator end () const {
+		return const_iterator();
+	}
+
+private:
+
+	/// \brief A layer and the Bloom filter of its property paths
+	struct Layer {
+		Properties const *properties;
+		/// Content fingerprint of the layer when the filter was built. The filter is bypassed when it differs.
+		uint64_t contentHash;
+		/// Bits of the filter. The number of bits is a power of 2.
+		std::vector<uint64_t> filterBits;
+	};
+
+	/// \brief Number of bits which are set per path in the Bloom filters
+	static constexpr unsigned numFilterHashes = 7;
+
+	/// \brief The layers. The bottom layer is first.
+	std::vector<Layer> layers;
+
+	/// \brief Build the Bloom filter of \p layer
+	static void buildFilter (Layer &layer);
+
+	/// \brief Return false when \p layer surely does not contain the path with the hash value \p pathHash
+	static bool mayContain (Layer const &layer,uint64_t pathHash);
+
+};
+
+} /* namespace Properties4CXX */
+
+#endif /* INCLUDE_PROPERTIES4CXX_LAYEREDPROPERTIES_H_ */
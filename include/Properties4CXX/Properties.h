@@ -26,17 +26,37 @@
 #ifndef INCLUDE_PROPERTIES4CXX_PROPERTies_H_
 #define INCLUDE_PROPERTIES4CXX_PROPERTies_H_
 
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
 #include <memory>
 #include <sstream>
 #include <fstream>
 #include <map>
+#include <set>
+#include <memory_resource>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <functional>
+#include <future>
+#include <iterator>
 
 namespace Properties4CXX {
 class Properties;
+class IncludeCache;
+class AccessProfiler;
+class CompactArena;
 }
 
+/// The generated parser. It moves the parsed properties into \p props.
+int yyparse (void *scanner,Properties4CXX::Properties *props);
+
 #include "Properties4CXX/Property.h"
+#include "Properties4CXX/StringInterner.h"
 
 #if !defined PROPERTIES4CXX_EXPORT
 #define PROPERTIES4CXX_EXPORT
@@ -121,6 +141,21 @@ public:
 
 };
 
+/** \brief Exception thrown when writing a configuration to the output fails
+ *
+ */
+class PROPERTIES4CXX_PUBLIC
+ ExceptionConfigWriteError: public ExceptionBase {
+public:
+
+	ExceptionConfigWriteError(char const *descr)
+	  :ExceptionBase{descr}
+			{}
+
+	virtual ~ExceptionConfigWriteError ();
+
+};
+
 /** \brief Exception thrown when an internally managed input file stream cannot open the configuration file.
  *
  */
@@ -166,6 +201,243 @@ public:
 
 };
 
+/** \brief A property refers to itself directly or indirectly via references \${...}
+ *
+ * \see Properties::getInterpolatedValue()
+ */
+class PROPERTIES4CXX_PUBLIC
+ ExceptionInterpolationCycle: public ExceptionBase {
+public:
+
+	ExceptionInterpolationCycle(char const *descr)
+	  :ExceptionBase{descr}
+			{}
+
+	virtual ~ExceptionInterpolationCycle ();
+
+};
+
+/** \brief A frozen configuration is modified
+ *
+ * \see Properties::freeze()
+ */
+class PROPERTIES4CXX_PUBLIC
+ ExceptionPropertiesFrozen: public ExceptionBase {
+public:
+
+	ExceptionPropertiesFrozen(char const *descr)
+	  :ExceptionBase{descr}
+			{}
+
+	virtual ~ExceptionPropertiesFrozen ();
+
+};
+
+/** \brief Description of a single change of a configuration which is reported to subscribers
+ *
+ * \see Properties::subscribe()
+ */
+struct PROPERTIES4CXX_PUBLIC
+PropertyChange {
+
+	enum ChangeTypeEnum {
+		Added,
+		Removed,
+		Modified
+	};
+
+	/// What happened to the property
+	ChangeTypeEnum changeType;
+
+	/** \brief Path of the changed property.
+	 *
+	 * The path consists of the names of the enclosing structures and the property name, separated by dots, e.g. "db.primary.port".
+	 * When a complete structure was added or removed only the path of the structure is reported, not the paths of the
+	 * properties inside.
+	 */
+	std::string propertyPath;
+};
+
+/// List of changes which is passed to a subscriber
+typedef std::vector<PropertyChange> PropertyChangeList;
+
+/** \brief Replacement of the value of a single property in a configuration file
+ *
+ * \see Properties::applyPatches()
+ */
+struct PROPERTIES4CXX_PUBLIC
+PropertyPatch {
+
+	/// Path of the property like \ref PropertyChange::propertyPath, e.g. "db.primary.port"
+	std::string propertyPath;
+
+	/** \brief New value text
+	 *
+	 * When \ref quoted is false the text is written verbatim. Thus it can be any value which the parser accepts,
+	 * e.g. a number, a boolean, an identifier, or a list.
+	 */
+	std::string value;
+
+	/// Write \ref value as quoted string. Special characters are escaped.
+	bool quoted = false;
+};
+
+/// List of value replacements for \ref Properties::applyPatches()
+typedef std::vector<PropertyPatch> PropertyPatchList;
+
+/** \brief Statistics of the last load of a configuration
+ *
+ * The statistics are only collected when the library was configured with --enable-parse-stats,
+ * and when they were requested with \ref Properties::setCollectParseStats().
+ * Otherwise all values are 0. \see Properties::isParseStatsAvailable()
+ *
+ * When the input was parsed in parallel, or by several temporary parsers, the times of the parts are added.
+ * Then they can exceed the elapsed time.
+ */
+struct PROPERTIES4CXX_PUBLIC
+ParseStats {
+
+	/// Token types counted in \ref tokens
+	enum TokenTypeEnum {
+		Identifier,
+		QuotedString,
+		Integer,
+		Double,
+		Bool,
+		BracketOpen,
+		BracketClose,
+		Comma,
+		Assign,
+		EndOfLine,
+		NumTokenTypes
+	};
+
+	/// Bytes read from the input
+	uint64_t bytesRead = 0;
+	/// Time spent reading the input in nanoseconds
+	uint64_t ioNanoseconds = 0;
+	/// Time spent in the scanner in nanoseconds, without reading the input
+	uint64_t scanNanoseconds = 0;
+	/// Time spent in the parser and its actions in nanoseconds, without scanning and reading the input
+	uint64_t parseNanoseconds = 0;
+	/// Time spent after parsing in nanoseconds, i.e. merging parts, applying overrides, and indexing the source
+	uint64_t buildNanoseconds = 0;
+	/// Number of tokens by type. The index is a \ref TokenTypeEnum value
+	uint64_t tokens[NumTokenTypes] = {};
+	/// Properties created by the parser including structures
+	uint64_t properties = 0;
+	/// Structures created by the parser
+	uint64_t structs = 0;
+	/// Maximum nesting depth of structures
+	int maxStructDepth = 0;
+	/// Heap objects allocated by the scanner and the parser: token values, properties, and property containers.
+	/// Allocations within strings and maps are not included.
+	uint64_t allocations = 0;
+	/// Growth of the heap during the load in bytes. Allocations by other threads are included. 0 when the C library cannot report it.
+	int64_t heapBytes = 0;
+	/// Number of parse errors
+	uint64_t errors = 0;
+
+	/// \brief Add the statistics of a part of the input to these
+	void merge (ParseStats const &other) {
+		bytesRead += other.bytesRead;
+		ioNanoseconds += other.ioNanoseconds;
+		scanNanoseconds += other.scanNanoseconds;
+		parseNanoseconds += other.parseNanoseconds;
+		buildNanoseconds += other.buildNanoseconds;
+		for (int i = 0; i < NumTokenTypes; i++) {
+			tokens[i] += other.tokens[i];
+		}
+		properties += other.properties;
+		structs += other.structs;
+		if (other.maxStructDepth > maxStructDepth) {
+			maxStructDepth = other.maxStructDepth;
+		}
+		allocations += other.allocations;
+		errors += other.errors;
+	}
+};
+
+/** \brief Access counters of one name or path which was looked up
+ *
+ * \see Properties::getAccessProfile()
+ */
+struct PROPERTIES4CXX_PUBLIC
+PropertyAccessStats {
+
+	/// Number of buckets of \ref latencyHistogram
+	static constexpr int numLatencyBuckets = 32;
+
+	/// Name or path which was looked up
+	std::string key;
+	/// Lookups which found the property
+	uint64_t hits = 0;
+	/// Lookups which did not find the property
+	uint64_t misses = 0;
+	/// Misses of \ref Properties::getPropertyValue which returned the default value. They are included in \ref misses.
+	uint64_t defaulted = 0;
+	/// Sum of the latencies of all lookups in nanoseconds
+	uint64_t totalNanoseconds = 0;
+	/** \brief Latencies of the lookups
+	 *
+	 * Bucket 0 counts lookups below 1 ns. Bucket i counts latencies from 2^(i-1) ns to below 2^i ns.
+	 * The last bucket counts all longer lookups.
+	 */
+	uint64_t latencyHistogram[numLatencyBuckets] = {};
+};
+
+/// Access counters of all looked up names and paths, most looked up first. \see Properties::getAccessProfile()
+typedef std::vector<PropertyAccessStats> PropertyAccessProfile;
+
+/** \brief Memory footprint of a configuration in bytes by category
+ *
+ * \see Properties::memoryUsage()
+ *
+ * Strings are counted with their capacity when they are stored on the heap. Short strings which are stored
+ * within the string object do not count separately.
+ * Node and control block sizes are measured with the standard library in use. Overhead of the heap itself is not included.
+ */
+struct PROPERTIES4CXX_PUBLIC
+MemoryUsage {
+	/// Property names. The keys of the property maps refer to them
+	size_t names = 0;
+	/// Value strings of scalar properties, and the strings of value lists
+	size_t values = 0;
+	/// String representations of lists and structures which were materialized on demand
+	size_t lazyStrings = 0;
+	/// Cached values with resolved references. \see Properties::getInterpolatedValue()
+	size_t interpolatedStrings = 0;
+	/// The property objects
+	size_t properties = 0;
+	/// The containers of the properties of structures, and the property maps of all levels
+	size_t structContainers = 0;
+	/// Nodes of the property maps
+	size_t mapNodes = 0;
+	/// Control blocks of the shared pointers to the properties
+	size_t controlBlocks = 0;
+	/// Nodes of value lists
+	size_t listNodes = 0;
+
+	/// \brief Return the sum of all categories
+	size_t total () const {
+		return names + values + lazyStrings + interpolatedStrings + properties + structContainers +
+				mapNodes + controlBlocks + listNodes;
+	}
+
+	/// \brief Add the usage of another configuration or structure to this
+	void merge (MemoryUsage const &other) {
+		names += other.names;
+		values += other.values;
+		lazyStrings += other.lazyStrings;
+		interpolatedStrings += other.interpolatedStrings;
+		properties += other.properties;
+		structContainers += other.structContainers;
+		mapNodes += other.mapNodes;
+		controlBlocks += other.controlBlocks;
+		listNodes += other.listNodes;
+	}
+};
+
 /** \brief Properties reader. Inspired from Java Properties
  *
  * Properties reader. This class implements a properties reader which is enhanced to the very bare-bones Java
@@ -269,6 +541,26 @@ public:
  *
  * Any other escaped character is taken over literally. A sequence "\\x" will become "x". The '\\' character is swallowed.
  *
+ * Include files
+ * -------------------
+ *
+ * A line
+ *
+ *     include "shared/database.properties"
+ *
+ * inserts the properties of another file on the current structure level. A relative file name is resolved
+ * against the directory of the including file, or the current directory when the configuration is read from a stream.
+ *
+ * Included files are parsed once, and cached process wide by their canonical path and a fingerprint of their text.
+ * A cached file is only read again when its size or modification time changed.
+ * All configurations which include the same unchanged file share its property objects instead of copying them.
+ * The shared properties must therefore not be modified in place.
+ * Cached files which no configuration uses any more are released when another file is cached.
+ * \ref clearIncludeCache() releases all cached files.
+ *
+ * Configurations with include directives are always reloaded completely, even with \ref setIncrementalReload(),
+ * and cannot be patched with \ref applyPatches().
+ *
  * Numeric locale
  * -------------------
  *
@@ -285,10 +577,161 @@ public:
 	// A bunch of useful type definitions to avoid writing the templates again and again.
 	typedef std::shared_ptr<Property> PropertyPtr;
 	typedef std::pair<std::string, PropertyPtr> PropertyPair;
-	typedef std::map<std::string, PropertyPtr> PropertyMap;
+
+	/** \brief Map of the properties of one structure level by name
+	 *
+	 * The map refers to the name within each property. Thus the name is stored once.
+	 * A property is always inserted under its own name. Therefore an entry cannot refer to a released name.
+	 *
+	 * Iteration yields entries with the name as member \p first (std::string const &), and the property as member \p second
+	 * like std::map. The entries are ordered by name. Lookups with std::string or char const* do not copy the name.
+	 * The iterators are bidirectional, and dereference to references to the entries.
+	 *
+	 * \note This is an incompatible change of the API. PropertyMap was std::map<std::string,PropertyPtr> before.
+	 * The differences are:
+	 * - There is no operator[], no emplace(), and no non-const \p at(). A name cannot exist without its property.
+	 * - The entries cannot be modified via iterators. \ref assign() replaces a property.
+	 * - \ref insert(PropertyPair const&) only accepts a pair whose name is the name of the property.
+	 */
+	class PROPERTIES4CXX_PUBLIC
+	PropertyMap {
+	public:
+
+		/// Entry of the map
+		struct value_type {
+			/// Name of the property. It refers to the name within \ref second.
+			std::string const &first;
+			/// The property
+			PropertyPtr second;
+		};
+
+		/// Orders the entries by the names of their properties. Plain names can be compared, too.
+		struct NameLess {
+			typedef void is_transparent;
+
+			bool operator () (value_type const &a,value_type const &b) const {
+				return a.first < b.first;
+			}
+			bool operator () (value_type const &a,std::string_view b) const {
+				return std::string_view(a.first) < b;
+			}
+			bool operator () (std::string_view a,value_type const &b) const {
+				return a < std::string_view(b.first);
+			}
+		};
+
+		/// The internal container
+		typedef std::pmr::set<value_type,NameLess> Index;
+
+		/// Entries cannot be modified in place because the name of the property is the key.
+		typedef Index::const_iterator const_iterator;
+		typedef const_iterator iterator;
+		typedef Index::size_type size_type;
+		typedef Index::allocator_type allocator_type;
+
+		explicit PropertyMap (allocator_type const &allocator = allocator_type())
+		:index{allocator}
+		{ }
+
+		PropertyMap (PropertyMap const &other,allocator_type const &allocator)
+		:index{other.index,allocator}
+		{ }
+
+		PropertyMap (PropertyMap const &) = default;
+		PropertyMap (PropertyMap &&) = default;
+
+		// The entries cannot be assigned because the name is a reference. Thus the nodes are always created anew.
+		PropertyMap &operator = (PropertyMap const &other);
+		PropertyMap &operator = (PropertyMap &&other);
+
+		const_iterator begin () const {
+			return index.cbegin();
+		}
+		const_iterator end () const {
+			return index.cend();
+		}
+		const_iterator cbegin () const {
+			return index.cbegin();
+		}
+		const_iterator cend () const {
+			return index.cend();
+		}
+
+		size_type size () const {
+			return index.size();
+		}
+		bool empty () const {
+			return index.empty();
+		}
+
+		const_iterator find (std::string_view name) const {
+			return index.find(name);
+		}
+		size_type count (std::string_view name) const {
+			return index.count(name);
+		}
+
+		/** \brief Return the property \p name
+		 *
+		 * @throws std::out_of_range when there is no property \p name
+		 */
+		PropertyPtr const &at (std::string_view name) const;
+
+		/** \brief Insert \p property under its name unless a property with the same name exists
+		 *
+		 * @return Iterator to the entry with the name, and true when \p property was inserted
+		 */
+		std::pair<const_iterator,bool> insert (PropertyPtr const &property);
+
+		/** \brief Insert the property of \p entry under its name. \see insert(PropertyPtr const&)
+		 *
+		 * @throws std::invalid_argument when the name in \p entry is not the name of the property
+		 */
+		std::pair<const_iterator,bool> insert (PropertyPair const &entry);
+
+		/// \brief Insert the property of \p entry, e.g. of another map, under its name. \see insert(PropertyPtr const&)
+		std::pair<const_iterator,bool> insert (value_type const &entry) {
+			return insert(entry.second);
+		}
+
+		/// \brief Insert \p property, or replace the property with the same name
+		void assign (PropertyPtr const &property);
+
+		const_iterator erase (const_iterator pos) {
+			return index.erase(pos);
+		}
+
+		/// \brief Remove the property \p name, and return the number of removed properties
+		size_type erase (std::string_view name);
+
+		void clear () {
+			index.clear();
+		}
+
+	private:
+
+		Index index;
+	};
+
 	typedef PropertyMap::const_iterator PropertyCIterator;
 	typedef PropertyMap::iterator PropertyIterator;
 
+	/// Callback to notify a subscriber about changes of the properties it subscribed to. \see subscribe()
+	typedef std::function<void (Properties const &properties,PropertyChangeList const &changes)> ChangeCallback;
+	/// Handle of a subscription. \see subscribe() and \ref unsubscribe()
+	typedef unsigned long SubscriptionId;
+	/** \brief Executor for asynchronous reading of the configuration. \see readConfigurationAsync(Executor const &executor)
+	 *
+	 * The executor must run the passed task exactly once, in any thread it likes.
+	 */
+	typedef std::function<void (std::function<void ()> const &task)> Executor;
+	/** \brief Maps the name of an environment variable to a property path. \see setEnvironmentOverrides()
+	 *
+	 * The name is passed without the prefix. The path components are separated by '.'.
+	 * An empty path ignores the variable.
+	 */
+	typedef std::function<std::string (std::string const &variableName)> EnvironmentNameMapper;
+
 
 	/**
 	 * Constructor. Before reading a configuration you must either set the configuration file name,
@@ -296,15 +739,43 @@ public:
 	 */
     Properties ();
 
+    /** \brief Constructor defining the memory resource of the property tree
+     *
+     * These parts of all structure levels which are created by \ref readConfiguration are allocated from \p memoryResource:
+     * - The property objects
+     * - The property maps and their nodes
+     * - The control blocks of the shared pointers to the properties
+     * - The shared name strings, i.e. the std::string objects with their reference counters
+     *
+     * Other parts are still allocated from the global heap, independent of \p memoryResource:
+     * - The characters of names and values which do not fit into the small string buffer of std::string
+     * - The nodes and strings of value lists (\ref PropertyValueList)
+     * - The Properties objects of nested structures
+     * - The string representations of lists and structures, and interpolated values
+     *
+     * The API returns these as std::string and std::list with the standard allocator.
+     * They cannot use the memory resource without an incompatible change of the interface.
+     * Therefore a memory resource does not capture all allocations of a configuration, and it cannot be released in one piece
+     * while the global heap is not used.
+     *
+     * The memory resource must outlive this object and all properties which were taken from it.
+     * With parallel parsing (\ref setParallelParsing) and with \ref loadDirectory it is used by several threads concurrently.
+     * Then it must be thread-safe like std::pmr::synchronized_pool_resource.
+     *
+     * @param memoryResource Memory resource. nullptr selects std::pmr::get_default_resource().
+     */
+    explicit Properties (std::pmr::memory_resource *memoryResource);
+
     /** \brief Constructor defining the input file name
      * Constructor defining the input file name.
      * The file will be opened not earlier when you call \ref readConfiguration
      *
      * @param configFileName: Name of the configuration file. Can either be an absolute or relative path. The path
      * specification must comply with the OS conventions
+     * @param memoryResource Memory resource of the property tree. \see Properties(std::pmr::memory_resource *memoryResource)
      *
      */
-    Properties (char const *configFileName);
+    Properties (char const *configFileName,std::pmr::memory_resource *memoryResource = nullptr);
 
     /** \brief Constructor defining the input file name
      * Constructor defining the input file name.
@@ -312,17 +783,38 @@ public:
      *
      * @param configFileName Name of the configuration file. Can either be an absolute or relative path. The path
      * specification must comply with the OS conventions.
+     * @param memoryResource Memory resource of the property tree. \see Properties(std::pmr::memory_resource *memoryResource)
      *
      */
-    Properties (std::string const &configFileName);
+    Properties (std::string const &configFileName,std::pmr::memory_resource *memoryResource = nullptr);
 
     /** \brief Constructor defining the input stream
      *
      * @param inputStream Pointer to an input stream (typically an istringstream, i.e. reading out of a memory buffer.
+     * @param memoryResource Memory resource of the property tree. \see Properties(std::pmr::memory_resource *memoryResource)
      * \see setInputStream
      *
      */
-    Properties (std::istream *inputStream);
+    Properties (std::istream *inputStream,std::pmr::memory_resource *memoryResource = nullptr);
+
+    /** \brief Copy constructor. The copy shares the property tree with \p other
+     *
+     * The copy takes constant time and memory regardless of the size of the configuration.
+     * Each structure level is copied when it is modified in one of the configurations for the first time.
+     * Modifications with \ref setProperty() copy only the structures on the path to the modified property.
+     * Thus many variants of one base configuration cost little more than their differences.
+     *
+     * The copy takes the configuration file name or the external input stream, the memory resource, the string interner,
+     * and the settings of reading from \p other. Subscriptions, the access profiler, and the parse statistics are not copied.
+     *
+     * Properties are shared between the configurations. Do not modify them in place,
+     * e.g. with \ref PropertyStruct::addProperty() or \ref PropertyList::appendString().
+     *
+     * @param other Configuration to be copied
+     */
+    Properties (Properties const &other);
+
+    Properties &operator = (Properties const &) = delete;
 
     /**
      * The destructor does not care for the inputstream set either by \ref setInputStream or by \ref Properties(std::istream *inputStream)
@@ -412,10 +904,20 @@ public:
      *
      * \see getStructLevel for more information about sub-structures and structure levels.
      *
+     * Properties which are shared with other configurations are not modified. They are replaced by copies on the new level.
+     *
      * @param structLevel
      */
     void setStructLevel (int structLevel);
 
+    /** \brief Move the source offsets of all included properties by \p delta bytes
+     *
+     * \see Property::shiftSourceOffset
+     *
+     * @param delta Difference of the new and the old source offset
+     */
+    void shiftSourceOffset (ptrdiff_t delta);
+
     /** \brief Read the properties from a file or an input stream
      *
      * Read the properties from a file or an input stream
@@ -434,6 +936,292 @@ public:
      */
     void readConfiguration();
 
+    /** \brief Read only the text which was appended to the input since the last read, and apply it as overrides
+     *
+     * This is intended for append-only override files to which tools keep appending lines like "key = value".
+     *
+     * \ref readConfiguration and readAppended remember the byte offset and line number of the last line start
+     * on the top level of the input, i.e. outside of structures. readAppended reads the input from this offset
+     * and parses the complete top-level lines which were appended since.
+     * An incomplete last line, or a structure which is not closed yet, is left for the next call.
+     *
+     * Appended properties override existing properties with the same name. When the same property was appended
+     * more than once the last one wins.
+     * Subscribers are notified about added and modified properties.
+     *
+     * When there was no successful read before, or when the input is shorter than the remembered offset,
+     * i.e. it was truncated or replaced, the configuration is reloaded completely with \ref readConfiguration.
+     *
+     * The input must be seekable. Configuration files are re-opened for every call.
+     * An external input stream is positioned to the remembered offset relative to its position at the last
+     * \ref readConfiguration.
+     *
+     * @throws ExceptionConfigFileOpenError
+     * @throws ExceptionConfigReadError
+     * @throws ExceptionPropertyDuplicate when an appended structure contains a duplicate property.
+     */
+    void readAppended();
+
+    /** \brief Read the properties from a file or an input stream in the background
+     *
+     * Runs \ref readConfiguration in a thread of an internal thread pool, and returns immediately.
+     * Thus the caller can do other initialization while the configuration is being read and parsed.
+     *
+     * The task refers to this object. Thus the object must outlive the returned future, i.e. it must not be destroyed,
+     * moved, or accessed until the future is ready. Destroying it earlier is undefined behavior.
+     * Exceptions thrown by \ref readConfiguration are re-thrown by std::future::get().
+     *
+     * @return Future which becomes ready when the configuration is read.
+     * @throws ExceptionConfigReadError when an asynchronous read of this object is still in progress
+     */
+    std::future<void> readConfigurationAsync();
+
+    /** \brief Read the properties from a file or an input stream with a caller provided executor
+     *
+     * Like \ref readConfigurationAsync(), but \ref readConfiguration runs in the executor provided by the caller.
+     *
+     * The same lifetime requirements apply.
+     *
+     * @param executor Function which runs the reading task, e.g. by posting it into the caller's thread pool.
+     * @return Future which becomes ready when the configuration is read.
+     * @throws ExceptionConfigReadError when an asynchronous read of this object is still in progress
+     */
+    std::future<void> readConfigurationAsync(Executor const &executor);
+
+    /** \brief Read all configuration files in a directory in parallel and merge them into this configuration
+     *
+     * This is intended for configurations which are split into many small files in a "conf.d" style directory.
+     *
+     * All regular files in the directory are read, except hidden files which names start with '.'.
+     * When \p fileNameSuffix is not empty only files which names end with the suffix are read.
+     *
+     * Each file is read with an own scanner and parser in the threads of an internal thread pool.
+     * The results are merged into this configuration in the alphabetical order of the file names,
+     * independent of the order in which the files were completed.
+     * Property names on the top level must be unique across all files.
+     *
+     * As with \ref readConfiguration() the previous content of this configuration is replaced,
+     * and subscribers are notified about the changes.
+     *
+     * @param directoryName Name of the directory
+     * @param fileNameSuffix Only read files which names end with this suffix, e.g. ".conf". Empty string reads all files.
+     * @param maxThreads Maximum number of threads reading files in parallel. 0 means one thread per hardware thread.
+     * @throws ExceptionConfigFileOpenError when the directory or a file cannot be opened
+     * @throws ExceptionPropertyDuplicate when a property is defined in more than one file.
+     *   The message contains the names of both files.
+     */
+    void loadDirectory (std::string const &directoryName,std::string const &fileNameSuffix = "",unsigned maxThreads = 0);
+
+    /** \brief Enable or disable parallel parsing of large configurations
+     *
+     * When more than one thread is allowed \ref readConfiguration reads the complete input into memory first.
+     * If the input is large enough it is split into chunks at line ends which are on the top level, i.e. outside of quoted strings
+     * and structures. The chunks are parsed in parallel with independent scanners in the threads of an internal thread pool,
+     * and the results are merged in the order of the chunks.
+     * Line numbers in error messages are the line numbers in the complete input.
+     *
+     * Inputs smaller than \ref minParallelParseSize are parsed sequentially from memory.
+     *
+     * @param maxThreads Maximum number of threads parsing in parallel. 0 or 1 disables parallel parsing, which is the default.
+     */
+    void setParseThreads (unsigned maxThreads) {
+    	parseThreads = maxThreads;
+    }
+
+    /** \brief Return the maximum number of threads parsing in parallel
+     *
+     * \see setParseThreads()
+     *
+     * @return Maximum number of threads. 0 or 1 when parallel parsing is disabled.
+     */
+    unsigned getParseThreads () const {
+    	return parseThreads;
+    }
+
+    /// Minimum size of a chunk of the input for parallel parsing. \see setParseThreads()
+    static constexpr size_t minParallelParseSize = 256 * 1024;
+
+    /** \brief Enable or disable incremental reloading of the configuration
+     *
+     * When enabled \ref readConfiguration reads the complete input into memory, and remembers
+     * the byte range and a fingerprint of the text of each top-level entry, i.e. each line on the top level including
+     * the complete text of structures which start on this line.
+     *
+     * On the next \ref readConfiguration the new text is split into top-level entries again.
+     * Entries with unchanged text keep their properties. Only the changed entries are parsed again,
+     * and only the properties of changed or deleted entries are replaced or removed.
+     * Thus reloading a large configuration after a small edit costs reading and fingerprinting the input,
+     * but parsing is proportional to the size of the edit.
+     *
+     * The result, including the reported changes to subscribers, is the same as with a complete reload.
+     * When a changed entry contains an error, or creates a duplicate, the complete input is parsed again
+     * to report the error like a complete reload.
+     *
+     * Any change of the configuration via \ref addProperty, \ref deletePropery, \ref getPropertyMap,
+     * or a new input via \ref setFileName or \ref setInputStream discards the remembered entries.
+     * The next reload is then a complete one.
+     *
+     * @param incremental true enables incremental reloading. It is disabled by default.
+     */
+    void setIncrementalReload (bool incremental) {
+    	incrementalReload = incremental;
+    	sourceIndexValid = false;
+    }
+
+    /** \brief Return if incremental reloading is enabled
+     *
+     * \see setIncrementalReload()
+     *
+     * @return true when incremental reloading is enabled
+     */
+    bool getIncrementalReload () const {
+    	return incrementalReload;
+    }
+
+    /** \brief Enable or disable profiling of the accesses to the properties
+     *
+     * When enabled \ref searchProperty, \ref searchPropertyPath, and \ref getPropertyValue count
+     * the hits, misses, and returned default values per name or path, and record the latency of each lookup.
+     * Each thread counts into its own counters. They are merged by \ref getAccessProfile().
+     * Lookups in sub-structures are only counted when they start at this configuration.
+     *
+     * Disabling discards the counters. When disabled a lookup costs one additional test.
+     * Do not enable or disable profiling while other threads access the configuration.
+     *
+     * @param enable true enables profiling. It is disabled by default.
+     */
+    void setAccessProfiling (bool enable);
+
+    /// \brief Return if accesses are profiled. \see setAccessProfiling()
+    bool getAccessProfiling () const {
+    	return bool(accessProfiler);
+    }
+
+    /** \brief Return the access counters of all threads
+     *
+     * @return Counters per looked up name or path, most looked up first. Empty when profiling is disabled.
+     */
+    PropertyAccessProfile getAccessProfile () const;
+
+    /** \brief Return the paths of the properties which were never found by a lookup since profiling was enabled or reset
+     *
+     * A property counts as accessed when its path, or the path of an enclosing structure, was found.
+     * Structures themselves are not reported, only the properties in them.
+     *
+     * @return Paths of the properties which were not accessed, in the order of the paths. Empty when profiling is disabled.
+     */
+    std::vector<std::string> getUnaccessedProperties () const;
+
+    /// \brief Clear the access counters of all threads. \see setAccessProfiling()
+    void resetAccessProfile ();
+
+    /** \brief Enable or disable the collection of statistics of each load
+     *
+     * The statistics of the last \ref readConfiguration, \ref readAppended, or \ref loadDirectory
+     * are returned by \ref getParseStats().
+     * Collecting costs two clock readings per token. Without --enable-parse-stats the collection is compiled out,
+     * and this setting has no effect.
+     *
+     * @param collect true enables the collection. It is disabled by default.
+     */
+    void setCollectParseStats (bool collect) {
+    	collectParseStats = collect;
+    }
+
+    /// \brief Return if statistics are collected. \see setCollectParseStats()
+    bool getCollectParseStats () const {
+    	return collectParseStats;
+    }
+
+    /// \brief Return the statistics of the last load. \see setCollectParseStats()
+    ParseStats const &getParseStats () const {
+    	return parseStats;
+    }
+
+    /// \brief Return if the library was configured with --enable-parse-stats. \see setCollectParseStats()
+    static bool isParseStatsAvailable ();
+
+    /** \brief Return the memory footprint of the configuration by category
+     *
+     * Structures are included recursively. The object of this configuration itself is not included.
+     * Properties which are shared with other configurations, e.g. by includes, are counted at each place where they occur.
+     * Shared names and values are counted once. The table of the \ref StringInterner is not included.
+     *
+     * The tree is traversed on each call. Do not call it while the configuration is modified.
+     *
+     * @return Bytes by category
+     */
+    MemoryUsage memoryUsage () const;
+
+    /** \brief Set the table which interns the names, and optionally the values, of the properties which are read
+     *
+     * Pass the same table to several configurations to share the names among them.
+     * It takes effect with the next read of the configuration.
+     *
+     * @param stringInterner Table of interned strings. nullptr creates a table for this configuration on the next read.
+     */
+    void setStringInterner (std::shared_ptr<StringInterner> stringInterner) {
+    	this->stringInterner = std::move(stringInterner);
+    }
+
+    /** \brief Return the table which interns the names of the properties which are read
+     *
+     * The table is created on the first call when none was set by \ref setStringInterner().
+     *
+     * @return The table of interned strings
+     */
+    std::shared_ptr<StringInterner> const &getStringInterner ();
+
+    /** \brief Intern the values of scalar properties which are read, too
+     *
+     * Equal values are stored once. This saves memory when many values repeat, at the cost of a table lookup for each value.
+     * Values of lists are not interned.
+     * It takes effect with the next read of the configuration.
+     *
+     * @param internValues Intern the values
+     */
+    void setInternValues (bool internValues) {
+    	this->internValues = internValues;
+    }
+
+    /// \brief Return if the values of scalar properties are interned. \see setInternValues()
+    bool getInternValues () const {
+    	return internValues;
+    }
+
+    /** \brief Override properties with environment variables
+     *
+     * The environment is scanned once by this call. Each variable whose name starts with \p prefix
+     * is mapped to a property path by \p nameMapper, and its value is typed like a value in the configuration file
+     * by the rules of the scanner: Integers, doubles, booleans, and lists are recognized. Any other value is a string.
+     *
+     * The overrides are applied by \ref readConfiguration, \ref readAppended, and \ref loadDirectory
+     * while the configuration is built. Only the overridden paths are visited.
+     * A property on the path which has the same value is kept as it is.
+     * Missing properties and structures are created. A structure is never replaced by a value,
+     * and a value is never replaced by a structure.
+     * Subscribers see the overridden values only.
+     *
+     * Call the method again to pick up changes of the environment. The overrides take effect with the next load.
+     *
+     * @param prefix Prefix of the names of the variables, e.g. "APP_"
+     * @param nameMapper Maps the variable name without the prefix to the property path
+     */
+    void setEnvironmentOverrides (std::string const &prefix,EnvironmentNameMapper const &nameMapper = defaultEnvironmentNameMapper);
+
+    /// \brief Stop overriding properties with environment variables. It takes effect with the next load. \see setEnvironmentOverrides()
+    void clearEnvironmentOverrides ();
+
+    /** \brief Default mapping of environment variable names to property paths
+     *
+     * The name is converted to lower case, and each "__" separates two path components.
+     * E.g. "DB__PORT" is mapped to "db.port".
+     *
+     * @param variableName Name of the variable without the prefix
+     * @return Property path
+     */
+    static std::string defaultEnvironmentNameMapper (std::string const &variableName);
+
     /** \brief Search for a property identified by its name
      *
      * @param propertyName Name by which the property is searched.
@@ -442,6 +1230,59 @@ public:
      */
     Property const *searchProperty (std::string const &propertyName) const;
 
+    /** \brief Search for a property identified by its path
+     *
+     * The path consists of the names of the enclosing structures and the property name, separated by dots,
+     * like \ref PropertyChange::propertyPath. Because property names can contain dots themselves
+     * a name on the current level is matched first, and then the structures whose names are a prefix of the path.
+     *
+     * @param propertyPath Path of the property, e.g. "db.primary.port"
+     * @return Pointer to the property
+     * @throws ExceptionPropertyNotFound when the property does not exist.
+     */
+    Property const *searchPropertyPath (std::string const &propertyPath) const;
+
+    /** \brief Search for a property identified by its path without throwing an exception when it does not exist
+     *
+     * \see searchPropertyPath()
+     *
+     * @param propertyPath Path of the property, e.g. "db.primary.port"
+     * @return Pointer to the property, or nullptr when it does not exist
+     */
+    Property const *findPropertyPath (std::string const &propertyPath) const;
+
+    /** \brief Return the string value of a property with references to other properties and environment variables resolved
+     *
+     * A reference "${path}" is replaced by the interpolated value of the property with the path \p path in this configuration,
+     * e.g. "${db.host}". When no such property exists the environment variable with this name is used.
+     * "${env:NAME}" always refers to the environment variable NAME. "$${" is replaced by a literal "${".
+     * References can only be written in quoted strings because '{' and '}' are not allowed in un-quoted values.
+     *
+     *     host = example.com
+     *     port = 8080
+     *     url  = "http://${host}:${port}/"
+     *
+     * Only this method interpolates. \ref getPropertyValue(), \ref Property::getStringValue() and all other accessors
+     * return the value as written, and \ref freeze() does not resolve references either.
+     *
+     * The value is resolved on the first access, and cached in this configuration by the property and by \p propertyPath.
+     * Further accesses with the same path cost only a lookup in the cache.
+     * The cache is invalidated when the configuration is read again, or modified via \ref addProperty, \ref deletePropery,
+     * \ref includeProperties, or \ref getPropertyMap.
+     * It is not invalidated when a property within a structure is modified in place.
+     *
+     * Accesses from multiple threads are safe. Each configuration has its own cache. Thus properties which are shared
+     * with other configurations, e.g. via include files or copies, may resolve to different values in each one.
+     * The returned reference remains valid until the configuration is modified.
+     *
+     * @param propertyPath Path of the property, e.g. "service.url"
+     * @return Value with all references resolved
+     * @throws ExceptionPropertyNotFound when the property or a referenced property or environment variable does not exist
+     * @throws ExceptionWrongPropertyType when the property or a referenced property is a structure
+     * @throws ExceptionInterpolationCycle when a property refers to itself directly or indirectly
+     */
+    std::string const &getInterpolatedValue (std::string const &propertyPath) const;
+
     /** \brief Return the Iterator of the first property
      *
      * If there is no property the returned iterator is equal to \ref getListEnd()
@@ -452,7 +1293,7 @@ public:
      * @return Iterator to the first property
      */
     PropertyCIterator getFirstProperty () const {
-    	return propertyMap.cbegin();
+    	return propertyMap->cbegin();
     }
 
     /** \brief Return the list end Iterator. This iterator points *past* the actual list.
@@ -463,7 +1304,7 @@ public:
      * @return
      */
     PropertyCIterator getListEnd () const {
-    	return propertyMap.cend();
+    	return propertyMap->cend();
     }
 
     // Some convenience functions to quickly access property values in one level with default values when not found
@@ -529,7 +1370,7 @@ public:
      * @return Number of properties on this level of the configuration
      */
     PropertyMap::size_type numProperties() {
-    	return propertyMap.size();
+    	return propertyMap->size();
     }
 
     /** \brief Helper to extract the property from an iterator
@@ -547,7 +1388,8 @@ public:
     /** \brief Insert a new property into this level of the configuration.
      *
      * This methods inserts the property passed in newPropery into the container of this. this takes ownership of the propery passed.
-     * It must *not* be deleted by the caller, or it must not be declared as plain object in the code. It *must* be created with the operator new.
+     * It must *not* be deleted by the caller, or it must not be declared as plain object in the code. It *must* be created with the operator new,
+     * or with \ref Property::create().
      * The container of this will take care to delete the object when this is deleted or becomes invalid.
      * Properties must be unique by name on one structure level in the configuration.
      *
@@ -556,6 +1398,35 @@ public:
      */
     void addProperty (Property *newProperty);
 
+    /** \brief Insert all properties of another configuration into this level of the configuration
+     *
+     * The property objects are shared with \p other, not copied. Neither configuration must modify them in place afterwards.
+     * This is how included files are inserted.
+     *
+     * @param other Configuration whose properties are inserted.
+     * @throws ExceptionPropertyDuplicate when a property with the same name already exists on this structure level.
+     *  The properties of \p other which were inserted before remain.
+     */
+    void includeProperties (Properties const &other);
+
+    /** \brief Add or replace a property in a structure of the configuration
+     *
+     * The property with the name of \p newProperty is replaced in the structure \p structurePath, or it is added.
+     * Missing structures on the path are created.
+     *
+     * The structures on the path are copied, and the copies replace them. All other properties and structures remain shared.
+     * Thus copies of this configuration (\ref Properties(Properties const &other)) and properties which are held elsewhere
+     * are not affected.
+     *
+     * @param structurePath Names of the structures from the top level down to the structure which receives \p newProperty.
+     *  Empty for the top level.
+     * @param newProperty Pointer to the property. this takes ownership of the property.
+     *  It must be created with the operator new, or with \ref Property::create().
+     * @throws ExceptionWrongPropertyType when a property on the path exists but is no structure.
+     *  The configuration is not modified then.
+     */
+    void setProperty (std::vector<std::string> const &structurePath,Property *newProperty);
+
     /** \brief Delete a propery in the current level of the configuration.
      *
      * If the property does not exist nothing happens. No exception is thrown.
@@ -567,32 +1438,158 @@ public:
      */
     void deletePropery (std::string const &propertyName);
 
+    /** \brief Subscribe to changes of individual properties or sub-structures
+     *
+     * The callback is invoked when a property which matches \p pathPattern is added, removed, or modified,
+     * either by \ref readConfiguration, or by \ref addProperty, \ref setProperty or \ref deletePropery of this object.
+     *
+     * After \ref readConfiguration the old and new configuration are compared with help of the content fingerprints
+     * (\see getContentHash()). Unchanged sub-structures are skipped. All matching changes of one reload are passed
+     * in one call of the callback. Subscribers without matching changes are not called.
+     * As long as nobody subscribed \ref readConfiguration does not compare anything.
+     *
+     * The pattern is a path of property names separated by dots, e.g. "db.primary.port".
+     * A pattern matches a changed path when both are equal, or when one is a parent structure of the other.
+     * Thus the pattern "db" is notified about changes inside the structure "db", and about the removal of it.
+     * A trailing ".*" is allowed for readability, i.e. "cache.*" matches the same as "cache".
+     * The pattern "*" matches everything.
+     *
+     * Modifications of sub-structures via \ref PropertyStruct::addProperty() are not reported.
+     *
+     * @param pathPattern Pattern of the property paths of interest
+     * @param callback Function which is called with the list of matching changes
+     * @return Handle of the subscription for \ref unsubscribe()
+     */
+    SubscriptionId subscribe (std::string const &pathPattern,ChangeCallback const &callback);
+
+    /** \brief Remove a subscription
+     *
+     * If the subscription does not exist nothing happens.
+     *
+     * @param subscriptionId Handle returned by \ref subscribe()
+     */
+    void unsubscribe (SubscriptionId subscriptionId);
+
+    /** \brief Return the memory resource of the property tree
+     *
+     * Properties which are added by \ref addProperty should be created with \ref Property::create() from it.
+     *
+     * @return The memory resource. Never nullptr.
+     */
+    std::pmr::memory_resource *getMemoryResource() const {
+    	return memoryResource;
+    }
+
     /** \brief Return reference to the internal map of properties \ref Property
      *
      * This is a function for insiders to gain direct access to the internal map of properties.
-     * A lot harder to program but gives access to the full functionality of std::map.
+     * A lot harder to program but gives access to the functionality of \ref PropertyMap.
+     * \ref PropertyMap is not a std::map. See there for the differences.
      * Type checking ensures that you cannot really break anything seriously.
      *
      * Use it at your own peril.
      *
-     * @return Reference to the internal std::map \ref PropertyMap containing \ref Property
+     * The map and the properties in it are not shared with copies of this configuration or with included files any more.
+     * Properties which were shared are replaced by copies first. The properties within a structure are still shared,
+     * and copied when the structure is modified, e.g. with \ref PropertyStruct::addProperty().
+     * Therefore do not keep pointers to the properties beyond the modification.
+     *
+     * @return Reference to the internal map \ref PropertyMap containing \ref Property
+     * @throws ExceptionPropertiesFrozen when the configuration is frozen. \see freeze()
      */
     PropertyMap &getPropertyMap() {
-    	return propertyMap;
+    	checkNotFrozen("getPropertyMap");
+    	// The caller may modify the map. Thus the map does not match the configuration text any more.
+    	sourceIndexValid = false;
+    	invalidateInterpolation();
+    	makeEntriesExclusive();
+    	return *propertyMap;
     }
 
     /** \brief Return reference to the constant internal map of properties \ref Property
      *
      * This is a function for insiders to gain direct access to the internal map of properties.
-     * A lot harder to program but gives access to the full functionality of const std::map.
+     * A lot harder to program but gives access to the functionality of const \ref PropertyMap.
      * Type checking ensures that you cannot really break anything seriously.
      *
      * Use it at your own peril.
      *
-     * @return Reference to the constant internal std::map \ref PropertyMap containing \ref Property
+     * @return Reference to the constant internal map \ref PropertyMap containing \ref Property
      */
     PropertyMap const &getCPropertyMap() const{
-    	return propertyMap;
+    	return *propertyMap;
+    }
+
+    /** \brief Return the content fingerprint of this level of the configuration including all sub-structures
+     *
+     * The fingerprint is a 64-bit hash over the names, types and values of all properties on this level
+     * and recursively of all sub-structures.
+     * Two configurations or sub-structures with the same content have the same fingerprint, regardless
+     * of the structure level on which they reside, or if string values were quoted or not.
+     * Thus the fingerprint can be used for quick comparisons or as cache key without traversing the configuration.
+     *
+     * The fingerprint is maintained incrementally by \ref readConfiguration, \ref addProperty and \ref deletePropery.
+     * It is *not* updated when you modify the map directly via \ref getPropertyMap(), or when you modify a property
+     * in place after it was inserted (e.g. \ref PropertyList::appendString() or \ref PropertyStruct::addProperty()).
+     * In these cases call \ref updateContentHash() afterwards.
+     *
+     * @return 64-bit content fingerprint
+     */
+    uint64_t getContentHash () const {
+    	return contentHash;
+    }
+
+    /** \brief Re-calculate the content fingerprint of this level from the fingerprints of the contained properties
+     *
+     * Only required after the map was modified directly via \ref getPropertyMap(), or after a property was modified in place.
+     * \see getContentHash()
+     */
+    void updateContentHash ();
+
+    /** \brief Copy the property nodes of the configuration into one contiguous arena
+     *
+     * This compacts the property nodes only, not the complete configuration.
+     * The properties, the nodes of the property maps, the shared pointer control blocks, and the shared name objects
+     * of all structure levels are copied into a single arena which is allocated from the memory resource of this configuration.
+     * The size of the arena is measured with a dry run before. The copies drop the slack of the parser,
+     * e.g. cached string representations of lists and structures, and string capacity beyond the content.
+     *
+     * These parts are not in the arena. They remain on the global heap:
+     * - The characters of names and values which do not fit into the small string buffer of std::string
+     * - The value lists
+     * - The Properties objects of structures
+     *
+     * Content, source offsets, and the content fingerprint do not change. Subscribers are not notified.
+     * Pointers to properties which were taken before are not valid anymore unless they are shared pointers.
+     *
+     * The arena only holds the compacted copy. Later changes and reloads allocate from the former memory resource,
+     * which \ref getMemoryResource() still returns. The arena is freed when the configuration is deleted or compacted again,
+     * and the last of its properties was released. Call compact() again after reloading to drop the arena of the
+     * previous configuration.
+     */
+    void compact ();
+
+    /** \brief Make the configuration immutable, and optimize it for reading
+     *
+     * Each structure level gets a sorted contiguous index of the property names which replaces the map for lookups.
+     * The string representations of lists and structures are created now instead of on the first access.
+     * Afterwards reading does not write into the configuration or the properties.
+     * Thus any number of threads can read the frozen configuration concurrently without synchronization.
+     * Interpolated values (\ref getInterpolatedValue()) are still resolved and cached on demand under their own lock.
+     *
+     * All functions which modify the configuration throw \ref ExceptionPropertiesFrozen afterwards,
+     * including \ref readConfiguration and the non-constant \ref getPropertyMap().
+     * Structures are frozen with the configuration. Structures which are shared with other configurations, e.g. with unfrozen
+     * copies or included files, are copied first. Thus the other configurations can still be modified.
+     *
+     * A configuration cannot be thawed. Copies (\ref Properties(Properties const &other)) are not frozen, and share the
+     * frozen structures until they modify them. Subscriptions remain but are never notified.
+     */
+    void freeze ();
+
+    /// \brief Return if the configuration was frozen with \ref freeze()
+    bool isFrozen () const {
+    	return frozen;
     }
 
 
@@ -603,6 +1600,52 @@ public:
 	 */
 	std::ostream &writeOut (std::ostream &os) const;
 
+	/** \brief Save the configuration atomically into a file
+	 *
+	 * The configuration is formatted into memory, and written with one large write into a temporary file
+	 * in the same directory as \p fileName. The temporary file is synced to disk and renamed to \p fileName.
+	 * Finally the directory is synced.
+	 *
+	 * Readers of \p fileName see either the complete old or the complete new content, even when the process
+	 * or the system crashes while saving.
+	 * An existing file keeps its permissions.
+	 *
+	 * @param fileName Name of the configuration file
+	 * @param compact Write the compact format of \ref PropertiesWriter instead of the pretty format
+	 * @throws ExceptionConfigWriteError when the file cannot be written. The old file is unchanged then.
+	 */
+	void saveToFile (std::string const &fileName,bool compact = false) const;
+
+	/** \brief Replace values in the configuration file from which the configuration was read, and keep everything else
+	 *
+	 * The parser remembers the byte range of the value text of each property.
+	 * Only these ranges are replaced by the new values. Comments, blank lines, the order of the properties,
+	 * and the formatting of all other properties remain untouched.
+	 * The unchanged spans between the replaced values are copied from file to file, on Linux with copy_file_range(2)
+	 * which lets the kernel or the file system copy them without passing them through user space.
+	 *
+	 * The result is written into a temporary file which replaces \p fileName atomically like \ref saveToFile().
+	 * Before that the file is compared with a hash of the input which was read. Thus no outdated byte ranges are patched.
+	 *
+	 * The configuration in memory is not changed. Call \ref readConfiguration() to load the new values.
+	 * With \ref setIncrementalReload() enabled only the patched entries are parsed again.
+	 *
+	 * @param fileName Name of the configuration file. It must be the file from which the configuration was read last.
+	 * @param patches New values. Each property must only be patched once.
+	 * @throws ExceptionPropertyNotFound when a property in \p patches does not exist
+	 * @throws ExceptionWrongPropertyType when a property is a structure, or was not read from the configuration file
+	 * @throws ExceptionConfigWriteError when the configuration was not read from a file by \ref readConfiguration(),
+	 *  when the content of the file changed since, when a property is patched twice,
+	 *  or when the file cannot be written. The file is unchanged then.
+	 */
+	void applyPatches (std::string const &fileName,PropertyPatchList const &patches) const;
+
+	/** \brief Release all cached included files
+	 *
+	 * Configurations which include them keep their properties. The next include directive parses the file again.
+	 */
+	static void clearIncludeCache ();
+
 	/** \brief Function to fill the scanner buffer from the configuration input stream
 	 *
 	 * This function is for the use of the internal scanner only.
@@ -617,6 +1660,15 @@ public:
 
 private:
 
+	/// The include cache parses included files with \ref parseChunk()
+	friend class IncludeCache;
+
+	/// Structures share the property map of the configuration from which they are created with \ref shareContent()
+	friend class PropertyStruct;
+
+	/// The parser takes the parsed top level with \ref takeContent(). The included properties in it must remain shared.
+	friend int ::yyparse (void *scanner,Properties *props);
+
     int structLevel = 0;
 
     /// \brief Name of configuration file. Input stream is handled internally
@@ -641,8 +1693,450 @@ private:
 	 */
 	std::ifstream inputFileStream;
 
-	/// \brief std::map containing all properties. Key is std::string containing the property name.
-	PropertyMap propertyMap;
+	/// \brief Maximum number of threads for parallel parsing. \see setParseThreads()
+	unsigned parseThreads = 0;
+
+	/// \brief Incremental reloading is enabled. \see setIncrementalReload()
+	bool incrementalReload = false;
+
+	/// \brief Access profiler. Empty when profiling is disabled. \see setAccessProfiling()
+	std::shared_ptr<AccessProfiler> accessProfiler;
+
+	/// \brief Collect statistics of each load. \see setCollectParseStats()
+	bool collectParseStats = false;
+
+	/// \brief Statistics of the last load. \see getParseStats()
+	ParseStats parseStats;
+
+	/// \brief Directory against which included files are resolved. Empty for the current directory
+	std::string includeDir;
+
+	/// \brief The last parsed input contained include directives
+	bool hasIncludes = false;
+
+	/// \brief A property from the environment which overrides the property at \ref path. \see setEnvironmentOverrides()
+	struct EnvironmentOverride {
+		/// Path components. The last one is the name of \ref property
+		std::vector<std::string> path;
+		/// The typed value
+		PropertyPtr property;
+	};
+
+	/// \brief Overrides from the environment in the order of their paths
+	std::vector<EnvironmentOverride> environmentOverrides;
+
+	/** \brief A top-level entry of the configuration text
+	 *
+	 * A top-level entry starts at the beginning of a line on the top level, and ends before the next one.
+	 * It contains one property, or none when it is an empty or comment line.
+	 * A duplicate property or an error can produce more than one property per entry.
+	 */
+	struct SourceEntry {
+		/// Byte offset of the entry in the configuration text
+		size_t offset;
+		/// Length of the entry in bytes
+		size_t length;
+		/// Line number of the first line of the entry
+		int lineNo;
+		/// Fingerprint of the text of the entry
+		uint64_t textHash;
+		/// Names of the properties which were defined by the entry
+		std::vector<std::string> propertyNames;
+	};
+
+	/// \brief Top-level entries of the last configuration text in the order of the text. \see setIncrementalReload()
+	std::vector<SourceEntry> sourceIndex;
+
+	/// \brief \ref sourceIndex matches the current configuration
+	bool sourceIndexValid = false;
+
+	/// \brief Byte offset of the last line start on the top level of the input. \see readAppended()
+	size_t appendOffset = 0;
+
+	/// \brief Line number of the line starting at \ref appendOffset
+	int appendLineNo = 1;
+
+	/// \brief Position of the input stream when \ref readConfiguration started. \ref appendOffset is relative to it.
+	std::streamoff appendStreamStart = 0;
+
+	/// \brief \ref appendOffset and \ref appendLineNo are valid for the current input
+	bool appendStateValid = false;
+
+	/// \brief Number of bytes of the input which were read. The source offsets of the properties refer to it. \see applyPatches()
+	size_t sourceSize = 0;
+
+	/// \brief \ref sourceSize and the source offsets of the properties are valid for the current input
+	bool sourceSizeValid = false;
+
+	/// \brief Incremental hash of a byte stream. The value does not depend on how the stream is split into blocks.
+	struct StreamHash {
+		/// Hash of the complete words
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		/// Bytes of the incomplete last word
+		uint64_t pending = 0;
+		/// Number of bytes in \ref pending
+		unsigned pendingBytes = 0;
+		/// Total number of bytes
+		uint64_t length = 0;
+
+		/// Add \p length bytes at \p data to the hash
+		void update (char const *data,size_t length);
+		/// The hash of all bytes so far
+		uint64_t value () const;
+	};
+
+	/// \brief Hash of the first \ref sourceSize bytes of the input. \see applyPatches()
+	StreamHash sourceHash;
+
+	/// \brief Hash of the first \ref appendOffset bytes of the input. \see readAppended()
+	StreamHash appendSourceHash;
+
+	/// \brief \ref appendSourceHash is valid. It is not known after the input was parsed directly from the stream.
+	bool appendSourceHashValid = false;
+
+	/// \brief Memory resource of the property tree. \see Properties(std::pmr::memory_resource *memoryResource)
+	std::pmr::memory_resource *memoryResource = std::pmr::get_default_resource();
+
+	/// \brief Table of the interned names and values. Created on demand. \see getStringInterner()
+	std::shared_ptr<StringInterner> stringInterner;
+
+	/// \brief Intern the values of scalar properties. \see setInternValues()
+	bool internValues = false;
+
+	/// \brief Arena of the compacted configuration. \see compact()
+	CompactArena *compactArena = nullptr;
+
+	/** \brief std::map containing all properties. Key is the property name.
+	 *
+	 * The map is shared with copies of this configuration, and with structures which were created from it.
+	 * Modifications go through \ref writablePropertyMap() which copies a shared map first.
+	 */
+	std::shared_ptr<PropertyMap> propertyMap {newPropertyMap(memoryResource)};
+
+	/// \brief Entry of \ref frozenIndex
+	struct FrozenEntry {
+		/// Name of the property. It refers to the name within the property.
+		std::string_view name;
+		Property const *property;
+	};
+
+	/// \brief The properties of this level sorted by name. Only filled when the configuration is frozen. \see freeze()
+	std::vector<FrozenEntry> frozenIndex;
+
+	/// \see freeze()
+	bool frozen = false;
+
+	/// \brief An asynchronous read was scheduled, and has not finished yet. \see readConfigurationAsync()
+	std::atomic<bool> asyncReadInProgress {false};
+
+	/// \brief Throw \ref ExceptionPropertiesFrozen when the configuration is frozen
+	void checkNotFrozen (char const *operation) const {
+		if (frozen) {
+			throwFrozen(operation);
+		}
+	}
+
+	/// \brief Throw \ref ExceptionPropertiesFrozen for \p operation
+	[[noreturn]] static void throwFrozen (char const *operation);
+
+	/** \brief Return the property \p propertyName of this level, or nullptr
+	 *
+	 * A frozen configuration searches \ref frozenIndex, otherwise the map.
+	 */
+	Property const *findProperty (std::string_view propertyName) const;
+
+	/// \brief Guards \ref interpolatedValues. Readers of cached values share it.
+	mutable std::shared_mutex interpolationMutex;
+
+	/** \brief Cache of the values with resolved references by property. \see getInterpolatedValue()
+	 *
+	 * Entries are not changed once they are inserted. The nodes are stable. Thus returned references remain valid
+	 * until the cache is cleared by a modification.
+	 */
+	mutable std::unordered_map<Property const*,std::string> interpolatedValues;
+
+	/// \brief The values in \ref interpolatedValues by the paths which were passed to \ref getInterpolatedValue().
+	/// A repeated call costs only one lookup, and no search of the path.
+	mutable std::unordered_map<std::string,std::string const*> interpolatedPaths;
+
+	/** \brief Content fingerprint of this level. \see getContentHash()
+	 *
+	 * The fingerprint is the sum of the fingerprints of all contained properties.
+	 * Thus adding and removing a property is a single addition or subtraction.
+	 */
+	uint64_t contentHash = 0;
+
+	/// \brief A subscription to changes. \see subscribe()
+	struct Subscription {
+		/// Path pattern without trailing ".*". Empty for the pattern "*"
+		std::string pathPattern;
+		ChangeCallback callback;
+	};
+
+	/// \brief Active subscriptions. Key is the subscription handle.
+	std::map<SubscriptionId,Subscription> subscriptions;
+
+	/// \brief Handle of the next subscription
+	SubscriptionId nextSubscriptionId = 1;
+
+	/** \brief Pass the changes to all subscribers with matching patterns
+	 *
+	 * @param changes All changes of one reload or modification
+	 */
+	void notifySubscribers (PropertyChangeList const &changes) const;
+
+	/** \brief Insert a property into the map, and update the content fingerprint. Subscribers are not notified.
+	 *
+	 * When the structure level of \p newProperty differs from the one of this, and \p newProperty is shared
+	 * e.g. with an included file, a copy on this level is inserted instead. \see isExclusive()
+	 *
+	 * @param newProperty Property to be inserted
+	 * @throws ExceptionPropertyDuplicate when another property with the same name already exists on this structure level.
+	 */
+	void insertProperty (PropertyPtr const &newProperty);
+
+	/** \brief Allocate a property map from \p memoryResource
+	 *
+	 * @param memoryResource Resource of the map and its nodes
+	 * @param source When not nullptr the new map is a copy of it
+	 */
+	static std::shared_ptr<PropertyMap> newPropertyMap (std::pmr::memory_resource *memoryResource,PropertyMap const *source = nullptr);
+
+	/// \brief Return the property map for modification. A map which is shared with another configuration is copied first.
+	PropertyMap &writablePropertyMap () {
+		checkNotFrozen("modify");
+		if (propertyMap.use_count() > 1) {
+			propertyMap = newPropertyMap(memoryResource,propertyMap.get());
+		}
+		return *propertyMap;
+	}
+
+	/** \brief Return the name \p name from the \ref StringInterner of this, or allocated from the memory resource of this
+	 *
+	 * It is used for the properties which this creates without the parser, e.g. the structures on the path of \ref setProperty().
+	 */
+	InternedString sharedName (std::string_view name) const;
+
+	/** \brief Return if \p property may be modified in place because no other configuration can reach it
+	 *
+	 * This is not the case when other pointers to \p property exist, or \p property is a frozen structure.
+	 */
+	static bool isExclusive (PropertyPtr const &property);
+
+	/// \brief Return if \p property and all properties within it are exclusive. \see isExclusive()
+	static bool isExclusiveTree (PropertyPtr const &property);
+
+	/** \brief Make the map of this level writable, and replace the properties in it which are not exclusive by copies
+	 *
+	 * Afterwards the caller of \ref getPropertyMap() can modify each property in place without affecting other configurations.
+	 * The properties of the copied structures remain shared. Their maps are copied when they are modified.
+	 */
+	void makeEntriesExclusive ();
+
+	/** \brief Return a copy of \p property on structure level \p level. \see copyProperty()
+	 *
+	 * The properties of a structure are shared with \p property unless their level must change, too.
+	 */
+	PropertyPtr copyWithStructLevel (Property const &property,int level) const;
+
+	/** \brief Create a copy of \p property with the memory resource of this
+	 *
+	 * @param property Property to be copied
+	 * @param level Structure level of the copy
+	 * @param deep When true the properties of a structure are copied recursively, otherwise they are shared
+	 * @return The copy. It is owned by the caller, and must be released with \ref Property::dispose()
+	 */
+	Property *copyProperty (Property const &property,int level,bool deep) const;
+
+	/** \brief Exchange the content of this level with the one of \p other without copying the property map
+	 *
+	 * The structure level and the settings of both remain.
+	 */
+	void takeContent (Properties &other);
+
+	/** \brief Replace the content of this level with the one of \p other. The property map is shared.
+	 *
+	 * The structure level and the settings of this remain.
+	 */
+	void shareContent (Properties const &other);
+
+	/** \brief Return a copy of the structure \p current in which \p property is added or replaced. \see setProperty()
+	 *
+	 * @param current Current structure at path component \p depth, or nullptr when it does not exist
+	 * @param structurePath Path of the structure which receives \p property
+	 * @param depth Index of the path component of \p current
+	 * @param property The new property
+	 * @param level Structure level of \p current
+	 * @return The copy
+	 * @throws ExceptionWrongPropertyType when \p current is no structure
+	 */
+	PropertyPtr copyPathWithProperty (Property const *current,std::vector<std::string> const &structurePath,size_t depth,
+			PropertyPtr const &property,int level) const;
+
+	/** \brief Copy the properties of \p source into this empty configuration with the memory resource of this. \see compact()
+	 *
+	 * Structures are copied recursively.
+	 */
+	void copyCompact (PropertyMap const &source);
+
+	/** \brief Set \p resource as memory resource of this level and of all structures within. \see compact()
+	 *
+	 * Only for a tree which is not shared with other configurations.
+	 */
+	void setTreeMemoryResource (std::pmr::memory_resource *resource);
+
+	/** \brief Add the memory footprint of this level and the structures below to \p usage. \see memoryUsage()
+	 *
+	 * @param usage Footprint to which this level is added
+	 * @param sharedStrings Shared names and values which were counted already. Each one is counted once.
+	 */
+	void addMemoryUsage (MemoryUsage &usage,std::unordered_set<std::string const*> &sharedStrings) const;
+
+	/** \brief Open the configuration file, or check the external input stream
+	 *
+	 * @throws ExceptionConfigFileOpenError
+	 * @throws ExceptionConfigReadError
+	 */
+	void openInput ();
+
+	/// \brief Close the configuration file if it is managed internally
+	void closeInput ();
+
+	/// \brief Return the current input stream, the internal file stream or the external input stream
+	std::istream &getInputStream () {
+		return configFileManagedInternally ? inputFileStream : *inputStream;
+	}
+
+	/// \brief Invalidate all cached interpolated values of this configuration
+	void invalidateInterpolation () {
+		interpolatedPaths.clear();
+		interpolatedValues.clear();
+	}
+
+	/** \brief Return the interpolated value of \p property, and resolve it when it is not cached yet
+	 *
+	 * The caller must hold \ref interpolationMutex exclusively.
+	 *
+	 * @param property The property
+	 * @param propertyPath Path of the property for error messages
+	 * @param inProgress Properties whose references are being resolved. Used to detect cycles.
+	 */
+	std::string const &resolveInterpolation (Property const &property,std::string const &propertyPath,
+			std::vector<Property const*> &inProgress) const;
+
+	/** \brief Create the property \p name with \p value typed by the rules of the scanner
+	 *
+	 * @param name Name of the property
+	 * @param value Text of the value
+	 * @return The typed property. A quoted string when the value is not a single literal or list.
+	 */
+	static PropertyPtr makeEnvironmentProperty (std::string const &name,std::string const &value);
+
+	/** \brief Return the replacement of \p current when \p envOverride changes it or anything below
+	 *
+	 * Structures on the path are copied. Shared properties are never modified.
+	 *
+	 * @param current Current property at path component \p depth, or nullptr when it does not exist
+	 * @param envOverride The override
+	 * @param depth Index of the path component of \p current
+	 * @param level Structure level of \p current
+	 * @return The replacement, or an empty pointer when nothing changes
+	 */
+	static PropertyPtr overrideProperty (Property const *current,EnvironmentOverride const &envOverride,size_t depth,int level);
+
+	/** \brief Apply \ref environmentOverrides to the top level
+	 *
+	 * @param oldProperties When not nullptr it receives the replaced properties unless they are in \p newProperties
+	 * @param newProperties When not nullptr it receives the replacements
+	 */
+	void applyEnvironmentOverrides (PropertyMap *oldProperties,PropertyMap *newProperties);
+
+	/** \brief Reset the statistics at the start of a load when they are collected. \see setCollectParseStats()
+	 *
+	 * Only called when the library is configured with --enable-parse-stats.
+	 */
+	void startParseStats ();
+
+	/** \brief Complete the statistics of a load when they are collected
+	 *
+	 * @param buildStart Time when parsing ended. The time since then is the build time.
+	 */
+	void finishParseStats (uint64_t buildStart);
+
+	/// \brief Add the statistics of \p part, which parsed a part of the input, when statistics are collected
+	void mergeParseStats (Properties const &part);
+
+	/// \brief Set \ref includeDir to the directory of the configuration file
+	void updateIncludeDir ();
+
+	/** \brief Set \ref appendOffset and \ref appendLineNo to the last line start on the top level of \p buffer
+	 *
+	 * @param buffer The complete configuration text
+	 */
+	void setAppendState (std::string const &buffer);
+
+	/** \brief Set \ref appendSourceHash to the hash of the text of \p buffer before \ref appendOffset
+	 *
+	 * @param buffer The complete configuration text
+	 */
+	void setAppendSourceHash (std::string const &buffer);
+
+	/** \brief Read the complete input into \p buffer
+	 *
+	 * @param buffer Buffer which receives the input
+	 * @throws ExceptionConfigReadError
+	 */
+	void readInputIntoBuffer (std::string &buffer);
+
+	/** \brief Parse the configuration from memory, in parallel chunks when it is large enough
+	 *
+	 * The properties are added to this configuration.
+	 *
+	 * @param buffer Start of the configuration text
+	 * @param length Length of the configuration text
+	 * @param maxThreads Maximum number of parallel threads
+	 */
+	void parseBuffer (char const *buffer,size_t length,unsigned maxThreads);
+
+	/** \brief Parse a chunk of configuration text with an own scanner into this configuration, which must be empty
+	 *
+	 * @param buffer Start of the chunk
+	 * @param length Length of the chunk
+	 * @param firstLineNo Line number of the first line of the chunk in the complete input
+	 * @param baseOffset Byte offset of the chunk in the complete input
+	 */
+	void parseChunk (char const *buffer,size_t length,int firstLineNo,size_t baseOffset);
+
+	/** \brief Split the configuration text into top-level entries, and calculate the fingerprint of each entry
+	 *
+	 * @param buffer The configuration text
+	 * @param[out] entries The entries in the order of the text. The property names are not set.
+	 */
+	static void splitSourceEntries (std::string const &buffer,std::vector<SourceEntry> &entries);
+
+	/** \brief Return the index of the entry which contains \p offset
+	 *
+	 * @param entries Top-level entries sorted by offset. The first entry starts at offset 0.
+	 * @param offset Byte offset in the configuration text
+	 * @return Index of the entry
+	 */
+	static size_t findSourceEntry (std::vector<SourceEntry> const &entries,size_t offset);
+
+	/** \brief Build \ref sourceIndex for the configuration text which was just parsed completely
+	 *
+	 * @param buffer The configuration text
+	 */
+	void buildSourceIndex (std::string const &buffer);
+
+	/** \brief Parse only the top-level entries which changed since the last reload, and update the configuration accordingly
+	 *
+	 * Subscribers are notified about the changes.
+	 *
+	 * @param buffer The new configuration text
+	 * @return true when the configuration was updated. false when a changed entry contains an error or a duplicate.
+	 *   Then the configuration is unchanged, and must be parsed completely.
+	 */
+	bool reparseChangedEntries (std::string const &buffer);
 
 };
 
@@ -715,6 +2209,59 @@ long double strToLD (char const *str);
  */
 std::string dToStr (double val);
 
+/** \brief Compare two versions of a property, and append the differences to \p changes
+ *
+ * Properties with equal content fingerprints are considered unchanged.
+ * When both versions are structures the comparison descends into the structures.
+ *
+ * @param path Path of the property. \see PropertyChange::propertyPath
+ * @param oldProperty Old version of the property
+ * @param newProperty New version of the property
+ * @param changes List to which the differences are appended
+ */
+void diffProperty (std::string const &path,Property const &oldProperty,Property const &newProperty,PropertyChangeList &changes);
+
+/** \brief Compare two versions of a configuration level, and append the differences to \p changes
+ *
+ * @param parentPath Path of the structure which contains the maps. Empty for the top level.
+ * @param oldMap Old version of the configuration level
+ * @param newMap New version of the configuration level
+ * @param changes List to which the differences are appended
+ */
+void diffPropertyMaps (std::string const &parentPath,
+		Properties::PropertyMap const &oldMap,
+		Properties::PropertyMap const &newMap,
+		PropertyChangeList &changes);
+
+// Hash helpers for the content fingerprints of properties
+
+/** \brief Calculate a 64-bit hash value of a byte sequence
+ *
+ * The hash is FNV-1a with a final avalanche step.
+ *
+ * @param str Start of the byte sequence
+ * @param len Length of the byte sequence
+ * @param seed Start value of the hash. Allows chaining of multiple sequences.
+ * @return 64-bit hash value
+ */
+uint64_t hashString (char const *str, size_t len, uint64_t seed = 0xcbf29ce484222325ULL);
+
+/** \brief Calculate a 64-bit hash value of a std::string
+ *
+ * \see hashString(char const *str, size_t len, uint64_t seed)
+ */
+static inline uint64_t hashString (std::string const &str, uint64_t seed = 0xcbf29ce484222325ULL) {
+	return hashString(str.data(),str.size(),seed);
+}
+
+/** \brief Combine a hash value with another value. The result depends on the order of combination.
+ *
+ * @param hash Hash value so far
+ * @param val Value to be combined into \p hash
+ * @return Combined hash value
+ */
+uint64_t hashCombine (uint64_t hash, uint64_t val);
+
 }; // namespace Properties4CXX {
 
 /** \brief Output stream operator for \ref Properties4CXX::Properties objects.
@@ -0,0 +1,184 @@
+/*
+ * PropertiesWriter.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef INCLUDE_PROPERTIES4CXX_PROPERTIESWRITER_H_
+#define INCLUDE_PROPERTIES4CXX_PROPERTIESWRITER_H_
+
+#include <cstddef>
+#include <string>
+
+#include "Properties4CXX/Properties.h"
+#include "Properties4CXX/Property.h"
+
+namespace Properties4CXX {
+
+/** \brief Serializer for configurations into a memory buffer or a file descriptor
+ *
+ * The writer formats properties into a growable byte buffer. Strings are escaped in bulk runs, indentation
+ * is copied from a pre-built string, and nothing is flushed per line.
+ *
+ * When the writer was created with a file descriptor the buffer is written to the file descriptor
+ * whenever it exceeds the flush threshold, and finally by \ref flush() or the destructor.
+ * Otherwise the result is available in the buffer with \ref str().
+ *
+ * The output can be read again with \ref Properties::readConfiguration() in both formats.
+ */
+class PROPERTIES4CXX_PUBLIC
+PropertiesWriter {
+public:
+
+	enum FormatEnum {
+		/** Indent with tabs by structure level, blanks around '=' and ',' like \ref Properties::writeOut.
+		 * The output is identical to \ref Properties::writeOut */
+		Pretty,
+		/// No indention, no blanks, and no empty lines
+		Compact
+	};
+
+	/// Default flush threshold when writing to a file descriptor
+	static constexpr size_t defaultFlushThreshold = 64 * 1024;
+
+	/** \brief Constructor for writing into the memory buffer
+	 *
+	 * @param format Output format
+	 */
+	PropertiesWriter (FormatEnum format = Pretty);
+
+	/** \brief Constructor for writing to a file descriptor
+	 *
+	 * The file descriptor is not closed by the writer.
+	 *
+	 * @param fileDescriptor Open file descriptor of a file, pipe, or socket
+	 * @param format Output format
+	 * @param flushThreshold The buffer is written to the file descriptor when it exceeds this size
+	 */
+	PropertiesWriter (int fileDescriptor,FormatEnum format = Pretty,size_t flushThreshold = defaultFlushThreshold);
+
+	/** \brief Destructor
+	 *
+	 * Writes remaining buffer content to the file descriptor. Write errors are ignored here.
+	 * Call \ref flush() before to get them reported.
+	 */
+	~PropertiesWriter ();
+
+	PropertiesWriter (PropertiesWriter const &) = delete;
+	PropertiesWriter &operator = (PropertiesWriter const &) = delete;
+
+	/** \brief Write all properties of a configuration
+	 *
+	 * @param properties Configuration to be written
+	 * @param structLevel Structure level for the indention of the properties in the pretty format
+	 * @return Reference to this writer
+	 * @throws ExceptionConfigWriteError when writing to the file descriptor fails
+	 */
+	PropertiesWriter &write (Properties const &properties,int structLevel = 0);
+
+	/** \brief Write a single property including the line end
+	 *
+	 * @param property Property to be written
+	 * @param structLevel Structure level for the indention of the property in the pretty format
+	 * @return Reference to this writer
+	 * @throws ExceptionConfigWriteError when writing to the file descriptor fails
+	 */
+	PropertiesWriter &write (Property const &property,int structLevel = 0);
+
+	/** \brief Write the buffer content to the file descriptor
+	 *
+	 * Without a file descriptor it does nothing.
+	 *
+	 * @throws ExceptionConfigWriteError when writing to the file descriptor fails
+	 */
+	void flush ();
+
+	/// \brief Return the buffer content which was not yet written to a file descriptor
+	std::string const &str () const {
+		return buffer;
+	}
+
+	/// \brief Return the start of the buffer content
+	char const *data () const {
+		return buffer.data();
+	}
+
+	/// \brief Return the size of the buffer content
+	size_t size () const {
+		return buffer.size();
+	}
+
+	/// \brief Discard the buffer content
+	void clear () {
+		buffer.clear();
+	}
+
+	/** \brief Append \p str to \p outBuffer while escaping special characters
+	 *
+	 * The escaping is the same as \ref Property::streamEscapedString.
+	 * Runs of characters which need no escaping are copied in bulk.
+	 *
+	 * @param outBuffer Buffer to which the escaped string is appended
+	 * @param str Start of the string
+	 * @param length Length of the string
+	 * @param escapeNewlines Escape newline and carriage return characters as \\n and \\r. Otherwise they are copied verbatim.
+	 */
+	static void appendEscaped (std::string &outBuffer,char const *str,size_t length,bool escapeNewlines);
+
+private:
+
+	/// \brief Output format
+	FormatEnum format;
+
+	/// \brief File descriptor to which the buffer is flushed. -1 when writing to memory only
+	int fileDescriptor = -1;
+
+	/// \brief Buffer size which triggers writing to the file descriptor
+	size_t flushThreshold = defaultFlushThreshold;
+
+	/// \brief Output buffer
+	std::string buffer;
+
+	/// \brief Write the properties of one structure level
+	void writeProperties (Properties const &properties,int structLevel);
+
+	/// \brief Write a property with indention and line end
+	void writeProperty (Property const &property,int structLevel);
+
+	/// \brief Append the indention for \p structLevel in the pretty format
+	void writeIndent (int structLevel);
+
+	/// \brief Append \p str in double quotes, and escape it
+	void writeQuoted (std::string const &str,bool escapeNewlines);
+
+	/// \brief Flush when the buffer exceeds the threshold
+	void flushIfFull () {
+		if (fileDescriptor >= 0 && buffer.size() >= flushThreshold) {
+			flush();
+		}
+	}
+
+};
+
+} /* namespace Properties4CXX */
+
+#endif /* INCLUDE_PROPERTIES4CXX_PROPERTIESWRITER_H_ */
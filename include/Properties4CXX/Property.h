@@ -26,12 +26,20 @@
 #ifndef INCLUDE_PROPERTIES4CXX_PROPERTY_H_
 #define INCLUDE_PROPERTIES4CXX_PROPERTY_H_
 
+#include <cstdint>
+#include <cstddef>
 #include <exception>
 #include <string>
+#include <string_view>
 #include <list>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
 #include <ostream>
 
+#include "Properties4CXX/StringInterner.h"
+
 
 #if !defined PROPERTIES4CXX_EXPORT
 #define PROPERTIES4CXX_EXPORT
@@ -88,6 +96,48 @@ namespace Properties4CXX {
 /// \see [std::list](http://en.cppreference.com/w/cpp/container/list)
 typedef std::list<std::string> PropertyValueList;
 
+/** \brief Name argument of the constructors of the properties
+ *
+ * A name which is passed as a plain string is copied into a new shared string from the default memory resource.
+ * A configuration replaces it with the name from its \ref StringInterner when the property is added to it.
+ * An \ref InternedString is shared.
+ */
+class PROPERTIES4CXX_DLL_EXPORT
+PropertyName {
+public:
+
+	PropertyName (char const *name)
+	:name{allocateName(name,std::pmr::get_default_resource())}
+	{ }
+
+	PropertyName (std::string const &name)
+	:name{allocateName(name,std::pmr::get_default_resource())}
+	{ }
+
+	/** \brief Copy \p name into a new shared string from \p resource
+	 *
+	 * @param name Name of the property
+	 * @param resource Memory resource of the string and its reference counter
+	 */
+	PropertyName (std::string_view name,std::pmr::memory_resource *resource)
+	:name{allocateName(name,resource)}
+	{ }
+
+	PropertyName (InternedString name)
+	:name{std::move(name)}
+	{ }
+
+	/// The shared name
+	InternedString name;
+
+private:
+
+	/// \brief Allocate the string and its reference counter in one piece from \p resource
+	static InternedString allocateName (std::string_view name,std::pmr::memory_resource *resource) {
+		return std::allocate_shared<std::string>(std::pmr::polymorphic_allocator<std::string>(resource),name);
+	}
+};
+
 /// Exception thrown when an access method of class \ref Property is invoked which is not overloaded by a specific subclass
 class PROPERTIES4CXX_DLL_EXPORT
 ExceptionWrongPropertyType : public std::exception {
@@ -136,17 +186,78 @@ public:
 	 * 	Thus quotation is preserved when a configuration is written out
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	Property(char const* propertyName, char const* propertyValue,bool stringIsQuoted = true, int structLevel = 0);
+	Property(PropertyName propertyName, char const* propertyValue,bool stringIsQuoted = true, int structLevel = 0);
 
 	/** \brief Destructor
 	 */
 	virtual ~Property();
 
+	/** \brief Create a property of type \p T in the memory resource \p resource
+	 *
+	 * The property must be released with \ref dispose().
+	 * \ref Properties::addProperty() takes care of it when the property is passed to it.
+	 *
+	 * @param resource Memory resource from which the property is allocated. When it is nullptr the property is allocated with new.
+	 * @param args Arguments of the constructor of \p T
+	 * @return Pointer to the new property
+	 */
+	template <typename T,typename... Args>
+	static T *create (std::pmr::memory_resource *resource,Args&&... args) {
+		if (!resource) {
+			return new T(std::forward<Args>(args)...);
+		}
+
+		size_t const size = resourceHeaderSize + sizeof(T);
+		void *mem = resource->allocate(size,alignof(std::max_align_t));
+		T *rc;
+
+		try {
+			rc = new (static_cast<char*>(mem) + resourceHeaderSize) T(std::forward<Args>(args)...);
+		} catch (...) {
+			resource->deallocate(mem,size,alignof(std::max_align_t));
+			throw;
+		}
+
+		ResourceHeader *header = static_cast<ResourceHeader*>(mem);
+		header->resource = resource;
+		header->size = size;
+		static_cast<Property*>(rc)->allocatedFromResource = true;
+
+		return rc;
+	}
+
+	/** \brief Destroy a property which was created by \ref create() or by new
+	 *
+	 * This is the deleter of the properties in \ref Properties.
+	 *
+	 * @param property Property to be destroyed. Can be nullptr.
+	 */
+	static void dispose (Property *property);
+
 	/**
 	 *
 	 * @return The name of the property
 	 */
 	std::string const &getPropertyName() const {
+		return *propertyName;
+	}
+
+	/** \brief Share the string value with equal values of other properties
+	 *
+	 * Only scalar properties intern their value. For lists and structures it does nothing.
+	 *
+	 * @param interner Table of interned strings
+	 */
+	void internStringValue (StringInterner &interner);
+
+	/** \brief Return the shared name of the property
+	 *
+	 * Properties which were read by the same configuration, or by configurations with the same \ref StringInterner,
+	 * share the name when it is equal. Then the names can be compared by pointer.
+	 *
+	 * @return The name of the property
+	 */
+	InternedString const &getInternedName() const {
 		return propertyName;
 	}
 
@@ -155,7 +266,7 @@ public:
 	 * @return The name of the property
 	 */
 	char const *getPropertyNameCStr() const {
-		return propertyName.c_str();
+		return propertyName->c_str();
 	}
 
 	/** \brief Return string value of any property
@@ -233,6 +344,83 @@ public:
 	 */
 	virtual Properties const& getPropertiesStructure() const;
 
+	/** \brief Return the content fingerprint of the property
+	 *
+	 * The fingerprint is a 64-bit hash over the name, the type and the value of the property.
+	 * For structures it includes the fingerprints of all properties in the structure.
+	 * It is calculated when the property is created, and updated when list items are appended.
+	 *
+	 * \see Properties::getContentHash()
+	 *
+	 * @return 64-bit content fingerprint
+	 */
+	virtual uint64_t getContentHash() const;
+
+	/** \brief Return the byte offset of the definition of the property in the configuration input
+	 *
+	 * The offset is set by the parser, and points to the first character of the property name.
+	 * For properties which were not read from a configuration it is 0.
+	 *
+	 * @return Byte offset of the definition
+	 */
+	size_t getSourceOffset() const {
+		return sourceOffset;
+	}
+
+	/** \brief Set the byte offset of the definition of the property in the configuration input
+	 *
+	 * \see getSourceOffset()
+	 *
+	 * @param sourceOffset Byte offset of the first character of the property name
+	 */
+	void setSourceOffset(size_t sourceOffset) {
+		this->sourceOffset = sourceOffset;
+	}
+
+	/** \brief Return the byte offset of the value text in the configuration input
+	 *
+	 * The range covers the value exactly as written, i.e. quoted strings include the double quotes,
+	 * and lists range from the first to the last element.
+	 * Structures have no value range. For them, and for properties which were not read from a configuration
+	 * \ref getSourceValueLength() returns 0.
+	 *
+	 * @return Byte offset of the value text
+	 */
+	size_t getSourceValueOffset() const {
+		return sourceValueOffset;
+	}
+
+	/** \brief Return the length of the value text in the configuration input
+	 *
+	 * \see getSourceValueOffset()
+	 *
+	 * @return Length of the value text in bytes. 0 when the range is unknown.
+	 */
+	size_t getSourceValueLength() const {
+		return sourceValueLength;
+	}
+
+	/** \brief Set the byte range of the value text in the configuration input
+	 *
+	 * \see getSourceValueOffset()
+	 *
+	 * @param offset Byte offset of the first character of the value
+	 * @param length Length of the value text in bytes
+	 */
+	void setSourceValueRange(size_t offset,size_t length) {
+		sourceValueOffset = offset;
+		sourceValueLength = length;
+	}
+
+	/** \brief Move the source offset of the property by \p delta bytes
+	 *
+	 * This is used when text before the property was modified.
+	 * Complex sub-classes need to move the contained properties too. Therefore virtual
+	 *
+	 * @param delta Difference of the new and the old source offset
+	 */
+	virtual void shiftSourceOffset(ptrdiff_t delta);
+
 	/** \brief Set or reset newline escaping on printout
 	 *
 	 * @param isNewlineEscaped
@@ -245,10 +433,20 @@ public:
 	 *
 	 * @return \ref isNewlineEscaped
 	 */
-	bool getIsNewlineEscaped () {
+	bool getIsNewlineEscaped () const {
 		return isNewlineEscaped;
 	}
 
+	/** \brief Was the value a quoted string
+	 *
+	 * Quoted values are written with quotes and escaped special characters.
+	 *
+	 * @return true when the value is written as quoted string
+	 */
+	bool getIsStringQuoted () const {
+		return isStringQuoted;
+	}
+
 	/** \brief Returns the structure level of the property. Use for indention on printout
 	 *
 	 * @return Structure level.
@@ -325,7 +523,7 @@ protected:
 	 * @param propertyName Name of the property
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	Property(char const* propertyName, int structLevel = 0);
+	Property(PropertyName propertyName, int structLevel = 0);
 
 	/** \brief Helper function to throw an \ref ExceptionWrongPropertyType exception when a not supported property type is requested
 	 *
@@ -359,7 +557,14 @@ protected:
 	 */
 	virtual std::ostream &writeOutValue (std::ostream &os) const;
 
-	std::string const propertyName;
+	/** \brief Calculate \ref contentHash of a scalar property from name, type, and string value
+	 *
+	 * Scalar sub-classes call it after they set \ref propertyType.
+	 */
+	void setScalarContentHash ();
+
+	/// \brief Name of the property. Never empty. \see getInternedName()
+	InternedString propertyName;
 
 	/** \brief Newline and carriage return characters are to printed escaped as \\n and \\r. If false they are printed verbatim
 	 *
@@ -382,6 +587,17 @@ protected:
 	 */
 	mutable std::string stringValue;
 
+	/** \brief Shared string value which replaces \ref stringValue when values are interned
+	 *
+	 * Only scalar properties intern their value. \see Properties::setInternValues()
+	 */
+	InternedString internedValue;
+
+	/// \brief Return the string value after it was defined
+	std::string const &definedStringValue () const {
+		return internedValue ? *internedValue : stringValue;
+	}
+
 	/** \brief  Used for lazy string value definition by derived classes
 	 *
 	 * Used for lazy string value definition. This is useful for \ref PropertyStruct classes where a string representation of the entire sub-structure
@@ -391,6 +607,22 @@ protected:
 
 	PropertyTypeEnum propertyType = String;
 
+	/** \brief Content fingerprint of the property. \see getContentHash()
+	 *
+	 * Structures store only the fingerprint of name and type here, and combine it with the fingerprint
+	 * of the structure content on demand.
+	 */
+	uint64_t contentHash = 0;
+
+	/// \brief Byte offset of the definition in the configuration input. \see getSourceOffset()
+	size_t sourceOffset = 0;
+
+	/// \brief Byte offset of the value text in the configuration input. \see getSourceValueOffset()
+	size_t sourceValueOffset = 0;
+
+	/// \brief Length of the value text in the configuration input. \see getSourceValueLength()
+	size_t sourceValueLength = 0;
+
 	// A bit of stuff is quite critical, and needs to be handled within the class. Also derived classes have to access it via the interface
 private:
 
@@ -401,6 +633,23 @@ private:
 	 */
 	bool isStringQuoted = true;
 
+	/// Properties copies the internal representation of the name and the value. \see Properties::compact()
+	friend class Properties;
+
+	/// \brief The property was allocated from a memory resource by \ref create(). \see dispose()
+	bool allocatedFromResource = false;
+
+	/** \brief Precedes a property which was allocated by \ref create()
+	 *
+	 * It is aligned like any object. Thus the property behind it is properly aligned, too.
+	 */
+	struct alignas(std::max_align_t) ResourceHeader {
+		std::pmr::memory_resource *resource;
+		size_t size;
+	};
+
+	static constexpr size_t resourceHeaderSize = sizeof(ResourceHeader);
+
 
 };
 
@@ -421,7 +670,7 @@ public:
 	 * @param propertyValueDbl double float value of the property as binary value
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	PropertyDouble(char const* propertyName, char const* propertyValue,double propertyValueDbl, int structLevel = 0);
+	PropertyDouble(PropertyName propertyName, char const* propertyValue,double propertyValueDbl, int structLevel = 0);
 
 	/** \brief Constructor
 	 *
@@ -431,7 +680,7 @@ public:
 	 * @param propertyValueDbl double float value of the property as binary value
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	PropertyDouble(char const* propertyName, double propertyValueDbl, int structLevel = 0);
+	PropertyDouble(PropertyName propertyName, double propertyValueDbl, int structLevel = 0);
 
 	/** \brief Destructor
 	 * Destructor. Virtual is a must here because it will be overloaded.
@@ -476,7 +725,7 @@ public:
 	 * @param propertyValueInt long long int value of the property as binary value
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	PropertyInt(char const* propertyName, char const* propertyValue,long long propertyValueInt, int structLevel = 0);
+	PropertyInt(PropertyName propertyName, char const* propertyValue,long long propertyValueInt, int structLevel = 0);
 
 		/** \brief Constructor
 		 *
@@ -486,7 +735,7 @@ public:
 		 * @param propertyValueInt long long int value of the property as binary value
 		 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 		 */
-		PropertyInt(char const* propertyName, long long propertyValueInt, int structLevel = 0);
+		PropertyInt(PropertyName propertyName, long long propertyValueInt, int structLevel = 0);
 
 	/** \brief Destructor
 	 * Virtual is a must here because it will be overloaded.
@@ -533,7 +782,7 @@ public:
 	 * @param propertyValueBool bool value of the property as binary value
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	PropertyBool(char const* propertyName, char const* propertyValue,bool propertyValueBool, int structLevel = 0);
+	PropertyBool(PropertyName propertyName, char const* propertyValue,bool propertyValueBool, int structLevel = 0);
 
 	/** \brief Constructor
 	 *
@@ -543,7 +792,7 @@ public:
 	 * @param propertyValueBool bool value of the property as binary value
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	PropertyBool(char const* propertyName, bool propertyValueBool, int structLevel = 0);
+	PropertyBool(PropertyName propertyName, bool propertyValueBool, int structLevel = 0);
 
 	/** \brief Destructor
 	 *
@@ -581,7 +830,7 @@ public:
 	 * @param propertyName Name of the property
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	PropertyList(char const* propertyName, int structLevel = 0);
+	PropertyList(PropertyName propertyName, int structLevel = 0);
 
 	/** \brief Constructor
 	 *
@@ -592,7 +841,7 @@ public:
 	 * @param valueList List of string values assigned to the property
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	PropertyList(char const* propertyName, PropertyValueList const &valueList, int structLevel = 0);
+	PropertyList(PropertyName propertyName, PropertyValueList const &valueList, int structLevel = 0);
 
 	/** \brief Destructor
 	 * Virtual is a must here because it will be overloaded.
@@ -651,18 +900,31 @@ public:
 	 * @param propertyName Name of the property
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	PropertyStruct(char const* propertyName, int structLevel = 0);
+	PropertyStruct(PropertyName propertyName, int structLevel = 0);
 
 	/** \brief Constructor
 	 *
 	 * This constructor creates a property list with a pre-populated list of properties.
 	 * Additional properties can be added to the list with \ref addProperty()
 	 *
+	 * The property map of \p propertyList is shared in constant time. It is copied when either one is modified.
+	 *
 	 * @param propertyName Name of the property
 	 * @param propertyList List of properties.
 	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
 	 */
-	PropertyStruct(char const* propertyName, Properties const &propertyList, int structLevel = 0);
+	PropertyStruct(PropertyName propertyName, Properties const &propertyList, int structLevel = 0);
+
+	/** \brief Constructor
+	 *
+	 * This constructor takes over the properties of \p propertyList without copying the map.
+	 * The structure uses the memory resource of \p propertyList.
+	 *
+	 * @param propertyName Name of the property
+	 * @param propertyList List of properties. It shares the map with the structure afterwards.
+	 * @param structLevel Number of the structure level on which this property resides. Base level is 0.
+	 */
+	PropertyStruct(PropertyName propertyName, Properties &&propertyList, int structLevel = 0);
 
 	/** \brief Destructor
 	 *
@@ -680,6 +942,14 @@ public:
 	 */
 	virtual Properties const& getPropertiesStructure() const override;
 
+	/** \brief Return the content fingerprint of the structure including all contained properties
+	 *
+	 * \see Property::getContentHash()
+	 *
+	 * @return 64-bit content fingerprint
+	 */
+	virtual uint64_t getContentHash() const override;
+
 	/** \brief Set the structure level for a property structure for \ref writeOut indention.
 	 *
 	 * \see Property::setStructLevel
@@ -688,8 +958,20 @@ public:
 	 */
 	virtual void setStructLevel(int structLevel) override;
 
+	/** \brief Move the source offsets of the structure and all contained properties
+	 *
+	 * \see Property::shiftSourceOffset
+	 *
+	 * @param delta Difference of the new and the old source offset
+	 */
+	virtual void shiftSourceOffset(ptrdiff_t delta) override;
+
 
 	/** \brief Add a property to the property list
+	 *
+	 * The property list copies its map first when the map is shared, e.g. with a copy of the configuration.
+	 * The structure itself must not be shared. Only call it for structures which were taken from the non-constant
+	 * \ref Properties::getPropertyMap(), or which were created by the caller.
 	 *
 	 * @param prop Pointer to a new property. This takes ownership of the property. The caller must never delete the passed \p prop!
 	 */
@@ -710,6 +992,9 @@ protected:
 	// A bit of stuff is quite critical, and needs to be handled within the class. Also derived classes have to access it via the interface
 private:
 
+	/// \ref Properties::freeze() freezes the sub-structure with the configuration
+	friend class Properties;
+
 	/** \brief List of properties in a sub-structure
 	 *
 	 * This is a pointer due to hen&egg problem: Here the declaration of class \ref Properties is incomplete.
@@ -0,0 +1,156 @@
+/*
+ * StringInterner.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef INCLUDE_PROPERTIES4CXX_STRINGINTERNER_H_
+#define INCLUDE_PROPERTIES4CXX_STRINGINTERNER_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#if !defined PROPERTIES4CXX_EXPORT
+#define PROPERTIES4CXX_EXPORT
+/**
+ * Define PROPERTIES4CXX_DLL_IMPORT, PROPERTIES4CXX_DLL_EXPORT, and PROPERTIES4CXX_DLL_LOCAL for Windows and Linux (ELF) ports of gcc and non-gcc compilers
+ *
+ * The macro definitions are highly inspired from the <a href="https://gcc.gnu.org/wiki/Visibility">GCC Wiki: Visibility</a>
+ */
+#if defined _WIN32 || defined __CYGWIN__
+    #ifdef __GNUC__
+      #define PROPERTIES4CXX_DLL_EXPORT __attribute__ ((dllexport))
+      #define PROPERTIES4CXX_DLL_IMPORT __attribute__ ((dllimport))
+    #else
+      #define PROPERTIES4CXX_DLL_EXPORT __declspec(dllexport) // Note: actually gcc seems to also supports this syntax.
+      #define PROPERTIES4CXX_DLL_IMPORT __declspec(dllimport) // Note: actually gcc seems to also supports this syntax.
+    #endif
+    #ifdef __GNUC__
+    #else
+    #endif
+  #define PROPERTIES4CXX_DLL_LOCAL
+#else
+  #if __GNUC__ >= 4
+    #define PROPERTIES4CXX_DLL_EXPORT __attribute__ ((visibility ("default")))
+    #define PROPERTIES4CXX_DLL_LOCAL  __attribute__ ((visibility ("hidden")))
+  #else
+    #define PROPERTIES4CXX_DLL_EXPORT
+    #define PROPERTIES4CXX_DLL_LOCAL
+  #endif
+  #define PROPERTIES4CXX_DLL_IMPORT
+#endif
+
+#if defined (BUILDING_PROPERTIES4CXX)
+  #define PROPERTIES4CXX_PUBLIC PROPERTIES4CXX_DLL_EXPORT
+  #define PROPERTIES4CXX_LOCAL  PROPERTIES4CXX_DLL_LOCAL
+#else /* BUILDING_PROPERTIES4CXX */
+  #define PROPERTIES4CXX_PUBLIC PROPERTIES4CXX_DLL_IMPORT
+  #define PROPERTIES4CXX_LOCAL  PROPERTIES4CXX_DLL_LOCAL
+#endif /* BUILDING_PROPERTIES4CXX */
+
+#endif /* #define PROPERTIES4CXX_EXPORT */
+
+namespace Properties4CXX {
+
+/** \brief Immutable string which can be shared by many properties. \see StringInterner
+ *
+ * Two interned strings from the same \ref StringInterner are equal exactly when they are the same pointer.
+ */
+typedef std::shared_ptr<std::string const> InternedString;
+
+/** \brief Table of distinct strings, e.g. property names which occur in many structures
+ *
+ * \ref intern() returns the same \ref InternedString for equal strings. Thus each distinct string is stored once,
+ * and interned strings can be compared by pointer.
+ *
+ * A configuration interns the names of all properties which it reads. It can intern the values, too.
+ * \see Properties::setStringInterner() and \ref Properties::setInternValues()
+ *
+ * The table is thread-safe. It is split into shards with an own lock each. Thus parallel parsers rarely
+ * wait for each other.
+ *
+ * Strings stay in the table when they are not used anymore. \ref purge() removes them.
+ */
+class PROPERTIES4CXX_PUBLIC
+StringInterner {
+public:
+
+	StringInterner () = default;
+
+	StringInterner (StringInterner const &) = delete;
+	StringInterner &operator = (StringInterner const &) = delete;
+
+	/** \brief Return the interned string which is equal to \p str
+	 *
+	 * @param str String to be interned
+	 * @return Shared string equal to \p str. It is created when \p str was not interned before.
+	 */
+	InternedString intern (std::string_view str);
+
+	/** \brief Return the interned string which is equal to \p str without interning it
+	 *
+	 * @param str String to be searched
+	 * @return Shared string equal to \p str, or an empty pointer when it was not interned
+	 */
+	InternedString find (std::string_view str) const;
+
+	/// \brief Return the number of distinct strings in the table
+	size_t size () const;
+
+	/** \brief Remove the strings which are only referenced by the table
+	 *
+	 * @return Number of removed strings
+	 */
+	size_t purge ();
+
+private:
+
+	/// Number of shards. A power of 2
+	static constexpr size_t numShards = 16;
+
+	/// Part of the table with an own lock. The keys refer to the interned strings.
+	struct Shard {
+		mutable std::mutex mutex;
+		std::unordered_map<std::string_view,InternedString> strings;
+	};
+
+	Shard shards[numShards];
+
+	/// \brief Return the shard of a string by its hash value
+	Shard &shardOf (size_t hash) {
+		return shards[(hash >> 7) & (numShards - 1)];
+	}
+
+	/// \brief Return the shard of a string by its hash value
+	Shard const &shardOf (size_t hash) const {
+		return shards[(hash >> 7) & (numShards - 1)];
+	}
+
+};
+
+} /* namespace Properties4CXX */
+
+#endif /* INCLUDE_PROPERTIES4CXX_STRINGINTERNER_H_ */
@@ -0,0 +1,194 @@
+/*
+ * AccessProfiler.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include "AccessProfiler.h"
+
+namespace Properties4CXX {
+
+static std::atomic<uint64_t> nextProfilerId {1};
+
+/// Number of deleted profilers. A thread prunes its map of shards when it changed.
+static std::atomic<uint64_t> deletedProfilers {0};
+
+AccessProfiler::AccessProfiler ()
+:id{nextProfilerId.fetch_add(1,std::memory_order_relaxed)}
+{ }
+
+AccessProfiler::~AccessProfiler () {
+
+	// Release the shards first. Threads which see the new count see them expired.
+	{
+		std::lock_guard<std::mutex> lock(shardsMutex);
+		shards.clear();
+	}
+	deletedProfilers.fetch_add(1,std::memory_order_release);
+
+}
+
+uint64_t AccessProfiler::now () {
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+AccessProfiler::Shard &AccessProfiler::localShard () {
+
+	// The last used shard is the common case. The map is only searched when a thread uses several profilers.
+	thread_local uint64_t lastId = 0;
+	thread_local Shard *lastShard = nullptr;
+	thread_local uint64_t prunedDeletedProfilers = 0;
+	thread_local std::unordered_map<uint64_t,std::weak_ptr<Shard>> threadShards;
+
+	if (lastId == id) {
+		return *lastShard;
+	}
+
+	uint64_t const deleted = deletedProfilers.load(std::memory_order_acquire);
+
+	if (deleted != prunedDeletedProfilers) {
+		prunedDeletedProfilers = deleted;
+		for (auto it = threadShards.begin(); it != threadShards.end();) {
+			if (it->second.expired()) {
+				it = threadShards.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	std::weak_ptr<Shard> &entry = threadShards[id];
+	// This profiler keeps its shards alive
+	Shard *shard = entry.lock().get();
+
+	if (!shard) {
+		std::lock_guard<std::mutex> lock(shardsMutex);
+
+		shards.emplace_back(std::make_shared<Shard>());
+		entry = shards.back();
+		shard = shards.back().get();
+	}
+
+	lastId = id;
+	lastShard = shard;
+
+	return *shard;
+}
+
+void AccessProfiler::record (std::string const &key,AccessKindEnum kind,uint64_t nanoseconds) {
+
+	Shard &shard = localShard();
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto it = shard.keys.find(key);
+	if (it == shard.keys.end()) {
+		it = shard.keys.emplace(key,PropertyAccessStats()).first;
+		it->second.key = key;
+	}
+
+	PropertyAccessStats &stats = it->second;
+
+	switch (kind) {
+	case Hit:
+		stats.hits++;
+		break;
+	case Miss:
+		stats.misses++;
+		break;
+	case Defaulted:
+		stats.defaulted++;
+		return;
+	}
+
+	// Bucket i counts latencies in [2^(i-1), 2^i) ns. Bucket 0 counts 0 ns.
+	int bucket = 0;
+	while (nanoseconds >> bucket && bucket < PropertyAccessStats::numLatencyBuckets - 1) {
+		bucket++;
+	}
+
+	stats.latencyHistogram[bucket]++;
+	stats.totalNanoseconds += nanoseconds;
+
+}
+
+PropertyAccessProfile AccessProfiler::collect () const {
+
+	std::unordered_map<std::string,PropertyAccessStats> merged;
+
+	{
+		std::lock_guard<std::mutex> lock(shardsMutex);
+
+		for (auto const &shard : shards) {
+			std::lock_guard<std::mutex> shardLock(shard->mutex);
+
+			for (auto const &it : shard->keys) {
+				PropertyAccessStats &stats = merged[it.first];
+
+				stats.key = it.first;
+				stats.hits += it.second.hits;
+				stats.misses += it.second.misses;
+				stats.defaulted += it.second.defaulted;
+				stats.totalNanoseconds += it.second.totalNanoseconds;
+				for (int i = 0; i < PropertyAccessStats::numLatencyBuckets; i++) {
+					stats.latencyHistogram[i] += it.second.latencyHistogram[i];
+				}
+			}
+		}
+	}
+
+	PropertyAccessProfile profile;
+	profile.reserve(merged.size());
+	for (auto &it : merged) {
+		profile.push_back(std::move(it.second));
+	}
+
+	std::sort(profile.begin(),profile.end(),[] (PropertyAccessStats const &a,PropertyAccessStats const &b) {
+		uint64_t const lookupsA = a.hits + a.misses;
+		uint64_t const lookupsB = b.hits + b.misses;
+
+		return lookupsA != lookupsB ? lookupsA > lookupsB : a.key < b.key;
+	});
+
+	return profile;
+}
+
+void AccessProfiler::reset () {
+
+	std::lock_guard<std::mutex> lock(shardsMutex);
+
+	for (auto const &shard : shards) {
+		std::lock_guard<std::mutex> shardLock(shard->mutex);
+
+		shard->keys.clear();
+	}
+
+}
+
+} /* namespace Properties4CXX */
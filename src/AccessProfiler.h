@@ -0,0 +1,111 @@
+/*
+ * AccessProfiler.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SRC_ACCESSPROFILER_H_
+#define SRC_ACCESSPROFILER_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Properties4CXX/Properties.h"
+
+namespace Properties4CXX {
+
+/** \brief Counters of the accesses to the properties of one configuration. \see Properties::setAccessProfiling()
+ *
+ * Each thread records into an own shard. A shard is locked by its thread for each record,
+ * and by \ref collect() and \ref reset() only. Thus the lock is practically never contended.
+ * \ref collect() merges the shards on demand.
+ *
+ * The shards live as long as the profiler. Each thread keeps a small map from profiler to its shard.
+ * An entry of a deleted profiler is never used again because profiler identities are not reused.
+ * The entries of deleted profilers are removed by the thread when it searches its map the next time.
+ */
+class PROPERTIES4CXX_LOCAL
+AccessProfiler {
+public:
+
+	enum AccessKindEnum {
+		/// The property was found
+		Hit,
+		/// The property was not found
+		Miss,
+		/// The property was not found, and the default value was returned
+		Defaulted
+	};
+
+	AccessProfiler();
+
+	~AccessProfiler();
+
+	AccessProfiler (AccessProfiler const &) = delete;
+	AccessProfiler &operator = (AccessProfiler const &) = delete;
+
+	/// \brief Return the clock of the latency measurement in nanoseconds
+	static uint64_t now ();
+
+	/** \brief Record an access by the calling thread
+	 *
+	 * @param key Name or path which was looked up
+	 * @param kind Result of the access
+	 * @param nanoseconds Latency of the lookup. Not recorded for \ref Defaulted
+	 */
+	void record (std::string const &key,AccessKindEnum kind,uint64_t nanoseconds);
+
+	/// \brief Merge the shards of all threads, and return the counters sorted by the number of lookups, most first
+	PropertyAccessProfile collect () const;
+
+	/// \brief Clear all counters
+	void reset ();
+
+private:
+
+	/// Counters of one thread
+	struct Shard {
+		std::mutex mutex;
+		std::unordered_map<std::string,PropertyAccessStats> keys;
+	};
+
+	/// Identity of the profiler. Unique in the process
+	uint64_t const id;
+
+	/// Protects \ref shards
+	mutable std::mutex shardsMutex;
+
+	/// Shards of all threads which recorded anything. The threads refer to them weakly.
+	std::vector<std::shared_ptr<Shard>> shards;
+
+	/// \brief Return the shard of the calling thread, and create it on first use
+	Shard &localShard ();
+
+};
+
+} /* namespace Properties4CXX */
+
+#endif /* SRC_ACCESSPROFILER_H_ */
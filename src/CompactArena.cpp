@@ -0,0 +1,111 @@
+/*
+ * CompactArena.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstdint>
+#include <new>
+
+#include "CompactArena.h"
+
+namespace Properties4CXX {
+
+// The buffer behind the arena object is aligned for any object.
+static size_t const arenaObjectSize = (sizeof(CompactArena) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+static inline size_t alignUp (size_t offset,size_t alignment) {
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+CompactArena *CompactArena::create (size_t capacity,std::pmr::memory_resource *upstream) {
+
+	size_t const allocatedSize = arenaObjectSize + capacity;
+	char *mem = static_cast<char*>(upstream->allocate(allocatedSize,alignof(std::max_align_t)));
+
+	return new (mem) CompactArena(mem + arenaObjectSize,capacity,allocatedSize,upstream);
+}
+
+CompactArena::CompactArena (char *buffer,size_t capacity,size_t allocatedSize,std::pmr::memory_resource *upstream)
+:buffer{buffer},
+ capacity{capacity},
+ allocatedSize{allocatedSize},
+ upstream{upstream}
+{ }
+
+void *CompactArena::do_allocate (size_t bytes,size_t alignment) {
+
+	void *rc = nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(allocateMutex);
+
+		requiredSize = alignUp(requiredSize,alignment) + bytes;
+
+		if (alignment <= alignof(std::max_align_t)) {
+			size_t const start = alignUp(usedSize,alignment);
+			if (start + bytes <= capacity) {
+				usedSize = start + bytes;
+				rc = buffer + start;
+			}
+		}
+	}
+
+	if (!rc) {
+		rc = upstream->allocate(bytes,alignment);
+	}
+
+	references.fetch_add(1,std::memory_order_relaxed);
+
+	return rc;
+}
+
+void CompactArena::do_deallocate (void *p,size_t bytes,size_t alignment) {
+
+	uintptr_t const offset = reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(buffer);
+
+	// Addresses below the buffer wrap around to large offsets.
+	if (offset >= capacity) {
+		upstream->deallocate(p,bytes,alignment);
+	}
+
+	unref();
+
+}
+
+void CompactArena::unref () {
+
+	if (references.fetch_sub(1,std::memory_order_acq_rel) == 1) {
+		std::pmr::memory_resource *const upstream = this->upstream;
+		size_t const allocatedSize = this->allocatedSize;
+
+		this->~CompactArena();
+		upstream->deallocate(this,allocatedSize,alignof(std::max_align_t));
+	}
+
+}
+
+} /* namespace Properties4CXX */
@@ -0,0 +1,152 @@
+/*
+ * CompactArena.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SRC_COMPACTARENA_H_
+#define SRC_COMPACTARENA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+#include "Properties4CXX/Properties.h"
+
+namespace Properties4CXX {
+
+/** \brief Memory resource of a compacted configuration. \see Properties::compact()
+ *
+ * The arena object and its buffer are one allocation from the upstream resource.
+ * Allocations are carved from the buffer in sequence. When the buffer is exhausted they are passed to the upstream resource.
+ * Memory in the buffer is not reused when it is deallocated.
+ *
+ * The arena counts its owner and all live allocations. It destroys itself when the owner released it,
+ * and all allocations were returned. Thus properties which are still shared after the configuration was deleted
+ * keep it alive.
+ *
+ * Allocation is serialized by a mutex because parallel parsing and \ref Properties::loadDirectory allocate
+ * from several threads.
+ */
+class PROPERTIES4CXX_LOCAL
+CompactArena: public std::pmr::memory_resource {
+public:
+
+	/// \brief Deleter for std::unique_ptr which releases the owner reference
+	struct Releaser {
+		void operator () (CompactArena *arena) const {
+			arena->release();
+		}
+	};
+
+	/** \brief Create an arena
+	 *
+	 * @param capacity Size of the buffer. With 0 all allocations are passed to \p upstream. Use it to measure the required size.
+	 * @param upstream Resource of the arena itself, and of allocations which do not fit into the buffer
+	 * @return New arena. The caller owns it, and must call \ref release() when it is done.
+	 */
+	static CompactArena *create (size_t capacity,std::pmr::memory_resource *upstream);
+
+	CompactArena (CompactArena const &) = delete;
+	CompactArena &operator = (CompactArena const &) = delete;
+
+	/// \brief Add another owner reference, e.g. for a copy of the configuration which allocates from the arena
+	void addOwner () {
+		references.fetch_add(1,std::memory_order_relaxed);
+	}
+
+	/// \brief Release the owner reference. The arena is deleted when no allocation is left.
+	void release () {
+		unref();
+	}
+
+	/// \brief Return the resource of the arena, and of the allocations which do not fit into the buffer
+	std::pmr::memory_resource *getUpstream () const {
+		return upstream;
+	}
+
+	/** \brief Return the buffer size which would hold all allocations so far
+	 *
+	 * It includes the alignment gaps. Allocations which were passed to the upstream resource are included.
+	 */
+	size_t getRequiredSize () const {
+		return requiredSize;
+	}
+
+	/// \brief Return the size of the buffer
+	size_t getCapacity () const {
+		return capacity;
+	}
+
+	/// \brief Return the number of bytes of the buffer which were handed out
+	size_t getUsedSize () const {
+		return usedSize;
+	}
+
+protected:
+
+	void *do_allocate (size_t bytes,size_t alignment) override;
+
+	void do_deallocate (void *p,size_t bytes,size_t alignment) override;
+
+	bool do_is_equal (std::pmr::memory_resource const &other) const noexcept override {
+		return this == &other;
+	}
+
+private:
+
+	CompactArena (char *buffer,size_t capacity,size_t allocatedSize,std::pmr::memory_resource *upstream);
+
+	~CompactArena () = default;
+
+	/// \brief Drop one reference, and delete the arena with the last one
+	void unref ();
+
+	/// Start of the buffer. It is located directly behind the arena object.
+	char *const buffer;
+
+	/// Size of the buffer
+	size_t const capacity;
+
+	/// Size of the allocation which holds the arena and the buffer
+	size_t const allocatedSize;
+
+	std::pmr::memory_resource *const upstream;
+
+	/// Serializes \ref do_allocate
+	std::mutex allocateMutex;
+
+	/// Bytes of the buffer handed out, including alignment gaps
+	size_t usedSize = 0;
+
+	/// \see getRequiredSize()
+	size_t requiredSize = 0;
+
+	/// Owner reference plus one reference per live allocation
+	std::atomic<size_t> references {1};
+
+};
+
+} /* namespace Properties4CXX */
+
+#endif /* SRC_COMPACTARENA_H_ */
@@ -0,0 +1,313 @@
+/*
+ * IncludeCache.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <chrono>
+
+#include "IncludeCache.h"
+
+namespace Properties4CXX {
+
+thread_local std::vector<std::pair<std::string,IncludeCache::FileStampList>> IncludeCache::loadingStack;
+
+IncludeCache &IncludeCache::getInstance() {
+	static IncludeCache instance;
+
+	return instance;
+}
+
+IncludeCache::FileStamp IncludeCache::readFile (std::string const &canonicalPath,std::string &text) {
+
+	FileStamp rc {canonicalPath,0,0,std::filesystem::file_time_type(),false};
+	std::error_code ec;
+
+	// Stamp before reading. A modification while it is read changes the stamp then.
+	rc.size = std::filesystem::file_size(canonicalPath,ec);
+	if (!ec) {
+		rc.modificationTime = std::filesystem::last_write_time(canonicalPath,ec);
+	}
+	// File systems with a coarse time resolution can modify a file again within the same time stamp.
+	rc.timeConclusive = !ec && rc.modificationTime < std::filesystem::file_time_type::clock::now() - std::chrono::seconds(2);
+
+	std::ifstream fileStream (canonicalPath,std::ios::in | std::ios::binary);
+
+	if (!fileStream.is_open()) {
+		std::string errStr ("Cannot open included configuration file \"");
+		errStr.append(canonicalPath).append("\".");
+		throw ExceptionConfigFileOpenError(errStr.c_str());
+	}
+
+	text.assign(std::istreambuf_iterator<char>(fileStream),std::istreambuf_iterator<char>());
+
+	if (fileStream.bad()) {
+		std::string errStr ("Cannot read included configuration file \"");
+		errStr.append(canonicalPath).append("\".");
+		throw ExceptionConfigReadError(errStr.c_str());
+	}
+
+	rc.hash = hashString(text.data(),text.size());
+
+	return rc;
+}
+
+bool IncludeCache::filesUnchanged (FileStampList &files) {
+
+	std::string text;
+
+	for (auto &it : files) {
+		std::error_code ec;
+		uintmax_t const size = std::filesystem::file_size(it.path,ec);
+
+		if (ec) {
+			// Let the parser report the missing file.
+			return false;
+		}
+
+		if (it.timeConclusive && size == it.size) {
+			auto const modificationTime = std::filesystem::last_write_time(it.path,ec);
+
+			if (!ec && modificationTime == it.modificationTime) {
+				continue;
+			}
+		}
+
+		FileStamp stamp;
+		try {
+			stamp = readFile(it.path,text);
+		} catch (ExceptionBase const &) {
+			return false;
+		}
+
+		if (stamp.hash != it.hash) {
+			return false;
+		}
+
+		// Touched, but the same text. Do not read it again next time.
+		it = std::move(stamp);
+	}
+
+	return true;
+}
+
+void IncludeCache::checkWaitCycle (Loading const &loading,std::string const &canonicalPath) const {
+
+	std::thread::id const self = std::this_thread::get_id();
+	std::thread::id owner = loading.owner;
+
+	// Follow the threads which wait for each other. When the chain ends in this thread they would wait forever.
+	for (size_t i = 0; i <= waiting.size(); i++) {
+		if (owner == self) {
+			std::string errStr ("Configuration file \"");
+			errStr.append(canonicalPath).append("\" includes itself.");
+			throw ExceptionConfigReadError(errStr.c_str());
+		}
+
+		auto it = waiting.find(owner);
+		if (it == waiting.end()) {
+			break;
+		}
+		owner = it->second->owner;
+	}
+
+}
+
+void IncludeCache::removeUnused () {
+
+	for (auto it = entries.begin(); it != entries.end();) {
+		bool used = it->second.loading || !it->second.properties || it->second.properties.use_count() > 1;
+
+		if (!used) {
+			for (auto const &prop : it->second.properties->getCPropertyMap()) {
+				if (prop.second.use_count() > 1) {
+					used = true;
+					break;
+				}
+			}
+		}
+
+		if (used) {
+			++it;
+		} else {
+			it = entries.erase(it);
+		}
+	}
+
+}
+
+std::shared_ptr<Properties const> IncludeCache::load (std::string const &fileName,std::string const &includeDir) {
+
+	std::filesystem::path filePath (fileName);
+	if (filePath.is_relative() && !includeDir.empty()) {
+		filePath = std::filesystem::path(includeDir) / filePath;
+	}
+
+	std::error_code ec;
+	std::string const canonicalPath = std::filesystem::canonical(filePath,ec).string();
+
+	if (ec) {
+		std::string errStr ("Cannot open included configuration file \"");
+		errStr.append(filePath.string()).append("\": ").append(ec.message());
+		throw ExceptionConfigFileOpenError(errStr.c_str());
+	}
+
+	for (auto const &it : loadingStack) {
+		if (it.first == canonicalPath) {
+			std::string errStr ("Configuration file \"");
+			errStr.append(canonicalPath).append("\" includes itself.");
+			throw ExceptionConfigReadError(errStr.c_str());
+		}
+	}
+
+	std::shared_ptr<Properties const> rc;
+	FileStampList files;
+	std::unique_lock<std::mutex> lock (mutex);
+
+	for (;;) {
+		auto it = entries.find(canonicalPath);
+
+		if (it != entries.end() && it->second.loading) {
+			// Another thread parses it. Wait for its result.
+			std::shared_ptr<Loading> loading = it->second.loading;
+			std::thread::id const self = std::this_thread::get_id();
+
+			checkWaitCycle(*loading,canonicalPath);
+			waiting[self] = loading.get();
+			loaded.wait(lock,[&loading] { return loading->finished; });
+			waiting.erase(self);
+
+			if (loading->exception) {
+				std::rethrow_exception(loading->exception);
+			}
+			rc = loading->properties;
+			files = loading->files;
+			break;
+		}
+
+		if (it != entries.end() && it->second.properties) {
+			// Check the files without the lock. Other threads can load other fragments meanwhile.
+			std::shared_ptr<Properties const> cached = it->second.properties;
+			files = it->second.files;
+
+			lock.unlock();
+			bool const unchanged = filesUnchanged(files);
+			lock.lock();
+
+			it = entries.find(canonicalPath);
+			if (unchanged) {
+				if (it != entries.end() && it->second.properties == cached) {
+					it->second.files = files;
+				}
+				rc = cached;
+				break;
+			}
+			if (it != entries.end() && it->second.loading) {
+				// Another thread started to parse it meanwhile.
+				continue;
+			}
+		}
+
+		// Parse it in this thread.
+		auto loading = std::make_shared<Loading>();
+		loading->owner = std::this_thread::get_id();
+		entries[canonicalPath].loading = loading;
+		lock.unlock();
+
+		try {
+			std::string text;
+			FileStamp stamp = readFile(canonicalPath,text);
+
+			auto fragment = std::make_shared<Properties>(canonicalPath);
+			fragment->includeDir = std::filesystem::path(canonicalPath).parent_path().string();
+
+			loadingStack.emplace_back(canonicalPath,FileStampList{std::move(stamp)});
+			try {
+				if (!text.empty()) {
+					fragment->parseChunk(text.data(),text.size(),1,0);
+				}
+			} catch (...) {
+				loadingStack.pop_back();
+				throw;
+			}
+			files.swap(loadingStack.back().second);
+			loadingStack.pop_back();
+			rc = fragment;
+		} catch (...) {
+			lock.lock();
+			loading->exception = std::current_exception();
+			loading->finished = true;
+			// The old fragment is outdated too.
+			auto failedIt = entries.find(canonicalPath);
+			if (failedIt != entries.end() && failedIt->second.loading == loading) {
+				entries.erase(failedIt);
+			}
+			loaded.notify_all();
+			throw;
+		}
+
+		lock.lock();
+		loading->properties = rc;
+		loading->files = files;
+		loading->finished = true;
+		removeUnused();
+		Entry &entry = entries[canonicalPath];
+		entry.files = files;
+		entry.properties = rc;
+		entry.loading.reset();
+		loaded.notify_all();
+		break;
+	}
+
+	lock.unlock();
+
+	// The including fragment depends on the files of this one too.
+	if (!loadingStack.empty()) {
+		FileStampList &parentFiles = loadingStack.back().second;
+		parentFiles.insert(parentFiles.end(),files.begin(),files.end());
+	}
+
+	return rc;
+}
+
+void IncludeCache::clear () {
+	std::lock_guard<std::mutex> lock (mutex);
+
+	// Fragments which are parsed right now are finished by their threads.
+	for (auto it = entries.begin(); it != entries.end();) {
+		if (it->second.loading) {
+			it->second.properties.reset();
+			++it;
+		} else {
+			it = entries.erase(it);
+		}
+	}
+}
+
+} /* namespace Properties4CXX */
@@ -0,0 +1,173 @@
+/*
+ * IncludeCache.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SRC_INCLUDECACHE_H_
+#define SRC_INCLUDECACHE_H_
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <utility>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <exception>
+#include <filesystem>
+#include <string>
+
+#include "Properties4CXX/Properties.h"
+
+namespace Properties4CXX {
+
+/** \brief Process wide cache of configuration fragments which are loaded with the include directive
+ *
+ * A fragment is identified by the canonical path of its file. Each time it is included the size and modification time
+ * of the file and of all files which it includes itself are compared with the ones when they were read.
+ * Only files with a different size or time, or which were modified just before they were read, are read and fingerprinted again.
+ * When all files are unchanged the cached properties are returned. Otherwise the fragment is parsed again, and replaces the cached one.
+ *
+ * The includers share the property objects of the fragment instead of copying them.
+ * The cache hands out the fragments as const. They must not be modified.
+ * Fragments which no configuration uses any more are removed when another fragment is added.
+ *
+ * The cache is not locked while a fragment is parsed. Other threads which include the same fragment meanwhile
+ * wait for the result instead of parsing it too. Other fragments are loaded in parallel.
+ */
+class PROPERTIES4CXX_LOCAL
+IncludeCache {
+public:
+
+	/** \brief Return the process wide cache. The cache is created on first use.
+	 *
+	 * @return Reference to the cache
+	 */
+	static IncludeCache &getInstance();
+
+	/** \brief Return the parsed fragment of an included file
+	 *
+	 * @param fileName Name of the included file as written in the include directive
+	 * @param includeDir Directory against which a relative \p fileName is resolved. Empty for the current directory.
+	 * @return The properties of the fragment
+	 * @throws ExceptionConfigFileOpenError when the file cannot be opened
+	 * @throws ExceptionConfigReadError when the file cannot be read, or includes itself directly or indirectly
+	 * @throws ExceptionPropertyDuplicate when the fragment contains a property twice
+	 */
+	std::shared_ptr<Properties const> load (std::string const &fileName,std::string const &includeDir);
+
+	/// \brief Remove all fragments from the cache
+	void clear ();
+
+private:
+
+	IncludeCache() = default;
+
+	/// \brief Identification of the text of a file
+	struct FileStamp {
+		/// Canonical path of the file
+		std::string path;
+		/// Fingerprint of the text
+		uint64_t hash;
+		/// Size of the file when it was read
+		uintmax_t size;
+		/// Modification time of the file when it was read
+		std::filesystem::file_time_type modificationTime;
+		/// \ref modificationTime was old enough when the file was read.
+		/// Otherwise a modification in the same clock tick would keep it, and it proves nothing.
+		bool timeConclusive;
+	};
+
+	/// \brief Stamps of files
+	typedef std::vector<FileStamp> FileStampList;
+
+	/// \brief A fragment which one thread currently parses. Other threads wait for it.
+	struct Loading {
+		/// The parsing thread
+		std::thread::id owner;
+		/// The parse is finished. The other members are set.
+		bool finished = false;
+		/// The parsed properties. Empty when the parse failed
+		std::shared_ptr<Properties const> properties;
+		/// The files of the fragment
+		FileStampList files;
+		/// Exception of the failed parse
+		std::exception_ptr exception;
+	};
+
+	/// \brief A parsed fragment
+	struct Entry {
+		/// The file of the fragment itself, and all files which it includes directly or indirectly,
+		/// with their stamps when the fragment was parsed
+		FileStampList files;
+		/// The parsed properties. Empty while the fragment is parsed the first time
+		std::shared_ptr<Properties const> properties;
+		/// Set while a thread parses the fragment
+		std::shared_ptr<Loading> loading;
+	};
+
+	/// \brief Parsed fragments. Key is the canonical path of the file.
+	std::map<std::string,Entry> entries;
+
+	/// \brief Threads which wait for a fragment which another thread parses. Used to detect include cycles across threads.
+	std::map<std::thread::id,Loading const *> waiting;
+
+	/// \brief Fragments which the current thread parses, innermost last, with the files which they included so far.
+	/// Used to detect include cycles, and to collect the included files of a fragment.
+	static thread_local std::vector<std::pair<std::string,FileStampList>> loadingStack;
+
+	/// \brief Protects \ref entries, \ref waiting, and the \ref Loading objects
+	std::mutex mutex;
+
+	/// \brief Notified when a \ref Loading is finished
+	std::condition_variable loaded;
+
+	/** \brief Read a file completely, and stamp it
+	 *
+	 * @param canonicalPath Canonical path of the file
+	 * @param[out] text Content of the file
+	 * @return The stamp of the file
+	 * @throws ExceptionConfigFileOpenError
+	 * @throws ExceptionConfigReadError
+	 */
+	static FileStamp readFile (std::string const &canonicalPath,std::string &text);
+
+	/** \brief Return true when all files in \p files have the same text as listed
+	 *
+	 * A file is only read again when its size or modification time changed, or when the time is not conclusive.
+	 * When the text is still the same the stamp is updated.
+	 */
+	static bool filesUnchanged (FileStampList &files);
+
+	/// \brief Throw ExceptionConfigReadError when waiting for \p loading closes a cycle of waiting threads. Call with \ref mutex locked.
+	void checkWaitCycle (Loading const &loading,std::string const &canonicalPath) const;
+
+	/// \brief Remove the fragments which no configuration uses any more. Call with \ref mutex locked.
+	void removeUnused ();
+
+};
+
+} /* namespace Properties4CXX */
+
+#endif /* SRC_INCLUDECACHE_H_ */
@@ -0,0 +1,287 @@
+/*
+ * LayeredProperties.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <sstream>
+
+#include "Properties4CXX/LayeredProperties.h"
+
+namespace Properties4CXX {
+
+/** \brief Call \p func with the path of each property of \p properties and its sub-structures
+ *
+ * @param properties Configuration
+ * @param prefix Path of the structure including the trailing dot
+ * @param func Function which is called with each path
+ */
+template <typename F>
+static void forEachPath (Properties const &properties,std::string const &prefix,F const &func) {
+
+	for (auto const &it : properties.getCPropertyMap()) {
+		std::string path = prefix + it.first;
+
+		func(path);
+		if (it.second->isStruct()) {
+			forEachPath(it.second->getPropertiesStructure(),path + '.',func);
+		}
+	}
+
+}
+
+/// \brief Second hash value for double hashing in the Bloom filters. It must be odd.
+static inline uint64_t filterStep (uint64_t pathHash) {
+	return hashCombine(pathHash,0x9e3779b97f4a7c15ULL) | 1;
+}
+
+void LayeredProperties::buildFilter (Layer &layer) {
+
+	size_t numPaths = 0;
+	forEachPath(*layer.properties,std::string(),[&numPaths] (std::string const &) {
+		numPaths++;
+	});
+
+	// About 10 bits per path give less than 1% false positives with 7 hashes.
+	size_t numBits = 64;
+	while (numBits < numPaths * 10) {
+		numBits *= 2;
+	}
+
+	layer.filterBits.assign(numBits / 64,0);
+	layer.contentHash = layer.properties->getContentHash();
+
+	forEachPath(*layer.properties,std::string(),[&layer,numBits] (std::string const &path) {
+		uint64_t pos = hashString(path);
+		uint64_t const step = filterStep(pos);
+
+		for (unsigned i = 0; i < numFilterHashes; i++) {
+			size_t const bit = pos & (numBits - 1);
+			layer.filterBits[bit / 64] |= uint64_t(1) << (bit % 64);
+			pos += step;
+		}
+	});
+
+}
+
+bool LayeredProperties::mayContain (Layer const &layer,uint64_t pathHash) {
+
+	if (layer.contentHash != layer.properties->getContentHash()) {
+		// The layer was modified. The filter may miss new properties.
+		return true;
+	}
+
+	size_t const numBits = layer.filterBits.size() * 64;
+	uint64_t pos = pathHash;
+	uint64_t const step = filterStep(pos);
+
+	for (unsigned i = 0; i < numFilterHashes; i++) {
+		size_t const bit = pos & (numBits - 1);
+		if (!(layer.filterBits[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+			return false;
+		}
+		pos += step;
+	}
+
+	return true;
+}
+
+void LayeredProperties::pushLayer (Properties const &layer) {
+
+	layers.push_back(Layer{&layer,0,{}});
+	buildFilter(layers.back());
+
+}
+
+void LayeredProperties::refresh () {
+
+	for (auto &it : layers) {
+		if (it.contentHash != it.properties->getContentHash()) {
+			buildFilter(it);
+		}
+	}
+
+}
+
+Property const *LayeredProperties::findPropertyPath (std::string const &propertyPath) const {
+
+	uint64_t const pathHash = hashString(propertyPath);
+
+	for (auto it = layers.crbegin(); it != layers.crend(); ++it) {
+		if (mayContain(*it,pathHash)) {
+			Property const *prop = it->properties->findPropertyPath(propertyPath);
+			if (prop) {
+				return prop;
+			}
+		}
+	}
+
+	return nullptr;
+
+}
+
+Property const *LayeredProperties::searchPropertyPath (std::string const &propertyPath) const {
+
+	Property const *prop = findPropertyPath(propertyPath);
+	if (!prop) {
+		std::string errText = "Cannot find property ";
+		errText.append(propertyPath);
+		throw ExceptionPropertyNotFound(errText.c_str());
+	}
+
+	return prop;
+
+}
+
+bool LayeredProperties::getPropertyValue (std::string const &propertyPath,bool defaultVal) const {
+
+	Property const *prop = findPropertyPath(propertyPath);
+
+	return prop ? prop->getBoolValue() : defaultVal;
+}
+
+double LayeredProperties::getPropertyValue (std::string const &propertyPath,double defaultVal) const {
+
+	Property const *prop = findPropertyPath(propertyPath);
+
+	return prop ? prop->getDoubleValue() : defaultVal;
+}
+
+long long LayeredProperties::getPropertyValue (std::string const &propertyPath,long long defaultVal) const {
+
+	Property const *prop = findPropertyPath(propertyPath);
+
+	return prop ? prop->getIntVal() : defaultVal;
+}
+
+char const * LayeredProperties::getPropertyValue (std::string const &propertyPath,char const * defaultVal) const {
+
+	Property const *prop = findPropertyPath(propertyPath);
+
+	if (!prop) {
+		return defaultVal;
+	}
+
+	if (prop->isStruct()) {
+		std::ostringstream strstr;
+		strstr << "Property " << propertyPath << " is not a scalar value but a struct.";
+
+		throw ExceptionWrongPropertyType(strstr.str());
+	}
+
+	return prop->getStrValue();
+
+}
+
+LayeredProperties::const_iterator LayeredProperties::begin () const {
+
+	std::vector<Properties const *> layerProperties;
+	for (auto it = layers.crbegin(); it != layers.crend(); ++it) {
+		layerProperties.push_back(it->properties);
+	}
+
+	return const_iterator(layerProperties);
+
+}
+
+LayeredProperties::const_iterator::const_iterator (std::vector<Properties const *> const &layers) {
+
+	Frame frame;
+
+	for (auto it : layers) {
+		frame.positions.emplace_back(it->getFirstProperty(),it->getListEnd());
+	}
+
+	stack.push_back(std::move(frame));
+	settle();
+
+}
+
+void LayeredProperties::const_iterator::settle () {
+
+	while (!stack.empty()) {
+		Frame &frame = stack.back();
+		std::string const *name = nullptr;
+
+		// The smallest name of all layers on this level is next.
+		for (auto const &it : frame.positions) {
+			if (it.first != it.second && (!name || it.first->first < *name)) {
+				name = &it.first->first;
+			}
+		}
+
+		if (!name) {
+			stack.pop_back();
+			continue;
+		}
+
+		std::string path = frame.prefix + *name;
+		Frame subFrame;
+		Property const *winner = nullptr;
+		bool descend = false;
+
+		for (auto &it : frame.positions) {
+			if (it.first == it.second || it.first->first != *name) {
+				continue;
+			}
+
+			Property const *prop = it.first->second.get();
+
+			if (!winner) {
+				winner = prop;
+				descend = prop->isStruct();
+			}
+
+			// Structures are merged down to the first layer where the name is no structure.
+			if (descend) {
+				if (prop->isStruct()) {
+					Properties const &sub = prop->getPropertiesStructure();
+					subFrame.positions.emplace_back(sub.getFirstProperty(),sub.getListEnd());
+				} else {
+					descend = false;
+				}
+			}
+
+			// name stays valid. It points to a key in the map, not into the iterator.
+			++it.first;
+		}
+
+		if (winner->isStruct()) {
+			subFrame.prefix = path + '.';
+			stack.push_back(std::move(subFrame));
+			continue;
+		}
+
+		current.path = std::move(path);
+		current.property = winner;
+		return;
+	}
+
+	current = Entry{std::string(),nullptr};
+
+}
+
+} /* namespace Properties4CXX */
@@ -28,249 +28,2997 @@
 #endif
 
 #include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <exception>
+#include <cerrno>
+#include <cstdlib>
+#include <cctype>
+#include <climits>
+#include <atomic>
+#include <mutex>
+#include <list>
+#include <set>
+#include <unordered_set>
+
+#if defined _WIN32 && !defined __CYGWIN__
+#  include <io.h>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <share.h>
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+#if PROPERTIES4CXX_PARSE_STATS && HAVE_MALLINFO2
+#  include <malloc.h>
+#endif
+
+#include "parserTypes.h"
+#include "ThreadPool.h"
+#include "IncludeCache.h"
+#include "AccessProfiler.h"
+#include "CompactArena.h"
+#include "Properties4CXX/Properties.h"
+#include "Properties4CXX/Property.h"
+#include "Properties4CXX/PropertiesWriter.h"
+
+#include "parser.hh"
+#include "lexer.h"
+
+#if defined _WIN32 && !defined __CYGWIN__
+#  define PROPERTIES4CXX_ENVIRON _environ
+#else
+extern char **environ;
+#  define PROPERTIES4CXX_ENVIRON environ
+#endif
+
+namespace Properties4CXX {
+
+ExceptionBase::~ExceptionBase () {}
+
+const char* ExceptionBase::what() const noexcept {
+	return description.c_str();
+}
+
+ExceptionConfigReadError::~ExceptionConfigReadError () {}
+
+ExceptionConfigWriteError::~ExceptionConfigWriteError () {}
+
+ExceptionConfigFileOpenError::~ExceptionConfigFileOpenError () {}
+
+ExceptionPropertyNotFound::~ExceptionPropertyNotFound () {}
+
+ExceptionPropertyDuplicate::~ExceptionPropertyDuplicate () {}
+
+ExceptionInterpolationCycle::~ExceptionInterpolationCycle () {}
+
+ExceptionPropertiesFrozen::~ExceptionPropertiesFrozen () {}
+
+Properties::Properties ()
+:configFileManagedInternally{false},
+ inputStream{0}
+{ }
+
+Properties::Properties (std::pmr::memory_resource *memoryResource)
+:configFileManagedInternally{false},
+ inputStream{0},
+ memoryResource{memoryResource ? memoryResource : std::pmr::get_default_resource()}
+{ }
+
+Properties::Properties (char const *configFileName,std::pmr::memory_resource *memoryResource)
+:configFileName{configFileName},
+ configFileManagedInternally{true},
+ inputStream{0},
+ memoryResource{memoryResource ? memoryResource : std::pmr::get_default_resource()}
+{ }
+
+Properties::Properties (std::string const &configFileName,std::pmr::memory_resource *memoryResource)
+:configFileName{configFileName},
+ configFileManagedInternally{true},
+ inputStream{0},
+ memoryResource{memoryResource ? memoryResource : std::pmr::get_default_resource()}
+{ }
+
+Properties::Properties (std::istream *iStream,std::pmr::memory_resource *memoryResource)
+:configFileManagedInternally{false},
+ inputStream{iStream},
+ memoryResource{memoryResource ? memoryResource : std::pmr::get_default_resource()}
+{ }
+
+Properties::Properties (Properties const &other)
+:structLevel{other.structLevel},
+ configFileName{other.configFileName},
+ configFileManagedInternally{other.configFileManagedInternally},
+ inputStream{other.configFileManagedInternally ? nullptr : other.inputStream},
+ parseThreads{other.parseThreads},
+ incrementalReload{other.incrementalReload},
+ includeDir{other.includeDir},
+ environmentOverrides{other.environmentOverrides},
+ memoryResource{other.memoryResource},
+ stringInterner{other.stringInterner},
+ internValues{other.internValues},
+ compactArena{other.compactArena},
+ propertyMap{other.propertyMap},
+ contentHash{other.contentHash}
+{
+	// The copy shares the compacted properties. It owns the arena too.
+	if (compactArena) {
+		compactArena->addOwner();
+	}
+}
+
+Properties::~Properties() {
+
+	// The property map releases its nodes to the arena after this. The arena lives until the last one is gone.
+	if (compactArena) {
+		compactArena->release();
+	}
+
+}
+
+void Properties::setFileName (char const *configName) {
+
+	sourceIndexValid = false;
+	appendStateValid = false;
+	sourceSizeValid = false;
+	inputStream = 0;
+	configFileManagedInternally = true;
+	configFileName = configName;
+
+}
+
+void Properties::setFileName (std::string const configName) {
+
+	sourceIndexValid = false;
+	appendStateValid = false;
+	sourceSizeValid = false;
+	inputStream = 0;
+	configFileManagedInternally = true;
+	configFileName = configName;
+
+}
+
+void Properties::setInputStream (std::istream *iStream){
+
+	sourceIndexValid = false;
+	appendStateValid = false;
+	sourceSizeValid = false;
+	if (inputFileStream.is_open()) {
+		inputFileStream.close();
+	}
+	inputStream = iStream;
+	configFileManagedInternally = false;
+
+}
+
+Properties::PropertyMap &Properties::PropertyMap::operator = (PropertyMap const &other) {
+
+	if (this != &other) {
+		index.clear();
+		index.insert(other.index.begin(),other.index.end());
+	}
+
+	return *this;
+
+}
+
+Properties::PropertyMap &Properties::PropertyMap::operator = (PropertyMap &&other) {
+
+	if (index.get_allocator() == other.index.get_allocator()) {
+		index.swap(other.index);
+		other.index.clear();
+	} else {
+		*this = other;
+	}
+
+	return *this;
+
+}
+
+Properties::PropertyPtr const &Properties::PropertyMap::at (std::string_view name) const {
+
+	auto it = index.find(name);
+
+	if (it == index.end()) {
+		throw std::out_of_range("Properties::PropertyMap::at");
+	}
+
+	return it->second;
+
+}
+
+std::pair<Properties::PropertyMap::const_iterator,bool> Properties::PropertyMap::insert (PropertyPtr const &property) {
+
+	return index.insert(value_type{property->getPropertyName(),property});
+
+}
+
+std::pair<Properties::PropertyMap::const_iterator,bool> Properties::PropertyMap::insert (PropertyPair const &entry) {
+
+	if (!entry.second || entry.first != entry.second->getPropertyName()) {
+		throw std::invalid_argument("Properties::PropertyMap::insert: The name is not the name of the property");
+	}
+
+	return insert(entry.second);
+
+}
+
+void Properties::PropertyMap::assign (PropertyPtr const &property) {
+
+	auto it = index.find(std::string_view(property->getPropertyName()));
+
+	if (it != index.end()) {
+		// The old property may be released. Thus the entry must refer to the name of the new one.
+		it = index.erase(it);
+	}
+	index.insert(it,value_type{property->getPropertyName(),property});
+
+}
+Properties::PropertyMap::size_type Properties::PropertyMap::erase (std::string_view name) {
+
+	auto it = index.find(name);
+
+	if (it == index.end()) {
+		return 0;
+	}
+
+	index.erase(it);
+
+	return 1;
+
+}
+
+void Properties::shiftSourceOffset (ptrdiff_t delta) {
+
+	checkNotFrozen("shiftSourceOffset");
+
+	for (auto const &it : *propertyMap) {
+		it.second->shiftSourceOffset(delta);
+	}
+
+}
+
+void Properties::setStructLevel (int structLevel) {
+
+	checkNotFrozen("setStructLevel");
+
+	this->structLevel = structLevel;
+
+	bool const mapShared = propertyMap.use_count() > 1;
+	std::vector<PropertyPtr> replacements;
+
+	for (auto const &it : *propertyMap) {
+		if (it.second->getStructLevel() != structLevel) {
+			// Included properties, and the ones of copies are shared. They are replaced by copies on this level.
+			if (!mapShared && isExclusive(it.second)) {
+				it.second->setStructLevel(structLevel);
+			} else {
+				replacements.push_back(copyWithStructLevel(*it.second,structLevel));
+			}
+		}
+	}
+
+	if (!replacements.empty()) {
+		PropertyMap &map = writablePropertyMap();
+
+		for (auto const &it : replacements) {
+			map.assign(it);
+		}
+	}
+}
+
+/** \brief Run the parser
+ *
+ * When statistics are collected the time of the parser without the scanner and reading the input is accounted.
+ *
+ * @param scanner The initialized scanner
+ * @param properties Configuration which receives the properties
+ * @param scanContext Context of \p scanner
+ */
+static void runParser (yyscan_t scanner,Properties *properties,tScanContext const &scanContext) {
+
+#if PROPERTIES4CXX_PARSE_STATS
+	ParseStats *stats = scanContext.parseStats;
+
+	if (stats) {
+		uint64_t const start = parseStatsNow();
+		uint64_t const scanBefore = stats->scanNanoseconds + stats->ioNanoseconds;
+
+		yyparse(scanner,properties);
+		stats->parseNanoseconds += parseStatsNow() - start - (stats->scanNanoseconds + stats->ioNanoseconds - scanBefore);
+		return;
+	}
+#else
+	(void)scanContext;
+#endif
+
+	yyparse(scanner,properties);
+}
+
+void Properties::readConfiguration() {
+
+	checkNotFrozen("readConfiguration");
+
+	std::string buffer;
+	bool const parseFromBuffer = parseThreads > 1 || incrementalReload;
+
+	appendStateValid = false;
+	sourceSizeValid = false;
+	sourceHash = StreamHash();
+	updateIncludeDir();
+	invalidateInterpolation();
+	PROPERTIES4CXX_PARSE_STATS_ONLY(startParseStats();)
+
+	if (parseFromBuffer) {
+		openInput();
+
+		try {
+			appendStreamStart = getInputStream().tellg();
+			readInputIntoBuffer(buffer);
+		} catch (...) {
+			closeInput();
+			throw;
+		}
+
+		closeInput();
+
+		if (incrementalReload && sourceIndexValid && reparseChangedEntries(buffer)) {
+			setAppendState(buffer);
+			setAppendSourceHash(buffer);
+			appendStateValid = appendStreamStart >= 0;
+			sourceSize = buffer.size();
+			sourceSizeValid = true;
+			return;
+		}
+	}
+
+	// The old configuration is only needed to tell subscribers what changed.
+	std::shared_ptr<PropertyMap> oldPropertyMap;
+	if (!subscriptions.empty()) {
+		oldPropertyMap = propertyMap;
+	}
+
+	// Start with an empty properties list. Copies of this configuration keep the old one.
+	propertyMap = newPropertyMap(memoryResource);
+	contentHash = 0;
+	sourceIndexValid = false;
+	hasIncludes = false;
+
+	PROPERTIES4CXX_PARSE_STATS_ONLY(uint64_t buildStart = 0;)
+
+	if (parseFromBuffer) {
+		parseBuffer(buffer.data(),buffer.size(),parseThreads);
+		sourceSize = buffer.size();
+		PROPERTIES4CXX_PARSE_STATS_ONLY(buildStart = collectParseStats ? parseStatsNow() : 0;)
+		applyEnvironmentOverrides(nullptr,nullptr);
+
+		// Changes of included files are not visible in the text. Always reload them completely.
+		if (incrementalReload && !hasIncludes) {
+			buildSourceIndex(buffer);
+		}
+	} else {
+		openInput();
+
+		try {
+			appendStreamStart = getInputStream().tellg();
+
+			// the Flex scanner context
+			void *scanner = 0;
+			tScanContext scanContext;
+			scanContext.properties = this;
+			scanContext.includeDir = includeDir;
+			scanContext.nameInterner = getStringInterner().get();
+			scanContext.valueInterner = internValues ? scanContext.nameInterner : nullptr;
+			PROPERTIES4CXX_PARSE_STATS_ONLY(scanContext.parseStats = collectParseStats ? &parseStats : nullptr;)
+
+			yylex_init_extra(&scanContext,&scanner);
+			YY_BUFFER_STATE buf =  yy_create_buffer ( 0, YY_BUF_SIZE ,scanner);
+			yy_flush_buffer(buf,scanner);
+			yy_switch_to_buffer(buf,scanner);
+
+			// yydebug = 1;
+
+			try {
+				runParser(scanner,this,scanContext);
+			} catch (...) {
+				yylex_destroy(scanner);
+				throw;
+			}
+
+			// Releases the buffer too.
+			yylex_destroy(scanner);
+
+			appendOffset = scanContext.lineStartOffset;
+			appendLineNo = scanContext.lineStartLineNo;
+			sourceSize = scanContext.offset;
+			hasIncludes = scanContext.hasIncludes;
+		} catch (...) {
+			closeInput();
+			throw;
+		}
+
+		closeInput();
+		PROPERTIES4CXX_PARSE_STATS_ONLY(buildStart = collectParseStats ? parseStatsNow() : 0;)
+		applyEnvironmentOverrides(nullptr,nullptr);
+	}
+
+	appendStateValid = appendStreamStart >= 0;
+	if (parseFromBuffer) {
+		setAppendSourceHash(buffer);
+	} else {
+		// The text before appendOffset is gone. readAppended() hashes it when needed.
+		appendSourceHashValid = false;
+	}
+	// The source offsets of included properties refer to the included files.
+	sourceSizeValid = !hasIncludes;
+	PROPERTIES4CXX_PARSE_STATS_ONLY(finishParseStats(buildStart);)
+
+	if (!subscriptions.empty()) {
+		PropertyChangeList changes;
+
+		diffPropertyMaps(std::string(),*oldPropertyMap,*propertyMap,changes);
+		notifySubscribers(changes);
+	}
+
+}
+
+void Properties::openInput () {
+
+	if (configFileManagedInternally) {
+		inputFileStream.exceptions(inputFileStream.badbit );
+
+		if (!inputFileStream.is_open()) {
+			try {
+				inputFileStream.open(configFileName.c_str(),inputFileStream.in);
+				if (inputFileStream.fail()) {
+				std::string errStr ("Cannot open configuration file \"");
+				errStr.append(configFileName).append("\".");
+				throw ExceptionConfigFileOpenError(errStr.c_str());
+				}
+			} catch (std::istream::failure const &e) {
+				throw ExceptionConfigFileOpenError(e.what());
+			}
+		}
+	} else {
+		if (!inputStream) {
+			throw ExceptionConfigReadError ("The external input stream is NULL.");
+		} else {
+			if (inputStream->bad()) {
+				throw ExceptionConfigReadError ("The external input stream in BAD state.");
+			}
+		}
+	}
+
+}
+
+void Properties::closeInput () {
+
+	if (configFileManagedInternally && inputFileStream.is_open()) {
+		inputFileStream.close();
+	}
+
+}
+
+void Properties::readInputIntoBuffer (std::string &buffer) {
+	size_t const blockSize = 1024 * 1024;
+	size_t length = 0;
+	int bytesRead;
+
+	do {
+		buffer.resize(length + blockSize);
+		bytesRead = readConfigIntoBuffer(&buffer[length],blockSize);
+		length += bytesRead;
+	} while (bytesRead > 0);
+
+	buffer.resize(length);
+
+}
+
+/** \brief Return if \p c ends an identifier or number token of the scanner
+ *
+ * These are the characters which the scanner excludes from unquoted tokens. A '#' after one of them,
+ * or at the start of the text, starts a comment.
+ */
+static bool isTokenDelimiter (char c) {
+
+	switch (c) {
+	case '\r':
+	case '\n':
+	case ' ':
+	case '\f':
+	case '\t':
+	case '"':
+	case '{':
+	case '}':
+	case ',':
+	case '=':
+		return true;
+	default:
+		return false;
+	}
+
+}
+
+/** \brief Call \p onLineStart for each line which starts on the top level of the configuration
+ *
+ * A line starts on the top level when the preceding line end is outside of quoted strings, comments, and structures.
+ * The properties on the top level can be parsed independently from each other starting at these positions.
+ *
+ * Quoted strings, comments and line ends are recognized like the scanner does:
+ * - A quoted string ends with the first double quote which is not immediately preceded by a backslash.
+ * - A comment starts with '#' at the beginning of a token, and ends before the next line end.
+ * - "\r\n" and "\n\r" are one line end.
+ *
+ * @param buffer Start of the configuration text
+ * @param length Length of the configuration text
+ * @param onLineStart Called with the offset of the line start in \p buffer, and the line number relative to the first line of \p buffer.
+ *   The first line has the number 0, and is not reported.
+ */
+template <typename F>
+static void findTopLevelLineStarts (char const *buffer,size_t length,F const &onLineStart) {
+	bool inQuotedString = false;
+	// The preceding character within a quoted string is an escaping backslash.
+	bool escaped = false;
+	int structDepth = 0;
+	int lineNo = 0;
+
+	for (size_t i = 0; i < length; i++) {
+		char c = buffer[i];
+
+		if (c == '\n' || c == '\r') {
+			if (i + 1 < length && (buffer[i + 1] == '\n' || buffer[i + 1] == '\r') && buffer[i + 1] != c) {
+				i++;
+			}
+			lineNo++;
+
+			if (!inQuotedString && structDepth == 0) {
+				onLineStart(i + 1,lineNo);
+			}
+			continue;
+		}
+
+		if (inQuotedString) {
+			// The quote closes the string after an even run of backslashes, i.e. when it is not escaped itself.
+			if (escaped) {
+				escaped = false;
+			} else if (c == '\\') {
+				escaped = true;
+			} else if (c == '"') {
+				inQuotedString = false;
+			}
+			continue;
+		}
+
+		switch (c) {
+		case '"':
+			inQuotedString = true;
+			break;
+
+		case '{':
+			structDepth++;
+			break;
+
+		case '}':
+			if (structDepth > 0) {
+				structDepth--;
+			}
+			break;
+
+		case '#':
+			// Only a comment at the beginning of a token. Within a token it is part of it.
+			if (i == 0 || isTokenDelimiter(buffer[i - 1])) {
+				while (i + 1 < length && buffer[i + 1] != '\n' && buffer[i + 1] != '\r') {
+					i++;
+				}
+			}
+			break;
+		}
+	}
+
+}
+
+void Properties::parseBuffer (char const *buffer,size_t length,unsigned maxThreads) {
+
+	struct Chunk {
+		size_t offset;
+		size_t length;
+		int firstLineNo;
+		std::unique_ptr<Properties> properties;
+		std::exception_ptr exception;
+	};
+
+	std::vector<Chunk> chunks;
+	size_t numChunks = 1;
+
+	if (maxThreads > 1) {
+		// A few more chunks than threads balance chunks which take longer than others.
+		numChunks = std::min(size_t(maxThreads) * 4,length / minParallelParseSize);
+	}
+
+	if (numChunks <= 1) {
+		appendOffset = 0;
+		appendLineNo = 1;
+		if (length > 0) {
+			parseChunk(buffer,length,1,0);
+		}
+		return;
+	}
+
+	size_t const targetChunkSize = length / numChunks;
+
+	chunks.push_back(Chunk{0,0,1,nullptr,nullptr});
+	findTopLevelLineStarts(buffer,length,[&] (size_t lineStart,int lineNo) {
+		if (lineStart < length && lineStart - chunks.back().offset >= targetChunkSize) {
+			chunks.back().length = lineStart - chunks.back().offset;
+			chunks.push_back(Chunk{lineStart,0,lineNo + 1,nullptr,nullptr});
+		}
+	});
+	chunks.back().length = length - chunks.back().offset;
+
+	// The chunks share the table of this. Create it before.
+	getStringInterner();
+
+	ThreadPool::getInstance().parallelFor(chunks.size(),[&] (size_t i) {
+		try {
+			chunks[i].properties.reset(new Properties(memoryResource));
+			chunks[i].properties->includeDir = includeDir;
+			chunks[i].properties->stringInterner = stringInterner;
+			chunks[i].properties->internValues = internValues;
+			PROPERTIES4CXX_PARSE_STATS_ONLY(chunks[i].properties->collectParseStats = collectParseStats;)
+			chunks[i].properties->parseChunk(buffer + chunks[i].offset,chunks[i].length,chunks[i].firstLineNo,chunks[i].offset);
+		} catch (...) {
+			chunks[i].exception = std::current_exception();
+		}
+	},maxThreads);
+
+	// Merge in the order of the chunks. Thus the first duplicate is reported like by a sequential parser.
+	for (auto const &chunk : chunks) {
+		if (chunk.exception) {
+			std::rethrow_exception(chunk.exception);
+		}
+
+		for (auto const &it : chunk.properties->getCPropertyMap()) {
+			insertProperty(it.second);
+		}
+		hasIncludes |= chunk.properties->hasIncludes;
+		PROPERTIES4CXX_PARSE_STATS_ONLY(mergeParseStats(*chunk.properties);)
+	}
+
+	appendOffset = chunks.back().properties->appendOffset;
+	appendLineNo = chunks.back().properties->appendLineNo;
+
+}
+
+void Properties::parseChunk (char const *buffer,size_t length,int firstLineNo,size_t baseOffset) {
+
+	// the Flex scanner context
+	void *scanner = 0;
+	tScanContext scanContext;
+	scanContext.properties = this;
+	scanContext.offset = baseOffset;
+	scanContext.lineStartOffset = baseOffset;
+	scanContext.lineStartLineNo = firstLineNo;
+	scanContext.includeDir = includeDir;
+	scanContext.nameInterner = getStringInterner().get();
+	scanContext.valueInterner = internValues ? scanContext.nameInterner : nullptr;
+	PROPERTIES4CXX_PARSE_STATS_ONLY(scanContext.parseStats = collectParseStats ? &parseStats : nullptr;)
+
+	yylex_init_extra(&scanContext,&scanner);
+	yy_scan_bytes(buffer,length,scanner);
+	yyset_lineno(firstLineNo,scanner);
+	yyset_column(0,scanner);
+
+	try {
+		runParser(scanner,this,scanContext);
+	} catch (...) {
+		yylex_destroy(scanner);
+		throw;
+	}
+
+	yylex_destroy(scanner);
+
+	appendOffset = scanContext.lineStartOffset;
+	appendLineNo = scanContext.lineStartLineNo;
+	hasIncludes |= scanContext.hasIncludes;
+
+}
+
+void Properties::updateIncludeDir () {
+
+	if (configFileManagedInternally) {
+		includeDir = std::filesystem::path(configFileName).parent_path().string();
+	} else {
+		includeDir.clear();
+	}
+
+}
+
+void Properties::setAppendSourceHash (std::string const &buffer) {
+
+	appendSourceHash = StreamHash();
+	appendSourceHash.update(buffer.data(),appendOffset);
+	appendSourceHashValid = true;
+
+}
+
+void Properties::setAppendState (std::string const &buffer) {
+
+	appendOffset = 0;
+	appendLineNo = 1;
+
+	findTopLevelLineStarts(buffer.data(),buffer.size(),[this] (size_t lineStart,int lineNo) {
+		appendOffset = lineStart;
+		appendLineNo = lineNo + 1;
+	});
+
+}
+
+void Properties::readAppended() {
+
+	checkNotFrozen("readAppended");
+
+	if (!appendStateValid) {
+		readConfiguration();
+		return;
+	}
+
+	std::string buffer;
+	bool inputShrank = false;
+
+	updateIncludeDir();
+	PROPERTIES4CXX_PARSE_STATS_ONLY(startParseStats();)
+	openInput();
+
+	try {
+		std::istream &iStream = getInputStream();
+
+		iStream.clear();
+		iStream.seekg(0,iStream.end);
+		std::streamoff const inputEnd = iStream.tellg();
+
+		if (inputEnd < appendStreamStart + std::streamoff(appendOffset)) {
+			// The input was truncated or replaced. It was not only appended.
+			inputShrank = true;
+			iStream.clear();
+			iStream.seekg(appendStreamStart);
+		} else {
+			if (!appendSourceHashValid) {
+				// Hash the text before appendOffset once. readConfigIntoBuffer() adds it to sourceHash.
+				std::vector<char> skipBuffer(std::min(appendOffset,size_t(1024 * 1024)));
+
+				iStream.seekg(appendStreamStart);
+				sourceHash = StreamHash();
+				for (size_t remaining = appendOffset; remaining > 0;) {
+					int bytesRead = readConfigIntoBuffer(skipBuffer.data(),std::min(remaining,skipBuffer.size()));
+					if (bytesRead <= 0) {
+						break;
+					}
+					remaining -= bytesRead;
+				}
+				appendSourceHash = sourceHash;
+				appendSourceHashValid = sourceHash.length == appendOffset;
+			}
+
+			sourceHash = appendSourceHash;
+			iStream.seekg(appendStreamStart + std::streamoff(appendOffset));
+			readInputIntoBuffer(buffer);
+			sourceSize = appendOffset + buffer.size();
+		}
+	} catch (...) {
+		closeInput();
+		throw;
+	}
+
+	closeInput();
+
+	if (inputShrank) {
+		readConfiguration();
+		return;
+	}
+
+	// Only parse complete top-level lines. An incomplete rest is left for the next call.
+	size_t completeLength = 0;
+	int completeLines = 0;
+
+	findTopLevelLineStarts(buffer.data(),buffer.size(),[&] (size_t lineStart,int lineNo) {
+		completeLength = lineStart;
+		completeLines = lineNo;
+	});
+
+	if (completeLength == 0) {
+		return;
+	}
+
+	PropertyMap appendedProperties;
+
+	try {
+		Properties appended(memoryResource);
+
+		appended.includeDir = includeDir;
+		appended.stringInterner = getStringInterner();
+		appended.internValues = internValues;
+		PROPERTIES4CXX_PARSE_STATS_ONLY(appended.collectParseStats = collectParseStats;)
+		appended.parseChunk(buffer.data(),completeLength,appendLineNo,appendOffset);
+		appendedProperties = appended.getCPropertyMap();
+		hasIncludes |= appended.hasIncludes;
+		PROPERTIES4CXX_PARSE_STATS_ONLY(mergeParseStats(appended);)
+	} catch (ExceptionPropertyDuplicate const &) {
+		// The same property was appended more than once. Parse each top-level entry separately. The last one wins.
+		size_t entryStart = 0;
+		int entryLineNo = 0;
+
+		auto parseEntry = [&] (size_t entryEnd,int nextLineNo) {
+			Properties entry(memoryResource);
+
+			entry.includeDir = includeDir;
+			entry.stringInterner = getStringInterner();
+			entry.internValues = internValues;
+			PROPERTIES4CXX_PARSE_STATS_ONLY(entry.collectParseStats = collectParseStats;)
+			entry.parseChunk(buffer.data() + entryStart,entryEnd - entryStart,appendLineNo + entryLineNo,appendOffset + entryStart);
+			for (auto const &it : entry.getCPropertyMap()) {
+				appendedProperties.assign(it.second);
+			}
+			hasIncludes |= entry.hasIncludes;
+			PROPERTIES4CXX_PARSE_STATS_ONLY(mergeParseStats(entry);)
+
+			entryStart = entryEnd;
+			entryLineNo = nextLineNo;
+		};
+
+		findTopLevelLineStarts(buffer.data(),completeLength,[&] (size_t lineStart,int lineNo) {
+			if (lineStart < completeLength) {
+				parseEntry(lineStart,lineNo);
+			}
+		});
+		parseEntry(completeLength,completeLines);
+	}
+
+	PROPERTIES4CXX_PARSE_STATS_ONLY(uint64_t const buildStart = collectParseStats ? parseStatsNow() : 0;)
+	PropertyMap overriddenProperties;
+
+	PropertyMap &map = writablePropertyMap();
+
+	for (auto const &it : appendedProperties) {
+		PropertyIterator oldIt = map.find(it.first);
+
+		if (oldIt != map.end()) {
+			overriddenProperties.insert(oldIt->second);
+			contentHash -= oldIt->second->getContentHash();
+			map.erase(oldIt);
+		}
+
+		insertProperty(it.second);
+	}
+
+	applyEnvironmentOverrides(&overriddenProperties,&appendedProperties);
+
+	appendSourceHash.update(buffer.data(),completeLength);
+	appendOffset += completeLength;
+	appendLineNo += completeLines;
+
+	// The configuration does not match the text of a complete parse any more.
+	sourceIndexValid = false;
+	invalidateInterpolation();
+	sourceSizeValid = sourceSizeValid && appendSourceHashValid && !hasIncludes;
+	PROPERTIES4CXX_PARSE_STATS_ONLY(finishParseStats(buildStart);)
+
+	if (!subscriptions.empty()) {
+		PropertyChangeList changes;
+
+		diffPropertyMaps(std::string(),overriddenProperties,appendedProperties,changes);
+		notifySubscribers(changes);
+	}
+
+}
+
+void Properties::splitSourceEntries (std::string const &buffer,std::vector<SourceEntry> &entries) {
+
+	entries.clear();
+	entries.push_back(SourceEntry{0,0,1,0,{}});
+
+	findTopLevelLineStarts(buffer.data(),buffer.size(),[&] (size_t lineStart,int lineNo) {
+		if (lineStart < buffer.size()) {
+			entries.back().length = lineStart - entries.back().offset;
+			entries.push_back(SourceEntry{lineStart,0,lineNo + 1,0,{}});
+		}
+	});
+	entries.back().length = buffer.size() - entries.back().offset;
+
+	for (auto &it : entries) {
+		it.textHash = hashString(buffer.data() + it.offset,it.length);
+	}
+
+}
+
+size_t Properties::findSourceEntry (std::vector<SourceEntry> const &entries,size_t offset) {
+
+	auto it = std::upper_bound(entries.cbegin(),entries.cend(),offset,[] (size_t offset,SourceEntry const &entry) {
+		return offset < entry.offset;
+	});
+
+	return (it - entries.cbegin()) - 1;
+}
+
+void Properties::buildSourceIndex (std::string const &buffer) {
+
+	splitSourceEntries(buffer,sourceIndex);
+
+	for (auto const &it : *propertyMap) {
+		sourceIndex[findSourceEntry(sourceIndex,it.second->getSourceOffset())].propertyNames.emplace_back(it.first);
+	}
+
+	sourceIndexValid = true;
+
+}
+
+bool Properties::reparseChangedEntries (std::string const &buffer) {
+
+	std::vector<SourceEntry> newIndex;
+	splitSourceEntries(buffer,newIndex);
+
+	// Match the new entries with unchanged old entries by fingerprint and length.
+	// Entries with the same text are matched in the order of the text.
+	std::map<std::pair<uint64_t,size_t>,std::vector<size_t>> oldEntriesByText;
+	for (size_t i = sourceIndex.size(); i-- > 0;) {
+		oldEntriesByText[std::make_pair(sourceIndex[i].textHash,sourceIndex[i].length)].push_back(i);
+	}
+
+	std::vector<size_t> oldEntryOfNewEntry(newIndex.size(),sourceIndex.size());
+	std::vector<bool> oldEntryMatched(sourceIndex.size(),false);
+
+	for (size_t i = 0; i < newIndex.size(); i++) {
+		auto it = oldEntriesByText.find(std::make_pair(newIndex[i].textHash,newIndex[i].length));
+
+		if (it != oldEntriesByText.end() && !it->second.empty()) {
+			oldEntryOfNewEntry[i] = it->second.back();
+			oldEntryMatched[it->second.back()] = true;
+			it->second.pop_back();
+		}
+	}
+
+	// Parse the runs of changed entries. Each run starts and ends at a top-level line start
+	// and can be parsed independently like a chunk of a parallel parse.
+	struct ChangedRun {
+		size_t firstEntry;
+		size_t endEntry;
+		std::unique_ptr<Properties> properties;
+	};
+	std::vector<ChangedRun> changedRuns;
+
+	for (size_t i = 0; i < newIndex.size(); i++) {
+		if (oldEntryOfNewEntry[i] == sourceIndex.size()) {
+			if (changedRuns.empty() || changedRuns.back().endEntry != i) {
+				changedRuns.push_back(ChangedRun{i,i + 1,nullptr});
+			} else {
+				changedRuns.back().endEntry = i + 1;
+			}
+		}
+	}
+
+	try {
+		for (auto &run : changedRuns) {
+			size_t const offset = newIndex[run.firstEntry].offset;
+			size_t const length = newIndex[run.endEntry - 1].offset + newIndex[run.endEntry - 1].length - offset;
+
+			run.properties.reset(new Properties(memoryResource));
+			run.properties->includeDir = includeDir;
+			run.properties->stringInterner = getStringInterner();
+			run.properties->internValues = internValues;
+			PROPERTIES4CXX_PARSE_STATS_ONLY(run.properties->collectParseStats = collectParseStats;)
+			run.properties->parseChunk(buffer.data() + offset,length,newIndex[run.firstEntry].lineNo,offset);
+
+			if (run.properties->hasIncludes) {
+				// A new include directive. Included files are only loaded by a complete parse.
+				return false;
+			}
+		}
+	} catch (...) {
+		// Let the complete parse report the error.
+		return false;
+	}
+
+	// Collect the properties of deleted and changed old entries.
+	PropertyMap removedProperties;
+	for (size_t i = 0; i < sourceIndex.size(); i++) {
+		if (!oldEntryMatched[i]) {
+			for (auto const &name : sourceIndex[i].propertyNames) {
+				PropertyPtr const &removed = propertyMap->at(name);
+
+				removedProperties.insert(removed);
+			}
+		}
+	}
+
+	// A new property must neither exist in an unchanged entry nor in another changed entry.
+	PropertyMap addedProperties;
+	for (auto const &run : changedRuns) {
+		for (auto const &it : run.properties->getCPropertyMap()) {
+			if ((propertyMap->count(it.first) && !removedProperties.count(it.first)) ||
+					!addedProperties.insert(it).second) {
+				// Let the complete parse report the duplicate.
+				return false;
+			}
+		}
+	}
+
+	// Unchanged entries which moved get new source offsets. Properties which are shared with a copy of this configuration
+	// must not be modified, also not within structures. Parse completely then.
+	for (size_t i = 0; i < newIndex.size(); i++) {
+		size_t const oldEntry = oldEntryOfNewEntry[i];
+
+		if (oldEntry != sourceIndex.size() && newIndex[i].offset != sourceIndex[oldEntry].offset) {
+			for (auto const &name : sourceIndex[oldEntry].propertyNames) {
+				if (propertyMap.use_count() > 1 || !isExclusiveTree(propertyMap->at(name))) {
+					return false;
+				}
+			}
+		}
+	}
+
+	// From here on nothing can fail. Apply the changes.
+	PROPERTIES4CXX_PARSE_STATS_ONLY(
+		for (auto const &run : changedRuns) {
+			mergeParseStats(*run.properties);
+		}
+		uint64_t const buildStart = collectParseStats ? parseStatsNow() : 0;
+	)
+	for (auto const &it : removedProperties) {
+		contentHash -= it.second->getContentHash();
+		writablePropertyMap().erase(it.first);
+	}
+
+	for (auto const &it : addedProperties) {
+		insertProperty(it.second);
+	}
+
+	applyEnvironmentOverrides(&removedProperties,&addedProperties);
+
+	for (size_t i = 0; i < newIndex.size(); i++) {
+		size_t const oldEntry = oldEntryOfNewEntry[i];
+
+		if (oldEntry != sourceIndex.size()) {
+			ptrdiff_t const delta = ptrdiff_t(newIndex[i].offset) - ptrdiff_t(sourceIndex[oldEntry].offset);
+
+			newIndex[i].propertyNames.swap(sourceIndex[oldEntry].propertyNames);
+			if (delta != 0) {
+				for (auto const &name : newIndex[i].propertyNames) {
+					propertyMap->at(name)->shiftSourceOffset(delta);
+				}
+			}
+		}
+	}
+
+	for (auto const &it : addedProperties) {
+		newIndex[findSourceEntry(newIndex,it.second->getSourceOffset())].propertyNames.emplace_back(it.first);
+	}
+
+	sourceIndex.swap(newIndex);
+	PROPERTIES4CXX_PARSE_STATS_ONLY(finishParseStats(buildStart);)
+
+	if (!subscriptions.empty()) {
+		PropertyChangeList changes;
+
+		diffPropertyMaps(std::string(),removedProperties,addedProperties,changes);
+		notifySubscribers(changes);
+	}
+
+	return true;
+
+}
+
+std::future<void> Properties::readConfigurationAsync() {
+
+	return readConfigurationAsync([] (std::function<void ()> const &task) {
+		ThreadPool::getInstance().submit(task);
+	});
+
+}
+
+std::future<void> Properties::readConfigurationAsync(Executor const &executor) {
+
+	// Fail before anything is scheduled
+	checkNotFrozen("readConfigurationAsync");
+
+	bool expected = false;
+	if (!asyncReadInProgress.compare_exchange_strong(expected,true)) {
+		throw ExceptionConfigReadError("An asynchronous read of the configuration is still in progress");
+	}
+
+	// std::function requires a copyable function object. Therefore the task is wrapped into a shared_ptr.
+	// The flag is reset before the future becomes ready. Thus the next read can be started right after it.
+	auto task = std::make_shared<std::packaged_task<void ()>>([this] {
+		try {
+			readConfiguration();
+		} catch (...) {
+			asyncReadInProgress = false;
+			throw;
+		}
+		asyncReadInProgress = false;
+	});
+	std::future<void> rc = task->get_future();
+
+	try {
+		executor([task] {
+			(*task)();
+		});
+	} catch (...) {
+		asyncReadInProgress = false;
+		throw;
+	}
+
+	return rc;
+
+}
+
+void Properties::loadDirectory (std::string const &directoryName,std::string const &fileNameSuffix,unsigned maxThreads) {
+
+	checkNotFrozen("loadDirectory");
+
+	std::vector<std::string> fileNames;
+
+	try {
+		for (auto const &entry : std::filesystem::directory_iterator(directoryName)) {
+			std::string fileName = entry.path().filename().string();
+
+			if (!entry.is_regular_file() || fileName.empty() || fileName[0] == '.') {
+				continue;
+			}
+			if (fileName.size() < fileNameSuffix.size() ||
+					fileName.compare(fileName.size() - fileNameSuffix.size(),fileNameSuffix.size(),fileNameSuffix) != 0) {
+				continue;
+			}
+
+			fileNames.push_back(entry.path().string());
+		}
+	} catch (std::filesystem::filesystem_error const &e) {
+		throw ExceptionConfigFileOpenError(e.what());
+	}
+
+	// The merge order must not depend on the order of the directory entries.
+	std::sort(fileNames.begin(),fileNames.end());
+
+	std::vector<std::unique_ptr<Properties>> fileProperties(fileNames.size());
+	std::vector<std::exception_ptr> fileExceptions(fileNames.size());
+
+	PROPERTIES4CXX_PARSE_STATS_ONLY(startParseStats();)
+
+	// The files share the table of this. Create it before.
+	getStringInterner();
+
+	ThreadPool::getInstance().parallelFor(fileNames.size(),[&] (size_t i) {
+		try {
+			fileProperties[i].reset(new Properties(fileNames[i],memoryResource));
+			fileProperties[i]->stringInterner = stringInterner;
+			fileProperties[i]->internValues = internValues;
+			PROPERTIES4CXX_PARSE_STATS_ONLY(fileProperties[i]->collectParseStats = collectParseStats;)
+			fileProperties[i]->readConfiguration();
+		} catch (...) {
+			fileExceptions[i] = std::current_exception();
+		}
+	},maxThreads);
+
+	for (auto const &it : fileExceptions) {
+		if (it) {
+			std::rethrow_exception(it);
+		}
+	}
+
+	PROPERTIES4CXX_PARSE_STATS_ONLY(
+		for (auto const &it : fileProperties) {
+			mergeParseStats(*it);
+		}
+		uint64_t const buildStart = collectParseStats ? parseStatsNow() : 0;
+	)
+
+	// The old configuration is only needed to tell subscribers what changed.
+	std::shared_ptr<PropertyMap> oldPropertyMap;
+	if (!subscriptions.empty()) {
+		oldPropertyMap = propertyMap;
+	}
+
+	propertyMap = newPropertyMap(memoryResource);
+	contentHash = 0;
+	sourceIndexValid = false;
+	appendStateValid = false;
+	sourceSizeValid = false;
+	invalidateInterpolation();
+
+	for (size_t i = 0; i < fileProperties.size(); i++) {
+		for (auto const &it : fileProperties[i]->getCPropertyMap()) {
+			if (propertyMap->count(it.first)) {
+				std::string errText = "Property already exists: ";
+				errText.append(it.first).append(" in file \"").append(fileNames[i]).append("\"");
+
+				for (size_t k = 0; k < i; k++) {
+					if (fileProperties[k]->getCPropertyMap().count(it.first)) {
+						errText.append(", first defined in file \"").append(fileNames[k]).append("\"");
+						break;
+					}
+				}
+
+				throw ExceptionPropertyDuplicate(errText.c_str());
+			}
+
+			insertProperty(it.second);
+		}
+	}
+
+	applyEnvironmentOverrides(nullptr,nullptr);
+	PROPERTIES4CXX_PARSE_STATS_ONLY(finishParseStats(buildStart);)
+
+	if (!subscriptions.empty()) {
+		PropertyChangeList changes;
+
+		diffPropertyMaps(std::string(),*oldPropertyMap,*propertyMap,changes);
+		notifySubscribers(changes);
+	}
+
+}
+
+std::shared_ptr<StringInterner> const &Properties::getStringInterner () {
+
+	if (!stringInterner) {
+		stringInterner = std::make_shared<StringInterner>();
+	}
+
+	return stringInterner;
+}
+
+bool Properties::isParseStatsAvailable () {
+
+#if PROPERTIES4CXX_PARSE_STATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+namespace {
+
+/// Memory resource which records the size of the last allocation. Used to measure node sizes of the standard library.
+class SizeProbe: public std::pmr::memory_resource {
+public:
+	size_t lastSize = 0;
+
+private:
+	void *do_allocate (size_t bytes,size_t alignment) override {
+		lastSize = bytes;
+		return std::pmr::new_delete_resource()->allocate(bytes,alignment);
+	}
+
+	void do_deallocate (void *p,size_t bytes,size_t alignment) override {
+		std::pmr::new_delete_resource()->deallocate(p,bytes,alignment);
+	}
+
+	bool do_is_equal (std::pmr::memory_resource const &other) const noexcept override {
+		return this == &other;
+	}
+};
+
+/// Size of the last allocation of a \ref ProbeAllocator
+thread_local size_t lastProbeAllocation = 0;
+
+/// Stateless allocator like std::allocator which records the size of the last allocation
+template <typename T>
+struct ProbeAllocator {
+	typedef T value_type;
+
+	ProbeAllocator () = default;
+
+	template <typename U>
+	ProbeAllocator (ProbeAllocator<U> const &) {}
+
+	T *allocate (size_t n) {
+		lastProbeAllocation = n * sizeof(T);
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate (T *p,size_t n) {
+		std::allocator<T>().deallocate(p,n);
+	}
+
+	template <typename U>
+	bool operator == (ProbeAllocator<U> const &) const {
+		return true;
+	}
+
+	template <typename U>
+	bool operator != (ProbeAllocator<U> const &) const {
+		return false;
+	}
+};
+
+/// Sizes of the allocations of the standard library containers per element
+struct NodeSizes {
+	size_t mapNode;
+	size_t controlBlock;
+	size_t listNode;
+	size_t sharedString;
+	size_t propertyMap;
+
+	NodeSizes () {
+		SizeProbe probe;
+
+		{
+			static std::string const noName;
+			Properties::PropertyMap::Index map(&probe);
+			map.insert(Properties::PropertyMap::value_type{noName,Properties::PropertyPtr()});
+			mapNode = probe.lastSize;
+		}
+		{
+			Properties::PropertyPtr ptr(static_cast<Property*>(nullptr),&Property::dispose,std::pmr::polymorphic_allocator<Property>(&probe));
+			controlBlock = probe.lastSize;
+		}
+		{
+			// The node of a list does not depend on the allocator. Only the size of the element matters.
+			struct alignas(std::string) StringSlot {
+				char bytes[sizeof(std::string)];
+			};
+			std::pmr::list<StringSlot> list(&probe);
+			list.emplace_back();
+			listNode = probe.lastSize;
+		}
+		{
+			// Like std::make_shared, which creates the shared names and values
+			InternedString str = std::allocate_shared<std::string const>(ProbeAllocator<std::string>());
+			sharedString = lastProbeAllocation;
+		}
+		{
+			auto map = std::allocate_shared<Properties::PropertyMap>(std::pmr::polymorphic_allocator<Properties::PropertyMap>(&probe));
+			propertyMap = probe.lastSize;
+		}
+	}
+};
+
+} // namespace
+
+/// \brief Return the bytes which \p str occupies on the heap. Short strings within the string object take none.
+static size_t stringHeapSize (std::string const &str) {
+
+	uintptr_t const data = reinterpret_cast<uintptr_t>(str.data());
+	uintptr_t const object = reinterpret_cast<uintptr_t>(&str);
+
+	if (data >= object && data < object + sizeof(str)) {
+		return 0;
+	}
+
+	return str.capacity() + 1;
+}
+
+/** \brief Return the size of a shared string when it was not counted before
+ *
+ * @param str Shared string
+ * @param blockSize Size of the block of the string and its reference counts
+ * @param sharedStrings Shared strings which were counted already
+ * @return Size of the block and of the heap buffer of the string, or 0 when it was counted before
+ */
+static size_t sharedStringSize (InternedString const &str,size_t blockSize,std::unordered_set<std::string const*> &sharedStrings) {
+
+	if (!sharedStrings.insert(str.get()).second) {
+		return 0;
+	}
+
+	return blockSize + stringHeapSize(*str);
+}
+
+MemoryUsage Properties::memoryUsage () const {
+
+	std::unordered_set<std::string const*> sharedStrings;
+	MemoryUsage rc;
+
+	addMemoryUsage(rc,sharedStrings);
+
+	return rc;
+}
+
+void Properties::addMemoryUsage (MemoryUsage &rc,std::unordered_set<std::string const*> &sharedStrings) const {
+
+	static NodeSizes const nodeSizes;
+
+	rc.structContainers += nodeSizes.propertyMap;
+
+	{
+		std::shared_lock<std::shared_mutex> lock (interpolationMutex);
+
+		for (auto const &it : interpolatedValues) {
+			rc.interpolatedStrings += stringHeapSize(it.second);
+		}
+		for (auto const &it : interpolatedPaths) {
+			rc.interpolatedStrings += stringHeapSize(it.first);
+		}
+	}
+
+	for (auto const &it : *propertyMap) {
+		Property const &property = *it.second;
+
+		rc.names += sharedStringSize(property.propertyName,nodeSizes.sharedString,sharedStrings);
+		rc.mapNodes += nodeSizes.mapNode;
+		rc.controlBlocks += nodeSizes.controlBlock;
+
+		size_t stringSize = property.isStringValueDefined ? stringHeapSize(property.stringValue) : 0;
+		size_t objectSize;
+
+		if (property.isStruct()) {
+			objectSize = sizeof(PropertyStruct);
+			rc.lazyStrings += stringSize;
+			rc.structContainers += sizeof(Properties);
+			property.getPropertiesStructure().addMemoryUsage(rc,sharedStrings);
+		} else if (property.isList()) {
+			objectSize = sizeof(PropertyList);
+			rc.lazyStrings += stringSize;
+			for (auto const &value : property.getPropertyValueList()) {
+				rc.values += stringHeapSize(value);
+				rc.listNodes += nodeSizes.listNode;
+			}
+		} else {
+			if (property.isDouble()) {
+				objectSize = sizeof(PropertyDouble);
+			} else if (property.isInteger()) {
+				objectSize = sizeof(PropertyInt);
+			} else if (property.isBool()) {
+				objectSize = sizeof(PropertyBool);
+			} else {
+				objectSize = sizeof(Property);
+			}
+			rc.values += stringSize;
+			if (property.internedValue) {
+				rc.values += sharedStringSize(property.internedValue,nodeSizes.sharedString,sharedStrings);
+			}
+		}
+
+		if (property.allocatedFromResource) {
+			objectSize += Property::resourceHeaderSize;
+		}
+		rc.properties += objectSize;
+	}
+
+}
+
+#if PROPERTIES4CXX_PARSE_STATS
+/// \brief Return the number of bytes of the heap in use, or 0 when the C library cannot report it
+static int64_t heapInUse () {
+
+#  if HAVE_MALLINFO2
+	return int64_t(mallinfo2().uordblks);
+#  else
+	return 0;
+#  endif
+}
+#endif
+
+void Properties::startParseStats () {
+
+#if PROPERTIES4CXX_PARSE_STATS
+	if (collectParseStats) {
+		parseStats = ParseStats();
+		// Holds the negative start value until finishParseStats()
+		parseStats.heapBytes = -heapInUse();
+	}
+#endif
+}
+
+void Properties::finishParseStats (uint64_t buildStart) {
+
+#if PROPERTIES4CXX_PARSE_STATS
+	if (collectParseStats) {
+		parseStats.buildNanoseconds += parseStatsNow() - buildStart;
+		parseStats.heapBytes += heapInUse();
+	}
+#else
+	(void)buildStart;
+#endif
+}
+
+void Properties::mergeParseStats (Properties const &part) {
+
+#if PROPERTIES4CXX_PARSE_STATS
+	if (collectParseStats) {
+		parseStats.merge(part.parseStats);
+	}
+#else
+	(void)part;
+#endif
+}
+
+void Properties::setEnvironmentOverrides (std::string const &prefix,EnvironmentNameMapper const &nameMapper) {
+
+	std::vector<EnvironmentOverride> overrides;
+
+	for (char **env = PROPERTIES4CXX_ENVIRON; env && *env; env++) {
+		char const *assign = strchr(*env,'=');
+
+		if (!assign || size_t(assign - *env) <= prefix.size() || strncmp(*env,prefix.data(),prefix.size()) != 0) {
+			continue;
+		}
+
+		std::string const path = nameMapper(std::string(*env + prefix.size(),size_t(assign - *env) - prefix.size()));
+		EnvironmentOverride envOverride;
+		size_t pos = 0;
+
+		while (pos <= path.size() && !path.empty()) {
+			size_t const dot = std::min(path.find('.',pos),path.size());
+
+			envOverride.path.push_back(path.substr(pos,dot - pos));
+			pos = dot + 1;
+		}
+
+		if (envOverride.path.empty() ||
+				std::find(envOverride.path.begin(),envOverride.path.end(),std::string()) != envOverride.path.end()) {
+			continue;
+		}
+
+		envOverride.property = makeEnvironmentProperty(envOverride.path.back(),assign + 1);
+		overrides.push_back(std::move(envOverride));
+	}
+
+	// Deterministic order when two variables map to the same path. Then the last one wins.
+	std::stable_sort(overrides.begin(),overrides.end(),[] (EnvironmentOverride const &a,EnvironmentOverride const &b) {
+		return a.path < b.path;
+	});
+
+	environmentOverrides.swap(overrides);
+	// Unchanged entries would keep the previous overrides.
+	sourceIndexValid = false;
+
+}
+
+void Properties::clearEnvironmentOverrides () {
+
+	environmentOverrides.clear();
+	sourceIndexValid = false;
+
+}
+
+std::string Properties::defaultEnvironmentNameMapper (std::string const &variableName) {
+
+	std::string path;
+	path.reserve(variableName.size());
+
+	for (size_t i = 0; i < variableName.size(); i++) {
+		if (variableName[i] == '_' && i + 1 < variableName.size() && variableName[i + 1] == '_') {
+			path.push_back('.');
+			i++;
+		} else {
+			path.push_back(char(tolower(static_cast<unsigned char>(variableName[i]))));
+		}
+	}
+
+	return path;
+}
+
+Properties::PropertyPtr Properties::makeEnvironmentProperty (std::string const &name,std::string const &value) {
+
+	// Values which the scanner would split into several tokens, or reject, are strings.
+	bool const isLiteral = !value.empty() &&
+			value.find_first_of(" \t\f\r\n\"{}=#\\") == std::string::npos &&
+			value.front() != ',' && value.back() != ',' && value.find(",,") == std::string::npos;
+
+	if (isLiteral) {
+		// The name may not be a valid identifier for the scanner, e.g. "1" or "on". Therefore a fixed name is parsed.
+		std::string text ("v = ");
+		text.append(value).push_back('\n');
+
+		try {
+			Properties parsed;
+			parsed.parseChunk(text.data(),text.size(),1,0);
+
+			PropertyCIterator it = parsed.propertyMap->find("v");
+			if (it != parsed.propertyMap->cend()) {
+				Property const &prop = *it->second;
+				char const *valueStr = prop.getStringValue().c_str();
+
+				if (prop.isInteger()) {
+					return PropertyPtr(new PropertyInt(name.c_str(),valueStr,prop.getIntVal()));
+				}
+				if (prop.isDouble()) {
+					return PropertyPtr(new PropertyDouble(name.c_str(),valueStr,prop.getDoubleValue()));
+				}
+				if (prop.isBool()) {
+					return PropertyPtr(new PropertyBool(name.c_str(),valueStr,prop.getBoolValue()));
+				}
+				if (prop.isList()) {
+					return PropertyPtr(new PropertyList(name.c_str(),prop.getPropertyValueList()));
+				}
+				if (prop.isString()) {
+					return PropertyPtr(new Property(name.c_str(),valueStr,prop.getIsStringQuoted()));
+				}
+			}
+		} catch (ExceptionBase const &) {
+			// Take the value as a string.
+		}
+	}
+
+	return PropertyPtr(new Property(name.c_str(),value.c_str(),true));
+}
+
+Properties::PropertyPtr Properties::overrideProperty (Property const *current,EnvironmentOverride const &envOverride,size_t depth,int level) {
+
+	if (depth + 1 == envOverride.path.size()) {
+		Property const &value = *envOverride.property;
+
+		if (current) {
+			if (current->isStruct()) {
+				return PropertyPtr();
+			}
+			if (current->isString() == value.isString() && current->isInteger() == value.isInteger() &&
+					current->isDouble() == value.isDouble() && current->isBool() == value.isBool() &&
+					current->isList() == value.isList() && current->getStringValue() == value.getStringValue()) {
+				return PropertyPtr();
+			}
+		}
+
+		return envOverride.property;
+	}
+
+	if (current && !current->isStruct()) {
+		return PropertyPtr();
+	}
+
+	Properties children;
+	children.structLevel = level + 1;
+	if (current) {
+		children.shareContent(current->getPropertiesStructure());
+	}
+
+	PropertyCIterator it = children.propertyMap->find(envOverride.path[depth + 1]);
+	PropertyPtr child = overrideProperty(it == children.propertyMap->cend() ? nullptr : it->second.get(),envOverride,depth + 1,level + 1);
+
+	if (!child) {
+		return PropertyPtr();
+	}
+
+	if (it != children.propertyMap->cend()) {
+		child->setSourceOffset(it->second->getSourceOffset());
+		children.contentHash -= it->second->getContentHash();
+		// Copies the shared map. it remains valid because the original map is still held by current.
+		children.writablePropertyMap().erase(it->first);
+	} else {
+		child->setSourceOffset(current ? current->getSourceOffset() : 0);
+	}
+	children.insertProperty(child);
+
+	PropertyPtr rc(new PropertyStruct(envOverride.path[depth].c_str(),children,level));
+	rc->setSourceOffset(current ? current->getSourceOffset() : 0);
+
+	return rc;
+}
+
+void Properties::applyEnvironmentOverrides (PropertyMap *oldProperties,PropertyMap *newProperties) {
+
+	if (environmentOverrides.empty()) {
+		return;
+	}
+
+	PropertyMap &map = writablePropertyMap();
+
+	for (auto const &envOverride : environmentOverrides) {
+		PropertyIterator it = map.find(envOverride.path.front());
+		PropertyPtr replacement = overrideProperty(it == map.end() ? nullptr : it->second.get(),envOverride,0,structLevel);
+
+		if (!replacement) {
+			continue;
+		}
+
+		if (it != map.end()) {
+			replacement->setSourceOffset(it->second->getSourceOffset());
+			if (oldProperties && !(newProperties && newProperties->count(it->first))) {
+				oldProperties->insert(it->second);
+			}
+			contentHash -= it->second->getContentHash();
+			map.erase(it);
+		} else {
+			replacement->setSourceOffset(0);
+		}
+
+		insertProperty(replacement);
+		if (newProperties) {
+			newProperties->assign(replacement);
+		}
+	}
+
+}
+
+Property const *Properties::searchProperty (std::string const &propertyName) const {
+
+	uint64_t const start = accessProfiler ? AccessProfiler::now() : 0;
+	Property const *prop = findProperty(propertyName);
+
+	if (accessProfiler) {
+		accessProfiler->record(propertyName,prop ? AccessProfiler::Hit : AccessProfiler::Miss,AccessProfiler::now() - start);
+	}
+
+	if (!prop) {
+		std::string errText = "Cannot find property ";
+		errText.append(propertyName);
+		throw ExceptionPropertyNotFound(errText.c_str());
+	}
+
+	return prop;
+
+}
+
+Property const *Properties::findProperty (std::string_view propertyName) const {
+
+	if (frozen) {
+		auto it = std::lower_bound(frozenIndex.cbegin(),frozenIndex.cend(),propertyName,
+				[] (FrozenEntry const &entry,std::string_view name) {
+			return entry.name < name;
+		});
+
+		return (it != frozenIndex.cend() && it->name == propertyName) ? it->property : nullptr;
+	}
+
+	PropertyCIterator it = propertyMap->find(propertyName);
+
+	return it != propertyMap->cend() ? it->second.get() : nullptr;
+}
+
+Property const *Properties::searchPropertyPath (std::string const &propertyPath) const {
+
+	uint64_t const start = accessProfiler ? AccessProfiler::now() : 0;
+	Property const *prop = findPropertyPath(propertyPath);
+
+	if (accessProfiler) {
+		accessProfiler->record(propertyPath,prop ? AccessProfiler::Hit : AccessProfiler::Miss,AccessProfiler::now() - start);
+	}
+
+	if (!prop) {
+		std::string errText = "Cannot find property ";
+		errText.append(propertyPath);
+		throw ExceptionPropertyNotFound(errText.c_str());
+	}
+
+	return prop;
+
+}
+
+Property const *Properties::findPropertyPath (std::string const &propertyPath) const {
+
+	Property const *prop = findProperty(propertyPath);
+	if (prop) {
+		return prop;
+	}
+
+	// Try each structure whose name is a prefix of the path. Names can contain dots too.
+	for (size_t dotPos = propertyPath.find('.'); dotPos != std::string::npos; dotPos = propertyPath.find('.',dotPos + 1)) {
+		Property const *structure = findProperty(std::string_view(propertyPath).substr(0,dotPos));
+
+		if (structure && structure->isStruct()) {
+			prop = structure->getPropertiesStructure().findPropertyPath(propertyPath.substr(dotPos + 1));
+			if (prop) {
+				return prop;
+			}
+		}
+	}
+
+	return nullptr;
+
+}
+
+void Properties::setAccessProfiling (bool enable) {
+
+	if (!enable) {
+		accessProfiler.reset();
+	} else if (!accessProfiler) {
+		accessProfiler = std::make_shared<AccessProfiler>();
+	}
+
+}
+
+PropertyAccessProfile Properties::getAccessProfile () const {
+
+	if (!accessProfiler) {
+		return PropertyAccessProfile();
+	}
+
+	return accessProfiler->collect();
+}
+
+/// \brief Append the paths of the properties below \p properties which are not in \p accessed to \p unaccessed
+static void collectUnaccessed (Properties const &properties,std::string const &prefix,
+		std::set<std::string> const &accessed,std::vector<std::string> &unaccessed) {
+
+	for (auto const &it : properties.getCPropertyMap()) {
+		std::string const path = prefix.empty() ? std::string(it.first) : prefix + '.' + std::string(it.first);
+
+		if (accessed.count(path)) {
+			continue;
+		}
+
+		if (it.second->isStruct()) {
+			collectUnaccessed(it.second->getPropertiesStructure(),path,accessed,unaccessed);
+		} else {
+			unaccessed.push_back(path);
+		}
+	}
+
+}
+
+std::vector<std::string> Properties::getUnaccessedProperties () const {
+
+	std::vector<std::string> unaccessed;
+
+	if (accessProfiler) {
+		std::set<std::string> accessed;
+
+		for (auto const &it : accessProfiler->collect()) {
+			if (it.hits > 0) {
+				accessed.insert(it.key);
+			}
+		}
+
+		collectUnaccessed(*this,std::string(),accessed,unaccessed);
+	}
+
+	return unaccessed;
+}
+
+void Properties::resetAccessProfile () {
+
+	if (accessProfiler) {
+		accessProfiler->reset();
+	}
+
+}
+
+std::string const &Properties::getInterpolatedValue (std::string const &propertyPath) const {
+
+	{
+		std::shared_lock<std::shared_mutex> lock (interpolationMutex);
+		auto it = interpolatedPaths.find(propertyPath);
+
+		if (it != interpolatedPaths.end()) {
+			if (accessProfiler) {
+				accessProfiler->record(propertyPath,AccessProfiler::Hit,0);
+			}
+			return *it->second;
+		}
+	}
+
+	Property const *prop = searchPropertyPath(propertyPath);
+
+	std::unique_lock<std::shared_mutex> lock (interpolationMutex);
+	std::vector<Property const*> inProgress;
+	std::string const &value = resolveInterpolation(*prop,propertyPath,inProgress);
+
+	interpolatedPaths.emplace(propertyPath,&value);
+
+	return value;
+
+}
+
+std::string const &Properties::resolveInterpolation (Property const &property,std::string const &propertyPath,
+		std::vector<Property const*> &inProgress) const {
+
+	auto cached = interpolatedValues.find(&property);
+
+	if (cached != interpolatedValues.end()) {
+		return cached->second;
+	}
+
+	if (property.isStruct()) {
+		std::string errText = "Property ";
+		errText.append(propertyPath).append(" is not a scalar value but a struct.");
+		throw ExceptionWrongPropertyType(errText);
+	}
+
+	if (std::find(inProgress.begin(),inProgress.end(),&property) != inProgress.end()) {
+		std::string errText = "Property ";
+		errText.append(propertyPath).append(" refers to itself.");
+		throw ExceptionInterpolationCycle(errText.c_str());
+	}
+
+	std::string const &value = property.getStringValue();
+	std::string result;
+	size_t pos = 0;
+
+	inProgress.push_back(&property);
+
+	size_t refStart;
+
+	while ((refStart = value.find('$',pos)) != std::string::npos) {
+		result.append(value,pos,refStart - pos);
+
+		if (value.compare(refStart,3,"$${") == 0) {
+			result.append("${",2);
+			pos = refStart + 3;
+			continue;
+		}
+
+		size_t const refEnd = value.compare(refStart,2,"${") == 0 ? value.find('}',refStart + 2) : std::string::npos;
+		if (refEnd == std::string::npos) {
+			// No reference. Take the '$' literally.
+			result.push_back('$');
+			pos = refStart + 1;
+			continue;
+		}
+
+		std::string const refName = value.substr(refStart + 2,refEnd - refStart - 2);
+		bool const envOnly = refName.compare(0,4,"env:") == 0;
+		Property const *refProp = envOnly ? nullptr : findPropertyPath(refName);
+
+		if (refProp) {
+			result.append(resolveInterpolation(*refProp,refName,inProgress));
+		} else {
+			char const *envValue = getenv(envOnly ? refName.c_str() + 4 : refName.c_str());
+
+			if (!envValue) {
+				std::string errText = "Cannot resolve ${";
+				errText.append(refName).append("} in property ").append(propertyPath);
+				throw ExceptionPropertyNotFound(errText.c_str());
+			}
+			result.append(envValue);
+		}
+
+		pos = refEnd + 1;
+	}
+
+	result.append(value,pos,std::string::npos);
+	inProgress.pop_back();
+
+	return interpolatedValues.emplace(&property,std::move(result)).first->second;
+
+}
+
+bool Properties::getPropertyValue(std::string const& propertyName, bool defaultVal) const {
+
+	try {
+		Property const * prop = searchProperty(propertyName);
+
+		return prop->getBoolValue();
+
+	} catch (ExceptionPropertyNotFound const &e) {
+		if (accessProfiler) {
+			accessProfiler->record(propertyName,AccessProfiler::Defaulted,0);
+		}
+		return defaultVal;
+	}
+}
+
+double Properties::getPropertyValue(std::string const& propertyName,double defaultVal) const {
+
+	try {
+		Property const * prop = searchProperty(propertyName);
+
+		return prop->getDoubleValue();
+
+	} catch (ExceptionPropertyNotFound const &e) {
+		if (accessProfiler) {
+			accessProfiler->record(propertyName,AccessProfiler::Defaulted,0);
+		}
+		return defaultVal;
+	}
+}
+
+long long Properties::getPropertyValue(std::string const& propertyName,long long defaultVal) const {
+
+	try {
+		Property const * prop = searchProperty(propertyName);
+
+		return prop->getIntVal();
+
+	} catch (ExceptionPropertyNotFound const &e) {
+		if (accessProfiler) {
+			accessProfiler->record(propertyName,AccessProfiler::Defaulted,0);
+		}
+		return defaultVal;
+	}
+}
+
+
+char const * Properties::getPropertyValue(std::string const& propertyName,char const * defaultVal) const {
+
+	try {
+		Property const * prop = searchProperty(propertyName);
+
+		if (prop->isStruct()) {
+			std::ostringstream strstr;
+			strstr << "Property " << propertyName << " is not a scalar value but a struct.";
+
+			throw ExceptionWrongPropertyType(strstr.str());
+		}
+
+		return prop->getStrValue();
+
+	} catch (ExceptionPropertyNotFound const &e) {
+		if (accessProfiler) {
+			accessProfiler->record(propertyName,AccessProfiler::Defaulted,0);
+		}
+		return defaultVal;
+	}
+
+}
+
+void Properties::addProperty (Property *newProperty) {
+
+	// Take ownership first. The property is released when it is a duplicate, or the configuration is frozen.
+	PropertyPtr newPropertyPtr(newProperty,&Property::dispose,std::pmr::polymorphic_allocator<Property>(memoryResource));
+	checkNotFrozen("addProperty");
+	PropertyCIterator it = propertyMap->find(newProperty->getPropertyName());
+
+	if (it != propertyMap->cend()) {
+		std::string errText = "Property already exists: ";
+		errText.append(newProperty->getPropertyName());
+		throw ExceptionPropertyDuplicate(errText.c_str());
+	}
+
+	insertProperty(newPropertyPtr);
+	sourceIndexValid = false;
+	invalidateInterpolation();
+
+	if (!subscriptions.empty()) {
+		notifySubscribers(PropertyChangeList{PropertyChange{PropertyChange::Added,newProperty->getPropertyName()}});
+	}
+
+}
+
+void Properties::includeProperties (Properties const &other) {
+
+	checkNotFrozen("includeProperties");
+
+	for (auto const &it : other.getCPropertyMap()) {
+		insertProperty(it.second);
+	}
+	sourceIndexValid = false;
+	invalidateInterpolation();
+
+	if (!subscriptions.empty()) {
+		PropertyChangeList changes;
+
+		for (auto const &it : other.getCPropertyMap()) {
+			changes.push_back(PropertyChange{PropertyChange::Added,std::string(it.first)});
+		}
+		notifySubscribers(changes);
+	}
+
+}
+
+void Properties::setProperty (std::vector<std::string> const &structurePath,Property *newProperty) {
+
+	// Take ownership first. The property is released when the path is invalid, or the configuration is frozen.
+	PropertyPtr newPropertyPtr(newProperty,&Property::dispose,std::pmr::polymorphic_allocator<Property>(memoryResource));
+	checkNotFrozen("setProperty");
+
+	// Check the path before anything is modified. The first missing structure on the path is reported as added,
+	// otherwise the property itself.
+	PropertyChange change{PropertyChange::Added,std::string()};
+	Properties const *structure = this;
+
+	for (size_t i = 0; i <= structurePath.size(); i++) {
+		std::string const &componentName = i < structurePath.size() ? structurePath[i] : newProperty->getPropertyName();
+
+		if (i > 0) {
+			change.propertyPath.push_back('.');
+		}
+		change.propertyPath.append(componentName);
+
+		PropertyCIterator it = structure->propertyMap->find(componentName);
+		if (it == structure->propertyMap->cend()) {
+			break;
+		}
+
+		if (i == structurePath.size()) {
+			change.changeType = PropertyChange::Modified;
+		} else if (!it->second->isStruct()) {
+			std::string errText = "Property is no structure: ";
+			errText.append(change.propertyPath);
+			throw ExceptionWrongPropertyType(errText.c_str());
+		} else {
+			structure = &it->second->getPropertiesStructure();
+		}
+	}
+
+	std::string const &name = structurePath.empty() ? newProperty->getPropertyName() : structurePath.front();
+	PropertyCIterator it = propertyMap->find(name);
+	PropertyPtr replacement = newPropertyPtr;
+
+	if (!structurePath.empty()) {
+		replacement = copyPathWithProperty(it == propertyMap->cend() ? nullptr : it->second.get(),structurePath,0,newPropertyPtr,structLevel);
+	}
+
+	if (it != propertyMap->cend()) {
+		replacement->setSourceOffset(it->second->getSourceOffset());
+		contentHash -= it->second->getContentHash();
+		writablePropertyMap().erase(name);
+	}
+
+	insertProperty(replacement);
+	sourceIndexValid = false;
+	invalidateInterpolation();
+
+	if (!subscriptions.empty()) {
+		notifySubscribers(PropertyChangeList{change});
+	}
+
+}
+
+Properties::PropertyPtr Properties::copyPathWithProperty (Property const *current,std::vector<std::string> const &structurePath,size_t depth,
+		PropertyPtr const &property,int level) const {
+
+	Properties children(memoryResource);
+
+	children.structLevel = level + 1;
+	if (current) {
+		children.shareContent(current->getPropertiesStructure());
+	}
+
+	std::string const &name = depth + 1 < structurePath.size() ? structurePath[depth + 1] : property->getPropertyName();
+	PropertyCIterator it = children.propertyMap->find(name);
+	PropertyPtr child = property;
+
+	if (depth + 1 < structurePath.size()) {
+		child = copyPathWithProperty(it == children.propertyMap->cend() ? nullptr : it->second.get(),structurePath,depth + 1,property,level + 1);
+	}
+
+	if (it != children.propertyMap->cend()) {
+		child->setSourceOffset(it->second->getSourceOffset());
+		children.contentHash -= it->second->getContentHash();
+		// Only this level of the structure is copied. Properties below it remain shared.
+		children.writablePropertyMap().erase(name);
+	} else {
+		child->setSourceOffset(current ? current->getSourceOffset() : 0);
+	}
+	children.insertProperty(child);
+
+	PropertyPtr rc(Property::create<PropertyStruct>(memoryResource,sharedName(structurePath[depth]),std::move(children),level),
+			&Property::dispose,std::pmr::polymorphic_allocator<Property>(memoryResource));
+	rc->setSourceOffset(current ? current->getSourceOffset() : 0);
+
+	return rc;
+}
+
+std::shared_ptr<Properties::PropertyMap> Properties::newPropertyMap (std::pmr::memory_resource *memoryResource,PropertyMap const *source) {
+
+	// The allocator is passed on to the map. Thus the map and its nodes are allocated from memoryResource.
+	std::pmr::polymorphic_allocator<PropertyMap> allocator(memoryResource);
+
+	if (source) {
+		return std::allocate_shared<PropertyMap>(allocator,*source);
+	}
+
+	return std::allocate_shared<PropertyMap>(allocator);
+}
+
+void Properties::shareContent (Properties const &other) {
+
+	propertyMap = other.propertyMap;
+	contentHash = other.contentHash;
+	sourceIndexValid = false;
+	invalidateInterpolation();
+
+}
+
+void Properties::insertProperty (PropertyPtr const &newProperty) {
+
+	// Before property adds a reference
+	bool const exclusive = isExclusive(newProperty);
+	PropertyPtr property = newProperty;
+
+	// Share the name of a property which was created with a plain name. The map key views it. Thus it is replaced before.
+	if (stringInterner && property->propertyName.use_count() == 1 && exclusive) {
+		property->propertyName = stringInterner->intern(*property->propertyName);
+	}
+
+	if (property->getStructLevel() != structLevel) {
+		// Included properties are shared. They are copied instead of being modified.
+		if (exclusive) {
+			property->setStructLevel(structLevel);
+		} else {
+			property = copyWithStructLevel(*property,structLevel);
+		}
+	}
+
+	auto rc = writablePropertyMap().insert(property);
+
+	if (!rc.second) {
+		std::string errText = "Property already exists: ";
+		errText.append(property->getPropertyName());
+		throw ExceptionPropertyDuplicate(errText.c_str());
+	}
+
+	contentHash += property->getContentHash();
+
+}
+
+InternedString Properties::sharedName (std::string_view name) const {
+
+	if (stringInterner) {
+		return stringInterner->intern(name);
+	}
+
+	return PropertyName(name,memoryResource).name;
+
+}
+
+bool Properties::isExclusive (PropertyPtr const &property) {
+
+	// A frozen structure may be shared with other configurations even when the property is not.
+	return property.use_count() == 1 && !(property->isStruct() && property->getPropertiesStructure().isFrozen());
+
+}
+
+bool Properties::isExclusiveTree (PropertyPtr const &property) {
+
+	if (!isExclusive(property)) {
+		return false;
+	}
+
+	if (property->isStruct()) {
+		Properties const &structure = property->getPropertiesStructure();
+
+		if (structure.propertyMap.use_count() > 1) {
+			return false;
+		}
+		for (auto const &it : *structure.propertyMap) {
+			if (!isExclusiveTree(it.second)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+
+}
+
+void Properties::makeEntriesExclusive () {
+
+	PropertyMap &map = writablePropertyMap();
+
+	for (auto it = map.begin(); it != map.end(); ++it) {
+		if (!isExclusive(it->second)) {
+			PropertyPtr const copy = copyWithStructLevel(*it->second,structLevel);
+
+			// The copy has the same name. Thus the position of the entry does not change.
+			it = map.erase(it);
+			it = map.insert(copy).first;
+		}
+	}
+
+}
+
+Properties::PropertyPtr Properties::copyWithStructLevel (Property const &property,int level) const {
+
+	return PropertyPtr(copyProperty(property,level,false),&Property::dispose,std::pmr::polymorphic_allocator<Property>(memoryResource));
+
+}
+
+void Properties::takeContent (Properties &other) {
+
+	propertyMap.swap(other.propertyMap);
+	std::swap(contentHash,other.contentHash);
+	sourceIndexValid = false;
+	other.sourceIndexValid = false;
+	invalidateInterpolation();
+	other.invalidateInterpolation();
+
+}
+
+void Properties::compact () {
+
+	checkNotFrozen("compact");
+
+	std::pmr::memory_resource *upstream = compactArena ? compactArena->getUpstream() : memoryResource;
+	size_t arenaSize;
+
+	// Dry run with an empty arena which counts the required size
+	{
+		std::unique_ptr<CompactArena,CompactArena::Releaser> sizingArena(CompactArena::create(0,upstream));
+		Properties dryRun(sizingArena.get());
+
+		dryRun.structLevel = structLevel;
+		dryRun.copyCompact(*propertyMap);
+		arenaSize = sizingArena->getRequiredSize();
+	}
+
+	std::unique_ptr<CompactArena,CompactArena::Releaser> arena(CompactArena::create(arenaSize,upstream));
+	Properties compacted(arena.get());
+
+	compacted.structLevel = structLevel;
+	compacted.copyCompact(*propertyMap);
+
+	// Copies of this configuration keep the old map.
+	propertyMap = std::move(compacted.propertyMap);
+
+	// The arena is full. Later changes allocate from the former resource, and not via the arena.
+	setTreeMemoryResource(upstream);
+	if (compactArena) {
+		compactArena->release();
+	}
+	compactArena = arena.release();
+
+}
+
+void Properties::copyCompact (PropertyMap const &source) {
+
+	for (auto const &it : source) {
+		Property const &property = *it.second;
+
+		insertProperty(PropertyPtr(copyProperty(property,property.getStructLevel(),true),&Property::dispose,
+				std::pmr::polymorphic_allocator<Property>(memoryResource)));
+	}
+
+}
+
+void Properties::setTreeMemoryResource (std::pmr::memory_resource *resource) {
+
+	memoryResource = resource;
+
+	for (auto const &it : *propertyMap) {
+		if (it.second->isStruct()) {
+			static_cast<PropertyStruct&>(*it.second).propertyList->setTreeMemoryResource(resource);
+		}
+	}
+
+}
+
+Property *Properties::copyProperty (Property const &property,int level,bool deep) const {
+
+	InternedString const &name = property.propertyName;
+	Property *copy;
+
+	if (property.isStruct()) {
+		if (deep) {
+			Properties children(memoryResource);
+
+			children.structLevel = level + 1;
+			children.copyCompact(property.getPropertiesStructure().getCPropertyMap());
+			copy = Property::create<PropertyStruct>(memoryResource,name,std::move(children),level);
+		} else {
+			// The properties of the structure remain shared as far as their level permits.
+			copy = Property::create<PropertyStruct>(memoryResource,name,property.getPropertiesStructure(),level);
+		}
+	} else if (property.isList()) {
+		copy = Property::create<PropertyList>(memoryResource,name,property.getPropertyValueList(),level);
+	} else if (property.isDouble()) {
+		copy = Property::create<PropertyDouble>(memoryResource,name,property.getStrValue(),property.getDoubleValue(),level);
+	} else if (property.isInteger()) {
+		copy = Property::create<PropertyInt>(memoryResource,name,property.getStrValue(),property.getIntVal(),level);
+	} else if (property.isBool()) {
+		copy = Property::create<PropertyBool>(memoryResource,name,property.getStrValue(),property.getBoolValue(),level);
+	} else {
+		copy = Property::create<Property>(memoryResource,name,property.getStrValue(),property.getIsStringQuoted(),level);
+	}
+
+	copy->setSourceOffset(property.getSourceOffset());
+	copy->setSourceValueRange(property.getSourceValueOffset(),property.getSourceValueLength());
+	copy->setIsNewlineEscaped(property.getIsNewlineEscaped());
+	if (property.internedValue) {
+		copy->internedValue = property.internedValue;
+		std::string().swap(copy->stringValue);
+	}
+
+	return copy;
+
+}
+
+void Properties::freeze () {
+
+	if (frozen) {
+		return;
+	}
+
+	// Structures which other configurations share, e.g. unfrozen copies or included files, must remain modifiable there.
+	// This gets private copies of them. The copies share their maps until they replace shared structures within themselves.
+	bool const mapShared = propertyMap.use_count() > 1;
+	std::vector<PropertyPtr> replacements;
+
+	for (auto const &it : *propertyMap) {
+		if (it.second->isStruct() && (mapShared || it.second.use_count() > 1) && !it.second->getPropertiesStructure().isFrozen()) {
+			replacements.push_back(copyWithStructLevel(*it.second,structLevel));
+		}
+	}
+
+	if (!replacements.empty()) {
+		PropertyMap &map = writablePropertyMap();
+
+		for (auto const &it : replacements) {
+			map.assign(it);
+		}
+	}
+
+	frozenIndex.clear();
+	frozenIndex.reserve(propertyMap->size());
+
+	// The map is sorted already
+	for (auto const &it : *propertyMap) {
+		Property const &property = *it.second;
+
+		// Create the lazy string representations now. Readers must not write into shared properties.
+		property.getStringValue();
+		if (property.isStruct()) {
+			static_cast<PropertyStruct const &>(property).propertyList->freeze();
+		}
+
+		frozenIndex.push_back(FrozenEntry{it.first,&property});
+	}
+
+	frozen = true;
+
+}
+
+void Properties::throwFrozen (char const *operation) {
+
+	std::string errText = "The configuration is frozen: ";
+	errText.append(operation);
+	throw ExceptionPropertiesFrozen(errText.c_str());
+}
+
+void Properties::deletePropery (std::string const &propertyName) {
+
+	checkNotFrozen("deletePropery");
+
+	PropertyCIterator it = propertyMap->find(propertyName);
+
+	if (it != propertyMap->cend()) {
+		// It exists, therefore delete it!
+		contentHash -= it->second->getContentHash();
+		writablePropertyMap().erase(propertyName);
+		sourceIndexValid = false;
+		invalidateInterpolation();
+
+		if (!subscriptions.empty()) {
+			notifySubscribers(PropertyChangeList{PropertyChange{PropertyChange::Removed,propertyName}});
+		}
+	}
+
+}
+
+void Properties::updateContentHash () {
+
+	checkNotFrozen("updateContentHash");
+
+	contentHash = 0;
+
+	for (auto const &it : *propertyMap) {
+		contentHash += it.second->getContentHash();
+	}
+
+}
+
+Properties::SubscriptionId Properties::subscribe (std::string const &pathPattern,ChangeCallback const &callback) {
+
+	Subscription subscription {pathPattern,callback};
+
+	if (subscription.pathPattern == "*") {
+		subscription.pathPattern.clear();
+	} else {
+		if (subscription.pathPattern.size() >= 2 &&
+				subscription.pathPattern.compare(subscription.pathPattern.size() - 2,2,".*") == 0) {
+			subscription.pathPattern.resize(subscription.pathPattern.size() - 2);
+		}
+	}
 
-#include "parserTypes.h"
-#include "Properties4CXX/Properties.h"
-#include "Properties4CXX/Property.h"
+	SubscriptionId rc = nextSubscriptionId++;
+	subscriptions.emplace(rc,std::move(subscription));
 
-#include "parser.hh"
-#include "lexer.h"
+	return rc;
 
+}
 
-namespace Properties4CXX {
+void Properties::unsubscribe (SubscriptionId subscriptionId) {
 
-ExceptionBase::~ExceptionBase () {}
+	subscriptions.erase(subscriptionId);
 
-const char* ExceptionBase::what() const noexcept {
-	return description.c_str();
 }
 
-ExceptionConfigReadError::~ExceptionConfigReadError () {}
+/** \brief Is \p parentPath the path of a structure which contains \p path directly or further down?
+ */
+static bool isParentPath (std::string const &parentPath,std::string const &path) {
 
-ExceptionConfigFileOpenError::~ExceptionConfigFileOpenError () {}
+	return path.size() > parentPath.size() &&
+			path[parentPath.size()] == '.' &&
+			path.compare(0,parentPath.size(),parentPath) == 0;
 
-ExceptionPropertyNotFound::~ExceptionPropertyNotFound () {}
+}
 
-ExceptionPropertyDuplicate::~ExceptionPropertyDuplicate () {}
+void Properties::notifySubscribers (PropertyChangeList const &changes) const {
 
-Properties::Properties ()
-:configFileManagedInternally{false},
- inputStream{0}
-{ }
+	if (changes.empty()) {
+		return;
+	}
 
-Properties::Properties (char const *configFileName)
-:configFileName{configFileName},
- configFileManagedInternally{true},
- inputStream{0}
-{ }
+	// Collect the notifications first. Callbacks may subscribe or unsubscribe.
+	std::vector<std::pair<ChangeCallback,PropertyChangeList>> notifications;
 
-Properties::Properties (std::string const &configFileName)
-:configFileName{configFileName},
- configFileManagedInternally{true},
- inputStream{0}
-{ }
+	for (auto const &it : subscriptions) {
+		std::string const &pattern = it.second.pathPattern;
+		PropertyChangeList matchingChanges;
 
-Properties::Properties (std::istream *iStream)
-:configFileManagedInternally{false},
- inputStream{iStream}
-{ }
+		for (auto const &change : changes) {
+			if (pattern.empty() ||
+					change.propertyPath == pattern ||
+					isParentPath(pattern,change.propertyPath) ||
+					isParentPath(change.propertyPath,pattern)) {
+				matchingChanges.push_back(change);
+			}
+		}
 
-Properties::~Properties() {
+		if (!matchingChanges.empty()) {
+			notifications.emplace_back(it.second.callback,std::move(matchingChanges));
+		}
+	}
+
+	for (auto const &it : notifications) {
+		it.first(*this,it.second);
+	}
 
 }
 
-void Properties::setFileName (char const *configName) {
+static std::string makePropertyPath (std::string const &parentPath,std::string_view propertyName) {
 
-	inputStream = 0;
-	configFileManagedInternally = true;
-	configFileName = configName;
+	if (parentPath.empty()) {
+		return std::string(propertyName);
+	}
+
+	std::string rc;
+	rc.reserve(parentPath.size() + 1 + propertyName.size());
+	rc.append(parentPath).append(1,'.').append(propertyName);
 
+	return rc;
 }
 
-void Properties::setFileName (std::string const configName) {
+void diffProperty (std::string const &path,Property const &oldProperty,Property const &newProperty,PropertyChangeList &changes) {
 
-	inputStream = 0;
-	configFileManagedInternally = true;
-	configFileName = configName;
+	if (&oldProperty == &newProperty || oldProperty.getContentHash() == newProperty.getContentHash()) {
+		return;
+	}
+
+	if (oldProperty.isStruct() && newProperty.isStruct()) {
+		diffPropertyMaps(path,
+				oldProperty.getPropertiesStructure().getCPropertyMap(),
+				newProperty.getPropertiesStructure().getCPropertyMap(),
+				changes);
+	} else {
+		changes.push_back(PropertyChange{PropertyChange::Modified,path});
+	}
 
 }
 
-void Properties::setInputStream (std::istream *iStream){
+void diffPropertyMaps (std::string const &parentPath,
+		Properties::PropertyMap const &oldMap,
+		Properties::PropertyMap const &newMap,
+		PropertyChangeList &changes) {
 
-	if (inputFileStream.is_open()) {
-		inputFileStream.close();
+	auto oldIt = oldMap.cbegin();
+	auto newIt = newMap.cbegin();
+
+	// Both maps are sorted by name. Walk through both in parallel.
+	while (oldIt != oldMap.cend() || newIt != newMap.cend()) {
+		if (newIt == newMap.cend() || (oldIt != oldMap.cend() && oldIt->first < newIt->first)) {
+			changes.push_back(PropertyChange{PropertyChange::Removed,makePropertyPath(parentPath,oldIt->first)});
+			oldIt++;
+		} else {
+			if (oldIt == oldMap.cend() || newIt->first < oldIt->first) {
+				changes.push_back(PropertyChange{PropertyChange::Added,makePropertyPath(parentPath,newIt->first)});
+				newIt++;
+			} else {
+				diffProperty(makePropertyPath(parentPath,newIt->first),*oldIt->second,*newIt->second,changes);
+				oldIt++;
+				newIt++;
+			}
+		}
 	}
-	inputStream = iStream;
-	configFileManagedInternally = false;
 
 }
 
-void Properties::setStructLevel (int structLevel) {
+std::ostream &Properties::writeOut (std::ostream &os) const {
+	PropertiesWriter writer;
 
-	this->structLevel = structLevel;
+	writer.write(*this,structLevel);
+	os.write(writer.data(),writer.size());
+
+	return os;
 
-	for (PropertyIterator it=propertyMap.begin(); it != propertyMap.end(); it++) {
-		it->second.get()->setStructLevel(structLevel);
-	}
 }
 
-void Properties::readConfiguration() {
+/** \brief Throw an \ref ExceptionConfigWriteError with the text of the current errno
+ *
+ * @param action What failed
+ * @param fileName Name of the affected file
+ */
+static void throwConfigWriteError (char const *action,std::string const &fileName) {
+	std::string errStr (action);
 
-	// Clear the properties list
-	propertyMap.clear();
+	errStr.append(" \"").append(fileName).append("\": ").append(strerror(errno));
+	throw ExceptionConfigWriteError(errStr.c_str());
+}
 
-	// the Flex scanner context
-	void *scanner = 0;
+/** \brief Close the file descriptor \p fd */
+static int closeFile (int fd) {
+#if defined _WIN32 && !defined __CYGWIN__
+	return _close(fd);
+#else
+	return close(fd);
+#endif
+}
 
-	if (configFileManagedInternally) {
-		inputFileStream.exceptions(inputFileStream.badbit );
+/** \brief Remove the file \p fileName */
+static int removeFile (std::string const &fileName) {
+#if defined _WIN32 && !defined __CYGWIN__
+	return _unlink(fileName.c_str());
+#else
+	return unlink(fileName.c_str());
+#endif
+}
 
-		if (!inputFileStream.is_open()) {
-			try {
-				inputFileStream.open(configFileName.c_str(),inputFileStream.in);
-				if (inputFileStream.fail()) {
-				std::string errStr ("Cannot open configuration file \"");
-				errStr.append(configFileName).append("\".");
-				throw ExceptionConfigFileOpenError(errStr.c_str());
-				}
-			} catch (std::istream::failure const &e) {
-				throw ExceptionConfigFileOpenError(e.what());
-			}
+/** \brief Open \p fileName for reading
+ *
+ * @return File descriptor, or -1 with errno set
+ */
+static int openForReading (std::string const &fileName) {
+#if defined _WIN32 && !defined __CYGWIN__
+	int fd = -1;
+	_sopen_s(&fd,fileName.c_str(),_O_RDONLY | _O_BINARY,_SH_DENYNO,0);
+	return fd;
+#else
+	return open(fileName.c_str(),O_RDONLY);
+#endif
+}
+
+/** \brief Create a temporary file in the directory of \p fileName
+ *
+ * On POSIX systems the temporary file gets the permissions of \p fileName when it exists, or 0644 otherwise.
+ * The temporary file must be in the same directory as \p fileName. Otherwise renaming it is not atomic.
+ *
+ * @param fileName Name of the file which is replaced later
+ * @param[out] tempFileName Name of the temporary file
+ * @return Open file descriptor of the temporary file
+ * @throws ExceptionConfigWriteError
+ */
+static int createTempFile (std::string const &fileName,std::string &tempFileName) {
+
+	std::filesystem::path const filePath (fileName);
+	std::string const tempTemplate = (filePath.parent_path() / ("." + filePath.filename().string() + ".XXXXXX")).string();
+
+#if defined _WIN32 && !defined __CYGWIN__
+	// _mktemp_s only generates a name. Retry when another process created the same file in between.
+	int fd = -1;
+
+	for (int attempt = 0; fd < 0 && attempt < 16; attempt++) {
+		tempFileName = tempTemplate;
+		if (_mktemp_s(&tempFileName[0],tempFileName.size() + 1) != 0) {
+			break;
 		}
-	} else {
-		if (!inputStream) {
-			throw ExceptionConfigReadError ("The external input stream is NULL.");
-		} else {
-			if (!inputStream->bad()) {
-				throw ExceptionConfigReadError ("The external input stream in BAD state.");
-			}
+		_sopen_s(&fd,tempFileName.c_str(),_O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY,_SH_DENYNO,_S_IREAD | _S_IWRITE);
+		if (fd < 0 && errno != EEXIST) {
+			break;
 		}
 	}
 
-	yylex_init_extra(this,&scanner);
-	YY_BUFFER_STATE buf =  yy_create_buffer ( 0, YY_BUF_SIZE ,scanner);
-	yy_flush_buffer(buf,scanner);
-	yy_switch_to_buffer(buf,scanner);
+	if (fd < 0) {
+		throwConfigWriteError("Cannot create temporary file",tempFileName);
+	}
+#else
+	tempFileName = tempTemplate;
+	int fd = mkstemp(&tempFileName[0]);
 
-	// yydebug = 1;
+	if (fd < 0) {
+		throwConfigWriteError("Cannot create temporary file",tempFileName);
+	}
 
-	yyparse(scanner,this);
+	struct stat fileStat;
+	mode_t mode = 0644;
 
-	if (configFileManagedInternally && inputFileStream.is_open()) {
-		inputFileStream.close();
+	if (stat(fileName.c_str(),&fileStat) == 0) {
+		mode = fileStat.st_mode & 07777;
 	}
 
+	if (fchmod(fd,mode) != 0) {
+		int const savedErrno = errno;
+		closeFile(fd);
+		removeFile(tempFileName);
+		errno = savedErrno;
+		throwConfigWriteError("Cannot set permissions of",tempFileName);
+	}
+#endif
 
+	return fd;
 }
 
-Property const *Properties::searchProperty (std::string const &propertyName) const {
+/** \brief Sync and close the temporary file, and rename it to \p fileName
+ *
+ * On POSIX systems the directory is synced finally to persist the directory entry.
+ * On Windows the file is replaced with MoveFileExW(), which returns after the move was written to the disk.
+ * On failure the temporary file is removed.
+ *
+ * @param fd File descriptor of the temporary file. It is closed in any case.
+ * @param tempFileName Name of the temporary file
+ * @param fileName Name of the file which is replaced
+ * @throws ExceptionConfigWriteError
+ */
+static void replaceWithTempFile (int fd,std::string const &tempFileName,std::string const &fileName) {
 
-	PropertyCIterator it = propertyMap.find(propertyName);
-	if (it == propertyMap.cend()) {
-		std::string errText = "Cannot find property ";
-		errText.append(propertyName);
-		throw ExceptionPropertyNotFound(errText.c_str());
+#if defined _WIN32 && !defined __CYGWIN__
+	if (_commit(fd) != 0) {
+#else
+	if (fsync(fd) != 0) {
+#endif
+		int const savedErrno = errno;
+		closeFile(fd);
+		removeFile(tempFileName);
+		errno = savedErrno;
+		throwConfigWriteError("Cannot sync",tempFileName);
+	}
+
+	if (closeFile(fd) != 0) {
+		removeFile(tempFileName);
+		throwConfigWriteError("Cannot close",tempFileName);
+	}
+
+#if defined _WIN32 && !defined __CYGWIN__
+	// rename() of the C runtime fails when the target exists.
+	if (!MoveFileExW(std::filesystem::path(tempFileName).wstring().c_str(),std::filesystem::path(fileName).wstring().c_str(),
+			MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+		DWORD const error = GetLastError();
+		removeFile(tempFileName);
+		std::string errStr ("Cannot rename temporary file to \"");
+		errStr.append(fileName).append("\": Windows error ").append(std::to_string(error));
+		throw ExceptionConfigWriteError(errStr.c_str());
+	}
+#else
+	if (rename(tempFileName.c_str(),fileName.c_str()) != 0) {
+		int const savedErrno = errno;
+		removeFile(tempFileName);
+		errno = savedErrno;
+		throwConfigWriteError("Cannot rename temporary file to",fileName);
+	}
+
+	// Persist the directory entry of the renamed file.
+	// Failure here is not reported because the new content is already in place.
+	std::filesystem::path dirPath = std::filesystem::path(fileName).parent_path();
+	if (dirPath.empty()) {
+		dirPath = ".";
 	}
 
-	return it->second.get();
+	int dirFd = open(dirPath.string().c_str(),O_RDONLY);
+	if (dirFd >= 0) {
+		fsync(dirFd);
+		closeFile(dirFd);
+	}
+#endif
 
 }
 
-bool Properties::getPropertyValue(std::string const& propertyName, bool defaultVal) const {
+void Properties::saveToFile (std::string const &fileName,bool compact) const {
+
+	std::string tempFileName;
+	int fd = createTempFile(fileName,tempFileName);
 
 	try {
-		Property const * prop = searchProperty(propertyName);
+		// Buffer everything, and write it in one go at the end.
+		PropertiesWriter writer (fd,compact ? PropertiesWriter::Compact : PropertiesWriter::Pretty,SIZE_MAX);
+
+		writer.write(*this,structLevel);
+		writer.flush();
+	} catch (...) {
+		closeFile(fd);
+		removeFile(tempFileName);
+		throw;
+	}
 
-		return prop->getBoolValue();
+	replaceWithTempFile(fd,tempFileName,fileName);
 
-	} catch (ExceptionPropertyNotFound const &e) {
-		return defaultVal;
-	}
 }
 
-double Properties::getPropertyValue(std::string const& propertyName,double defaultVal) const {
+/** \brief Write \p length bytes from \p data to \p fd
+ *
+ * @throws ExceptionConfigWriteError
+ */
+static void writeAll (int fd,char const *data,size_t length,std::string const &fileName) {
 
-	try {
-		Property const * prop = searchProperty(propertyName);
+	while (length > 0) {
+#if defined _WIN32 && !defined __CYGWIN__
+		int bytesWritten = _write(fd,data,unsigned(std::min(length,size_t(INT_MAX))));
+#else
+		ssize_t bytesWritten = write(fd,data,length);
+#endif
 
-		return prop->getDoubleValue();
+		if (bytesWritten < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throwConfigWriteError("Cannot write",fileName);
+		}
 
-	} catch (ExceptionPropertyNotFound const &e) {
-		return defaultVal;
+		data += bytesWritten;
+		length -= bytesWritten;
 	}
-}
 
-long long Properties::getPropertyValue(std::string const& propertyName,long long defaultVal) const {
+}
 
-	try {
-		Property const * prop = searchProperty(propertyName);
+/** \brief Read up to \p length bytes from \p fd at \p offset
+ *
+ * @return Number of bytes read. 0 at the end of the file
+ * @throws ExceptionConfigWriteError
+ */
+static size_t readFileAt (int fd,uint64_t offset,char *data,size_t length,std::string const &fileName) {
 
-		return prop->getIntVal();
+	for (;;) {
+#if defined _WIN32 && !defined __CYGWIN__
+		// Windows has no pread(). Nobody else uses the descriptor.
+		if (_lseeki64(fd,offset,SEEK_SET) < 0) {
+			throwConfigWriteError("Cannot seek in",fileName);
+		}
+		int bytesRead = _read(fd,data,unsigned(std::min(length,size_t(INT_MAX))));
+#else
+		ssize_t bytesRead = pread(fd,data,length,offset);
+#endif
 
-	} catch (ExceptionPropertyNotFound const &e) {
-		return defaultVal;
+		if (bytesRead >= 0) {
+			return size_t(bytesRead);
+		}
+		if (errno != EINTR) {
+			throwConfigWriteError("Cannot read",fileName);
+		}
 	}
-}
 
+}
 
-char const * Properties::getPropertyValue(std::string const& propertyName,char const * defaultVal) const {
+/** \brief Append \p length bytes from \p inFd at \p offset to the current position of \p outFd
+ *
+ * On Linux copy_file_range(2) copies within the kernel, or lets the file system share the blocks.
+ * When it is not supported for the files, or elsewhere, the data is copied in large blocks via a buffer.
+ *
+ * @throws ExceptionConfigWriteError
+ */
+static void copyFileSpan (int inFd,uint64_t offset,int outFd,size_t length,std::string const &fileName,std::vector<char> &copyBuffer) {
 
-	try {
-		Property const * prop = searchProperty(propertyName);
+#if defined __linux__
+	while (length > 0) {
+		off_t inOffset = offset;
+		ssize_t bytesCopied = copy_file_range(inFd,&inOffset,outFd,nullptr,length,0);
 
-		if (prop->isStruct()) {
-			std::ostringstream strstr;
-			strstr << "Property " << propertyName << " is not a scalar value but a struct.";
+		if (bytesCopied < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP) {
+				// Not supported for these files. Copy the rest via the buffer.
+				break;
+			}
+			throwConfigWriteError("Cannot copy",fileName);
+		}
 
-			throw ExceptionWrongPropertyType(strstr.str());
+		if (bytesCopied == 0) {
+			// The source file was truncated.
+			errno = EIO;
+			throwConfigWriteError("Unexpected end of file",fileName);
 		}
 
-		return prop->getStrValue();
+		offset += bytesCopied;
+		length -= bytesCopied;
+	}
+#endif
 
-	} catch (ExceptionPropertyNotFound const &e) {
-		return defaultVal;
+	if (length > 0 && copyBuffer.empty()) {
+		copyBuffer.resize(1024 * 1024);
 	}
 
-}
+	while (length > 0) {
+		size_t bytesRead = readFileAt(inFd,offset,copyBuffer.data(),std::min(length,copyBuffer.size()),fileName);
 
-void Properties::addProperty (Property *newProperty) {
+		if (bytesRead == 0) {
+			errno = EIO;
+			throwConfigWriteError("Unexpected end of file",fileName);
+		}
 
-	PropertyCIterator it = propertyMap.find(newProperty->getPropertyName());
+		writeAll(outFd,copyBuffer.data(),bytesRead,fileName);
+		offset += bytesRead;
+		length -= bytesRead;
+	}
 
-	if (it != propertyMap.cend()) {
-		std::string errText = "Property already exists: ";
-		errText.append(newProperty->getPropertyName());
-		throw ExceptionPropertyDuplicate(errText.c_str());
+}
+
+void Properties::applyPatches (std::string const &fileName,PropertyPatchList const &patches) const {
+
+	if (!sourceSizeValid) {
+		throw ExceptionConfigWriteError("Cannot patch the configuration file: The configuration was not read from a file.");
 	}
 
-	newProperty->setStructLevel(structLevel);
-	propertyMap.insert (PropertyPair(newProperty->getPropertyName(),PropertyPtr(newProperty)));
+	struct Replacement {
+		size_t offset;
+		size_t length;
+		std::string text;
+	};
 
-}
+	std::vector<Replacement> replacements;
+	replacements.reserve(patches.size());
 
-void Properties::deletePropery (std::string const &propertyName) {
+	for (auto const &patch : patches) {
+		Property const *prop = searchPropertyPath(patch.propertyPath);
+
+		if (prop->isStruct() || prop->getSourceValueLength() == 0) {
+			std::string errText = "Cannot patch property ";
+			errText.append(patch.propertyPath).append(": It is a structure or was not read from the configuration file.");
+			throw ExceptionWrongPropertyType(errText.c_str());
+		}
 
-	PropertyIterator it = propertyMap.find(propertyName);
+		Replacement replacement {prop->getSourceValueOffset(),prop->getSourceValueLength(),std::string()};
 
-	if (it != propertyMap.end()) {
-		// It exists, therefore delete it!
-		propertyMap.erase(it);
+		if (patch.quoted) {
+			replacement.text.push_back('"');
+			PropertiesWriter::appendEscaped(replacement.text,patch.value.data(),patch.value.size(),true);
+			replacement.text.push_back('"');
+		} else {
+			replacement.text = patch.value;
+		}
+
+		replacements.push_back(std::move(replacement));
 	}
 
-}
+	std::sort(replacements.begin(),replacements.end(),[] (Replacement const &a,Replacement const &b) {
+		return a.offset < b.offset;
+	});
 
-std::ostream &Properties::writeOut (std::ostream &os) const {
+	for (size_t i = 1; i < replacements.size(); i++) {
+		if (replacements[i].offset < replacements[i - 1].offset + replacements[i - 1].length) {
+			throw ExceptionConfigWriteError("Cannot patch the configuration file: A property is patched more than once.");
+		}
+	}
+
+	int inFd = openForReading(fileName);
+	if (inFd < 0) {
+		throwConfigWriteError("Cannot open",fileName);
+	}
+
+	std::string tempFileName;
+	int outFd = -1;
+
+	try {
+		// The recorded byte ranges are only valid for the same text. The same size is not enough.
+		std::vector<char> copyBuffer(1024 * 1024);
+		StreamHash fileHash;
+
+		for (size_t bytesRead; (bytesRead = readFileAt(inFd,fileHash.length,copyBuffer.data(),copyBuffer.size(),fileName)) > 0;) {
+			fileHash.update(copyBuffer.data(),bytesRead);
+		}
 
-	auto it = propertyMap.cbegin();
+		if (fileHash.length != sourceSize || fileHash.value() != sourceHash.value()) {
+			std::string errText = "Cannot patch the configuration file \"";
+			errText.append(fileName).append("\": It was modified after it was read.");
+			throw ExceptionConfigWriteError(errText.c_str());
+		}
+
+		outFd = createTempFile(fileName,tempFileName);
+
+		size_t pos = 0;
+
+		for (auto const &replacement : replacements) {
+			copyFileSpan(inFd,pos,outFd,replacement.offset - pos,fileName,copyBuffer);
+			writeAll(outFd,replacement.text.data(),replacement.text.size(),tempFileName);
+			pos = replacement.offset + replacement.length;
+		}
 
-	while (it != propertyMap.cend()) {
-		it->second->writeOut(os);
-		it++;
+		copyFileSpan(inFd,pos,outFd,sourceSize - pos,fileName,copyBuffer);
+	} catch (...) {
+		if (outFd >= 0) {
+			closeFile(outFd);
+			removeFile(tempFileName);
+		}
+		closeFile(inFd);
+		throw;
 	}
 
-	os << std::endl;
+	closeFile(inFd);
 
-	return os;
+	replaceWithTempFile(outFd,tempFileName,fileName);
+
+}
+
+void Properties::clearIncludeCache () {
+
+	IncludeCache::getInstance().clear();
 
 }
 
@@ -279,6 +3027,7 @@ int bytesRead = 0;
 std::istream & lIStream = configFileManagedInternally?inputFileStream:*inputStream;
 
 	lIStream.exceptions(lIStream.badbit);
+	PROPERTIES4CXX_PARSE_STATS_ONLY(uint64_t const readStart = collectParseStats ? parseStatsNow() : 0;)
 
 	try {
 		lIStream.read(buf,max_size);
@@ -287,10 +3036,59 @@ std::istream & lIStream = configFileManagedInternally?inputFileStream:*inputStre
 		throw ExceptionConfigReadError(e.what());
 	}
 
+	sourceHash.update(buf,bytesRead);
+
+	PROPERTIES4CXX_PARSE_STATS_ONLY(
+		if (collectParseStats) {
+			parseStats.ioNanoseconds += parseStatsNow() - readStart;
+			parseStats.bytesRead += bytesRead;
+		}
+	)
+
 	return bytesRead;
 
 }
 
+void Properties::StreamHash::update (char const *data,size_t length) {
+
+	this->length += length;
+
+	// Complete the pending word first.
+	while (pendingBytes > 0 && length > 0) {
+		pending |= uint64_t((unsigned char)(*data)) << (pendingBytes * 8);
+		data++;
+		length--;
+		if (++pendingBytes == sizeof(uint64_t)) {
+			hash = (hash ^ pending) * 0x100000001b3ULL;
+			hash ^= hash >> 32;
+			pending = 0;
+			pendingBytes = 0;
+		}
+	}
+
+	// FNV-1a like, but word by word
+	for (; length >= sizeof(uint64_t); data += sizeof(uint64_t), length -= sizeof(uint64_t)) {
+		uint64_t word = 0;
+
+		for (size_t i = 0; i < sizeof(uint64_t); i++) {
+			word |= uint64_t((unsigned char)(data[i])) << (i * 8);
+		}
+		hash = (hash ^ word) * 0x100000001b3ULL;
+		hash ^= hash >> 32;
+	}
+
+	for (; length > 0; data++, length--) {
+		pending |= uint64_t((unsigned char)(*data)) << (pendingBytes * 8);
+		pendingBytes++;
+	}
+
+}
+
+uint64_t Properties::StreamHash::value () const {
+
+	return hashCombine(hashCombine(hash,pending),length);
+
+}
 
 long long strToLL (char const *str){
 	long long rc = 0ll;
@@ -453,4 +3251,27 @@ std::string dToStr (double val) {
 	return std::string(buf);
 }
 
+uint64_t hashString (char const *str, size_t len, uint64_t seed) {
+	uint64_t rc = seed;
+
+	for (size_t i = 0; i < len; i++) {
+		rc ^= (unsigned char)(str[i]);
+		rc *= 0x100000001b3ULL;
+	}
+
+	// Final avalanche. FNV-1a alone does not spread the last bytes well enough into the upper bits.
+	return hashCombine(rc,len);
+}
+
+uint64_t hashCombine (uint64_t hash, uint64_t val) {
+	uint64_t rc = hash ^ (val + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+
+	// splitmix64 finalizer
+	rc = (rc ^ (rc >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	rc = (rc ^ (rc >> 27)) * 0x94d049bb133111ebULL;
+	rc ^= rc >> 31;
+
+	return rc;
+}
+
 } // namespace Properties4CXX {
@@ -0,0 +1,248 @@
+/*
+ * PropertiesWriter.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#if defined _WIN32 && !defined __CYGWIN__
+#  include <io.h>
+#  define PROPERTIES4CXX_WRITE_FD _write
+#else
+#  include <unistd.h>
+#  define PROPERTIES4CXX_WRITE_FD ::write
+#endif
+
+#include "Properties4CXX/PropertiesWriter.h"
+#include "StringKernels.h"
+
+namespace Properties4CXX {
+
+// Indention is copied from here. Deeper levels append it repeatedly.
+static char const indentTabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+static int const numIndentTabs = sizeof(indentTabs) - 1;
+
+PropertiesWriter::PropertiesWriter (FormatEnum format)
+:format{format}
+{ }
+
+PropertiesWriter::PropertiesWriter (int fileDescriptor,FormatEnum format,size_t flushThreshold)
+:format{format},
+ fileDescriptor{fileDescriptor},
+ flushThreshold{flushThreshold}
+{
+	// Very large thresholds mean "write all at the end". Then the buffer grows on demand.
+	size_t const initialSize = std::min(flushThreshold,defaultFlushThreshold);
+	buffer.reserve(initialSize + initialSize / 4);
+}
+
+PropertiesWriter::~PropertiesWriter () {
+
+	try {
+		flush();
+	} catch (...) {
+		// A destructor must not throw.
+	}
+
+}
+
+PropertiesWriter &PropertiesWriter::write (Properties const &properties,int structLevel) {
+
+	writeProperties(properties,structLevel);
+	flushIfFull();
+
+	return *this;
+}
+
+PropertiesWriter &PropertiesWriter::write (Property const &property,int structLevel) {
+
+	writeProperty(property,structLevel);
+	flushIfFull();
+
+	return *this;
+}
+
+void PropertiesWriter::flush () {
+
+	if (fileDescriptor < 0) {
+		return;
+	}
+
+	char const *pos = buffer.data();
+	size_t remaining = buffer.size();
+
+	while (remaining > 0) {
+		auto bytesWritten = PROPERTIES4CXX_WRITE_FD(fileDescriptor,pos,remaining);
+
+		if (bytesWritten < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			std::string errStr ("Cannot write configuration: ");
+			errStr.append(strerror(errno));
+			buffer.clear();
+			throw ExceptionConfigWriteError(errStr.c_str());
+		}
+
+		pos += bytesWritten;
+		remaining -= bytesWritten;
+	}
+
+	buffer.clear();
+
+}
+
+void PropertiesWriter::appendEscaped (std::string &outBuffer,char const *str,size_t length,bool escapeNewlines) {
+
+	char const *end = str + length;
+	char const *runStart = str;
+	char const *pos = str;
+
+	while ((pos = findEscapeCandidate(pos,end)) < end) {
+		char escaped;
+
+		switch (*pos) {
+		case '\"':
+			escaped = '\"';
+			break;
+		case '\\':
+			escaped = '\\';
+			break;
+		case '\f':
+			escaped = 'f';
+			break;
+		case '\t':
+			escaped = 't';
+			break;
+		case '\v':
+			escaped = 'v';
+			break;
+		case '\n':
+			escaped = escapeNewlines ? 'n' : 0;
+			break;
+		case '\r':
+			escaped = escapeNewlines ? 'r' : 0;
+			break;
+		default:
+			// Other control characters are written verbatim.
+			escaped = 0;
+		}
+
+		if (escaped) {
+			outBuffer.append(runStart,pos - runStart);
+			outBuffer.push_back('\\');
+			outBuffer.push_back(escaped);
+			runStart = pos + 1;
+		}
+
+		pos++;
+	}
+
+	outBuffer.append(runStart,end - runStart);
+
+}
+
+void PropertiesWriter::writeProperties (Properties const &properties,int structLevel) {
+
+	for (auto const &it : properties.getCPropertyMap()) {
+		writeProperty(*it.second,structLevel);
+		// Large configurations are written in pieces instead of being buffered completely.
+		flushIfFull();
+	}
+
+	if (format == Pretty) {
+		buffer.push_back('\n');
+	}
+
+}
+
+void PropertiesWriter::writeProperty (Property const &property,int structLevel) {
+
+	writeIndent(structLevel);
+
+	buffer.append(property.getPropertyName());
+	if (format == Pretty) {
+		buffer.append(" = ",3);
+	} else {
+		buffer.push_back('=');
+	}
+
+	if (property.isStruct()) {
+		buffer.append("{\n",2);
+		writeProperties(property.getPropertiesStructure(),structLevel + 1);
+		writeIndent(structLevel);
+		buffer.push_back('}');
+	} else if (property.isList()) {
+		bool first = true;
+
+		for (auto const &it : property.getPropertyValueList()) {
+			if (!first) {
+				if (format == Pretty) {
+					buffer.append(" , ",3);
+				} else {
+					buffer.push_back(',');
+				}
+			}
+			writeQuoted(it,property.getIsNewlineEscaped());
+			first = false;
+		}
+	} else if (property.getIsStringQuoted()) {
+		writeQuoted(property.getStringValue(),property.getIsNewlineEscaped());
+	} else {
+		buffer.append(property.getStringValue());
+	}
+
+	buffer.push_back('\n');
+
+}
+
+void PropertiesWriter::writeIndent (int structLevel) {
+
+	if (format == Pretty) {
+		while (structLevel > numIndentTabs) {
+			buffer.append(indentTabs,numIndentTabs);
+			structLevel -= numIndentTabs;
+		}
+		if (structLevel > 0) {
+			buffer.append(indentTabs,structLevel);
+		}
+	}
+
+}
+
+void PropertiesWriter::writeQuoted (std::string const &str,bool escapeNewlines) {
+
+	buffer.push_back('"');
+	appendEscaped(buffer,str.data(),str.size(),escapeNewlines);
+	buffer.push_back('"');
+
+}
+
+} /* namespace Properties4CXX */
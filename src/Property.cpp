@@ -29,6 +29,7 @@
 
 
 #include "Properties4CXX/Property.h"
+#include "Properties4CXX/PropertiesWriter.h"
 
 #include <sstream>
 #include <cmath>
@@ -44,17 +45,19 @@ ExceptionWrongPropertyType::what() const noexcept {
 	return description.c_str();
 }
 
-Property::Property(char const* propertyName, char const* propertyValue,bool stringIsQuoted, int structLevel)
-	:propertyName {propertyName},
+Property::Property(PropertyName propertyName, char const* propertyValue,bool stringIsQuoted, int structLevel)
+	:propertyName {std::move(propertyName.name)},
 	structLevel{structLevel},
 	stringValue {propertyValue},
 	isStringValueDefined {true},
 	propertyType{String},
 	isStringQuoted{stringIsQuoted}
-	{ }
+	{
+	setScalarContentHash();
+	}
 
-Property::Property(char const* propertyName, int structLevel)
-	:propertyName {propertyName},
+Property::Property(PropertyName propertyName, int structLevel)
+	:propertyName {std::move(propertyName.name)},
 	structLevel{structLevel},
 	isStringValueDefined {false},
 	isStringQuoted{false}
@@ -64,13 +67,33 @@ Property::~Property() {
 
 }
 
+void Property::dispose (Property *property) {
+
+	if (!property) {
+		return;
+	}
+
+	if (!property->allocatedFromResource) {
+		delete property;
+		return;
+	}
+
+	// All property classes derive from Property only. Thus the address of the complete object is the same.
+	char *mem = reinterpret_cast<char*>(property) - resourceHeaderSize;
+	ResourceHeader const header = *reinterpret_cast<ResourceHeader*>(mem);
+
+	property->~Property();
+	header.resource->deallocate(mem,header.size,alignof(std::max_align_t));
+
+}
+
 std::string const &Property::getStringValue() const {
 
 	if (!isStringValueDefined) {
 		setLazyStringValue();
 	}
 
-	return stringValue;
+	return definedStringValue();
 
 }
 
@@ -80,7 +103,19 @@ char const *Property::getStrValue() const {
 		setLazyStringValue();
 	}
 
-	return stringValue.c_str();
+	return definedStringValue().c_str();
+
+}
+
+void Property::internStringValue (StringInterner &interner) {
+
+	if (propertyType == List || propertyType == Struct || !isStringValueDefined || internedValue) {
+		return;
+	}
+
+	internedValue = interner.intern(stringValue);
+	// Release the buffer. Assigning an empty string would keep it.
+	std::string().swap(stringValue);
 
 }
 
@@ -124,22 +159,28 @@ Properties const& Property::getPropertiesStructure() const {
 	return *ret;
 }
 
+uint64_t Property::getContentHash() const {
+	return contentHash;
+}
+
+void Property::setScalarContentHash () {
+	contentHash = hashString(stringValue,hashCombine(hashString(*propertyName),propertyType));
+}
+
 void Property::setStructLevel(int structLevel) {
 	this->structLevel = structLevel;
 }
 
-std::ostream &Property::writeOut (std::ostream &os) const {
-
-	if (structLevel > 0) {
-		std::string padString;
-		padString.append (structLevel,'\t');
+void Property::shiftSourceOffset(ptrdiff_t delta) {
+	sourceOffset += delta;
+	sourceValueOffset += delta;
+}
 
-		os << padString;
-	}
+std::ostream &Property::writeOut (std::ostream &os) const {
+	PropertiesWriter writer;
 
-	os << propertyName << " = ";
-	writeOutValue(os);
-	os << std::endl;
+	writer.write(*this,structLevel);
+	os.write(writer.data(),writer.size());
 
 	return os;
 
@@ -156,12 +197,12 @@ std::ostream &Property::writeOutValue (std::ostream &os) const {
 
 		os.put('"');
 
-		streamEscapedString (os,stringValue);
+		streamEscapedString (os,definedStringValue());
 
 		os.put('"');
 
 	} else {
-		os << stringValue;
+		os << definedStringValue();
 	}
 
 	return os;
@@ -171,7 +212,7 @@ std::ostream &Property::writeOutValue (std::ostream &os) const {
 void Property::throwWrongTypeException (char const* expectedPropertyTypeName) const {
 
 	std::ostringstream strstr;
-	strstr << "Property " << propertyName << " is not a " << expectedPropertyTypeName << " value.";
+	strstr << "Property " << *propertyName << " is not a " << expectedPropertyTypeName << " value.";
 
 	throw ExceptionWrongPropertyType(strstr.str());
 }
@@ -182,68 +223,28 @@ void Property::setLazyStringValue () const {
 }
 
 void Property::streamEscapedString (std::ostream &os, std::string const &str) const {
+	std::string escaped;
 
-	char const *cstr = str.c_str();
-
-	while (*cstr) {
-		switch (*cstr) {
-		case '\"':
-			os << "\\\"";
-			break;
-		case '\\':
-			os << "\\\\";
-			break;
-
-		case '\f':
-			os << "\\f";
-			break;
-
-		case '\t':
-			os << "\\t";
-			break;
-
-		case '\v':
-			os << "\\v";
-			break;
-
-		case '\n':
-			if (isNewlineEscaped) {
-				os << "\\n";
-			} else {
-				os.put('\n');
-			}
-			break;
-
-		case '\r':
-			if (isNewlineEscaped) {
-				os << "\\r";
-			} else {
-				os.put('\r');
-			}
-			break;
-
-		default:
-			os.put (*cstr);
-
-		}
-		cstr++;
-	}
+	PropertiesWriter::appendEscaped(escaped,str.data(),str.size(),isNewlineEscaped);
+	os.write(escaped.data(),escaped.size());
 
 }
 
 
-PropertyDouble::PropertyDouble(char const* propertyName, char const* propertyValue,double propertyValueDbl, int structLevel)
-	:Property(propertyName,propertyValue,/*stringIsQuoted*/false,structLevel),
+PropertyDouble::PropertyDouble(PropertyName propertyName, char const* propertyValue,double propertyValueDbl, int structLevel)
+	:Property(std::move(propertyName),propertyValue,/*stringIsQuoted*/false,structLevel),
 	 doubleValue{propertyValueDbl}
 {
 	propertyType = Double;
+	setScalarContentHash();
 }
 
-PropertyDouble::PropertyDouble(char const* propertyName, double propertyValueDbl, int structLevel)
-	:Property(propertyName,dToStr(propertyValueDbl).c_str(),/*stringIsQuoted*/false,structLevel),
+PropertyDouble::PropertyDouble(PropertyName propertyName, double propertyValueDbl, int structLevel)
+	:Property(std::move(propertyName),dToStr(propertyValueDbl).c_str(),/*stringIsQuoted*/false,structLevel),
 	 doubleValue{propertyValueDbl}
 {
 	propertyType = Double;
+	setScalarContentHash();
 }
 
 PropertyDouble::~PropertyDouble() {
@@ -260,18 +261,20 @@ double PropertyDouble::getDoubleValue() const {
 	return doubleValue;
 }
 
-PropertyInt::PropertyInt(char const* propertyName, char const* propertyValue,long long propertyValueInt, int structLevel)
-	:Property(propertyName,propertyValue,/*stringIsQuoted*/false,structLevel),
+PropertyInt::PropertyInt(PropertyName propertyName, char const* propertyValue,long long propertyValueInt, int structLevel)
+	:Property(std::move(propertyName),propertyValue,/*stringIsQuoted*/false,structLevel),
 	 intValue{propertyValueInt}
 {
 	propertyType = Integer;
+	setScalarContentHash();
 }
 
-PropertyInt::PropertyInt(char const* propertyName, long long propertyValueInt, int structLevel)
-	:Property(propertyName,std::to_string(propertyValueInt).c_str(),/*stringIsQuoted*/false,structLevel),
+PropertyInt::PropertyInt(PropertyName propertyName, long long propertyValueInt, int structLevel)
+	:Property(std::move(propertyName),std::to_string(propertyValueInt).c_str(),/*stringIsQuoted*/false,structLevel),
 	 intValue{propertyValueInt}
 {
 	propertyType = Integer;
+	setScalarContentHash();
 }
 
 PropertyInt::~PropertyInt() {
@@ -288,18 +291,20 @@ double PropertyInt::getDoubleValue() const {
 	return double (intValue);
 }
 
-PropertyBool::PropertyBool(char const* propertyName, char const* propertyValue,bool propertyValueBool, int structLevel)
-	:Property(propertyName,propertyValue,/*stringIsQuoted*/false,structLevel),
+PropertyBool::PropertyBool(PropertyName propertyName, char const* propertyValue,bool propertyValueBool, int structLevel)
+	:Property(std::move(propertyName),propertyValue,/*stringIsQuoted*/false,structLevel),
 	boolValue{propertyValueBool}
 {
 	propertyType = Bool;
+	setScalarContentHash();
 }
 
-PropertyBool::PropertyBool(char const* propertyName, bool propertyValueBool, int structLevel)
-	:Property(propertyName,propertyValueBool?"true":"false",/*stringIsQuoted*/false,structLevel),
+PropertyBool::PropertyBool(PropertyName propertyName, bool propertyValueBool, int structLevel)
+	:Property(std::move(propertyName),propertyValueBool?"true":"false",/*stringIsQuoted*/false,structLevel),
 	 boolValue{propertyValueBool}
  {
 	propertyType = Bool;
+	setScalarContentHash();
  }
 
 PropertyBool::~PropertyBool() {
@@ -312,17 +317,23 @@ bool PropertyBool::getBoolValue() const {
 
 }
 
-PropertyList::PropertyList(char const* propertyName, PropertyValueList const &valueList, int structLevel)
-	:Property{propertyName,structLevel},
+PropertyList::PropertyList(PropertyName propertyName, PropertyValueList const &valueList, int structLevel)
+	:Property{std::move(propertyName),structLevel},
 	 valueList{valueList}
 {
 	propertyType = List;
+	contentHash = hashCombine(hashString(*this->propertyName),propertyType);
+
+	for (auto const &it : valueList) {
+		contentHash = hashCombine(contentHash,hashString(it));
+	}
 }
 
-PropertyList::PropertyList(char const* propertyName, int structLevel)
-	:Property{propertyName,structLevel}
+PropertyList::PropertyList(PropertyName propertyName, int structLevel)
+	:Property{std::move(propertyName),structLevel}
 {
-
+	propertyType = List;
+	contentHash = hashCombine(hashString(*this->propertyName),propertyType);
 }
 
 PropertyList::~PropertyList() {
@@ -336,24 +347,24 @@ PropertyValueList const &PropertyList::getPropertyValueList() const {
 
 
 void PropertyList::setLazyStringValue() const {
-	std::ostringstream newString;
+	std::string newString;
 	auto it = valueList.cbegin();
 
 	if (it != valueList.cend()) {
-		newString.put('"');
-		streamEscapedString(newString, *it);
-		newString.put('"');
+		newString.push_back('"');
+		PropertiesWriter::appendEscaped(newString,it->data(),it->size(),isNewlineEscaped);
+		newString.push_back('"');
 		it++;
 	}
 
 	while (it != valueList.cend()) {
-		newString << " , \"";
-		streamEscapedString(newString, *it);
-		newString.put('"');
+		newString.append(" , \"");
+		PropertiesWriter::appendEscaped(newString,it->data(),it->size(),isNewlineEscaped);
+		newString.push_back('"');
 		it++;
 	}
 
-	stringValue = newString.str();
+	stringValue = std::move(newString);
 	isStringValueDefined = true;
 
 }
@@ -361,22 +372,37 @@ void PropertyList::setLazyStringValue() const {
 void PropertyList::appendString (std::string const &str) {
 	valueList.push_back(str);
 	isStringValueDefined = false;
+	contentHash = hashCombine(contentHash,hashString(str));
 }
 
-PropertyStruct::PropertyStruct(char const* propertyName, int structLevel)
-	:Property{propertyName,structLevel},
+PropertyStruct::PropertyStruct(PropertyName propertyName, int structLevel)
+	:Property{std::move(propertyName),structLevel},
 	 propertyList{new Properties}
 {
 	propertyType = Struct;
+	contentHash = hashCombine(hashString(*this->propertyName),propertyType);
 	this->propertyList->setStructLevel(structLevel + 1);
 }
 
-PropertyStruct::PropertyStruct(char const* propertyName, Properties const &propertyList, int structLevel)
-	:Property{propertyName,structLevel},
-	 propertyList{new Properties}
+PropertyStruct::PropertyStruct(PropertyName propertyName, Properties const &propertyList, int structLevel)
+	:Property{std::move(propertyName),structLevel},
+	 propertyList{new Properties(propertyList.getMemoryResource())}
+{
+	propertyType = Struct;
+	contentHash = hashCombine(hashString(*this->propertyName),propertyType);
+	// The map is shared. It is copied when either structure is modified.
+	this->propertyList->shareContent(propertyList);
+	this->propertyList->setStructLevel(structLevel + 1);
+}
+
+PropertyStruct::PropertyStruct(PropertyName propertyName, Properties &&propertyList, int structLevel)
+	:Property{std::move(propertyName),structLevel},
+	 propertyList{new Properties(propertyList.getMemoryResource())}
 {
 	propertyType = Struct;
-	this->propertyList->getPropertyMap() = propertyList.getCPropertyMap();
+	contentHash = hashCombine(hashString(*this->propertyName),propertyType);
+	// Not shared with the moved-from object. Thus the levels of the properties are set in place.
+	this->propertyList->takeContent(propertyList);
 	this->propertyList->setStructLevel(structLevel + 1);
 }
 
@@ -392,6 +418,12 @@ Properties const& PropertyStruct::getPropertiesStructure() const {
 
 }
 
+uint64_t PropertyStruct::getContentHash() const {
+
+	return hashCombine(contentHash,propertyList->getContentHash());
+
+}
+
 void PropertyStruct::setStructLevel(int structLevel) {
 
 	Property::setStructLevel(structLevel);
@@ -399,6 +431,13 @@ void PropertyStruct::setStructLevel(int structLevel) {
 
 }
 
+void PropertyStruct::shiftSourceOffset(ptrdiff_t delta) {
+
+	Property::shiftSourceOffset(delta);
+	propertyList->shiftSourceOffset(delta);
+
+}
+
 void PropertyStruct::addProperty (Property  *prop) {
 
 	propertyList->addProperty(prop);
@@ -406,24 +445,17 @@ void PropertyStruct::addProperty (Property  *prop) {
 }
 
 void PropertyStruct::setLazyStringValue() const {
-	std::ostringstream ostr;
-
-	ostr << '{' << std::endl;
-	propertyList->writeOut(ostr);
+	PropertiesWriter writer;
 
-	if (structLevel > 0) {
-		std::string padString;
-		padString.append (structLevel,'\t');
+	writer.write(*propertyList,structLevel + 1);
 
-		ostr << padString;
-	}
-
-	ostr << '}';
+	std::string newString;
+	newString.reserve(writer.size() + structLevel + 3);
+	newString.append("{\n").append(writer.str()).append(structLevel,'\t').push_back('}');
 
-	stringValue = ostr.str();
+	stringValue = std::move(newString);
 	isStringValueDefined = true;
 
-
 }
 
 
@@ -0,0 +1,101 @@
+/*
+ * StringInterner.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <functional>
+
+#include "Properties4CXX/StringInterner.h"
+
+namespace Properties4CXX {
+
+InternedString StringInterner::intern (std::string_view str) {
+
+	size_t const hash = std::hash<std::string_view>()(str);
+	Shard &shard = shardOf(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto it = shard.strings.find(str);
+	if (it != shard.strings.end()) {
+		return it->second;
+	}
+
+	InternedString rc = std::make_shared<std::string const>(str);
+	// The key refers to the interned string. It lives as long as the entry.
+	shard.strings.emplace(std::string_view(*rc),rc);
+
+	return rc;
+}
+
+InternedString StringInterner::find (std::string_view str) const {
+
+	size_t const hash = std::hash<std::string_view>()(str);
+	Shard const &shard = shardOf(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto it = shard.strings.find(str);
+	if (it != shard.strings.end()) {
+		return it->second;
+	}
+
+	return InternedString();
+}
+
+size_t StringInterner::size () const {
+
+	size_t rc = 0;
+
+	for (auto const &shard : shards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		rc += shard.strings.size();
+	}
+
+	return rc;
+}
+
+size_t StringInterner::purge () {
+
+	size_t rc = 0;
+
+	for (auto &shard : shards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		for (auto it = shard.strings.begin(); it != shard.strings.end();) {
+			// Nobody else can obtain another reference while the shard is locked.
+			if (it->second.use_count() == 1) {
+				it = shard.strings.erase(it);
+				rc++;
+			} else {
+				it++;
+			}
+		}
+	}
+
+	return rc;
+}
+
+} /* namespace Properties4CXX */
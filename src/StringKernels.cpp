@@ -0,0 +1,195 @@
+/*
+ * StringKernels.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if defined __AVX2__ || defined __SSE2__
+#  include <immintrin.h>
+#endif
+
+#include "StringKernels.h"
+
+namespace Properties4CXX {
+
+char const *findQuoteOrBackslash (char const *str,char const *end) {
+
+#if defined __AVX2__
+	{
+		__m256i const quote = _mm256_set1_epi8('"');
+		__m256i const backslash = _mm256_set1_epi8('\\');
+
+		while (end - str >= 32) {
+			__m256i const block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(str));
+			unsigned const mask = _mm256_movemask_epi8(_mm256_or_si256(
+					_mm256_cmpeq_epi8(block,quote),
+					_mm256_cmpeq_epi8(block,backslash)));
+
+			if (mask) {
+				return str + __builtin_ctz(mask);
+			}
+			str += 32;
+		}
+	}
+#endif
+
+#if defined __SSE2__
+	{
+		__m128i const quote = _mm_set1_epi8('"');
+		__m128i const backslash = _mm_set1_epi8('\\');
+
+		while (end - str >= 16) {
+			__m128i const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(str));
+			unsigned const mask = _mm_movemask_epi8(_mm_or_si128(
+					_mm_cmpeq_epi8(block,quote),
+					_mm_cmpeq_epi8(block,backslash)));
+
+			if (mask) {
+				return str + __builtin_ctz(mask);
+			}
+			str += 16;
+		}
+	}
+#endif
+
+	while (str < end && *str != '"' && *str != '\\') {
+		str++;
+	}
+
+	return str;
+}
+
+char const *findEscapeCandidate (char const *str,char const *end) {
+
+#if defined __AVX2__
+	{
+		__m256i const quote = _mm256_set1_epi8('"');
+		__m256i const backslash = _mm256_set1_epi8('\\');
+		__m256i const maxControl = _mm256_set1_epi8(0x1f);
+
+		while (end - str >= 32) {
+			__m256i const block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(str));
+			// Unsigned compare: block <= 0x1f when min(block,0x1f) == block
+			__m256i const control = _mm256_cmpeq_epi8(_mm256_min_epu8(block,maxControl),block);
+			unsigned const mask = _mm256_movemask_epi8(_mm256_or_si256(
+					_mm256_or_si256(_mm256_cmpeq_epi8(block,quote),_mm256_cmpeq_epi8(block,backslash)),
+					control));
+
+			if (mask) {
+				return str + __builtin_ctz(mask);
+			}
+			str += 32;
+		}
+	}
+#endif
+
+#if defined __SSE2__
+	{
+		__m128i const quote = _mm_set1_epi8('"');
+		__m128i const backslash = _mm_set1_epi8('\\');
+		__m128i const maxControl = _mm_set1_epi8(0x1f);
+
+		while (end - str >= 16) {
+			__m128i const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(str));
+			// Unsigned compare: block <= 0x1f when min(block,0x1f) == block
+			__m128i const control = _mm_cmpeq_epi8(_mm_min_epu8(block,maxControl),block);
+			unsigned const mask = _mm_movemask_epi8(_mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(block,quote),_mm_cmpeq_epi8(block,backslash)),
+					control));
+
+			if (mask) {
+				return str + __builtin_ctz(mask);
+			}
+			str += 16;
+		}
+	}
+#endif
+
+	while (str < end && *str != '"' && *str != '\\' && static_cast<unsigned char>(*str) >= 0x20) {
+		str++;
+	}
+
+	return str;
+}
+
+void appendUnescapedQuotedString (std::string &dest,char const *quotedText,size_t length) {
+
+	if (length == 0) {
+		return;
+	}
+
+	char const *end = quotedText + length;
+	// Leave the initial double-quote out
+	char const *pos = quotedText + 1;
+
+	dest.reserve(dest.size() + length);
+
+	while (pos < end) {
+		char const *special = findQuoteOrBackslash(pos,end);
+
+		dest.append(pos,special - pos);
+
+		if (special == end || *special == '"') {
+			break;
+		}
+
+		// Here is a masked character
+		special++;
+		if (special == end) {
+			break;
+		}
+
+		char c;
+		switch (*special) {
+
+		case 'f' :
+			c = '\f';
+			break;
+		case 'n' :
+			c = '\n';
+			break;
+		case 'r' :
+			c = '\r';
+			break;
+		case 't' :
+			c = '\t';
+			break;
+		case 'v' :
+			c = '\v';
+			break;
+
+		default:
+			// Including '"' and '\\'
+			c = *special;
+		}
+
+		dest.push_back(c);
+		pos = special + 1;
+	}
+
+}
+
+} /* namespace Properties4CXX */
@@ -0,0 +1,73 @@
+/*
+ * StringKernels.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SRC_STRINGKERNELS_H_
+#define SRC_STRINGKERNELS_H_
+
+#include <cstddef>
+#include <string>
+
+#include "Properties4CXX/Properties.h"
+
+namespace Properties4CXX {
+
+/** \brief Return the first '"' or '\\' in the range [\p str, \p end)
+ *
+ * Blocks of 32 (AVX2) or 16 (SSE2) bytes are tested at once when the compiler targets these instruction sets.
+ *
+ * @param str Start of the range
+ * @param end End of the range
+ * @return Position of the first double quote or backslash, or \p end when there is none
+ */
+PROPERTIES4CXX_LOCAL char const *findQuoteOrBackslash (char const *str,char const *end);
+
+/** \brief Return the first character in the range [\p str, \p end) which may need escaping on output
+ *
+ * These are '"', '\\', and the control characters below 0x20. The caller decides if a control character
+ * is actually escaped.
+ *
+ * Blocks of 32 (AVX2) or 16 (SSE2) bytes are tested at once when the compiler targets these instruction sets.
+ *
+ * @param str Start of the range
+ * @param end End of the range
+ * @return Position of the first candidate, or \p end when there is none
+ */
+PROPERTIES4CXX_LOCAL char const *findEscapeCandidate (char const *str,char const *end);
+
+/** \brief Append the unescaped content of a quoted string token to \p dest
+ *
+ * The leading double quote is skipped. The content ends at the first double quote which is not escaped,
+ * or at the end of the token.
+ * Runs without escapes are copied in bulk.
+ *
+ * @param dest Destination string
+ * @param quotedText The quoted string token including the double quotes
+ * @param length Length of the token
+ */
+PROPERTIES4CXX_LOCAL void appendUnescapedQuotedString (std::string &dest,char const *quotedText,size_t length);
+
+} /* namespace Properties4CXX */
+
+#endif /* SRC_STRINGKERNELS_H_ */
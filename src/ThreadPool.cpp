@@ -0,0 +1,155 @@
+/*
+ * ThreadPool.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <atomic>
+#include <memory>
+
+#include "ThreadPool.h"
+
+namespace Properties4CXX {
+
+ThreadPool &ThreadPool::getInstance() {
+	static ThreadPool instance;
+
+	return instance;
+}
+
+ThreadPool::ThreadPool() {
+	unsigned numThreads = std::thread::hardware_concurrency();
+
+	if (numThreads == 0) {
+		numThreads = 1;
+	}
+
+	for (unsigned i = 0; i < numThreads; i++) {
+		workers.emplace_back(&ThreadPool::workerLoop,this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+
+	{
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		stopping = true;
+	}
+	tasksCond.notify_all();
+
+	for (auto &it : workers) {
+		it.join();
+	}
+}
+
+void ThreadPool::submit (std::function<void ()> const &task) {
+
+	{
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		tasks.push_back(task);
+	}
+	tasksCond.notify_one();
+
+}
+
+void ThreadPool::parallelFor (size_t numItems,std::function<void (size_t item)> const &func,unsigned maxThreads) {
+
+	// The state is shared with the helper tasks. Helpers which start only after all items are done
+	// must still find valid state.
+	struct ParallelState {
+		std::atomic<size_t> nextItem {0};
+		size_t numItems;
+		std::function<void (size_t item)> func;
+		size_t numDone = 0;
+		std::mutex doneMutex;
+		std::condition_variable doneCond;
+	};
+
+	if (numItems == 0) {
+		return;
+	}
+
+	auto state = std::make_shared<ParallelState>();
+	state->numItems = numItems;
+	state->func = func;
+
+	auto work = [state] {
+		size_t item;
+
+		while ((item = state->nextItem.fetch_add(1)) < state->numItems) {
+			state->func(item);
+
+			std::lock_guard<std::mutex> lock(state->doneMutex);
+			state->numDone++;
+			if (state->numDone == state->numItems) {
+				state->doneCond.notify_all();
+			}
+		}
+	};
+
+	size_t numHelpers = getNumThreads();
+	if (maxThreads > 0 && numHelpers > maxThreads - 1) {
+		numHelpers = maxThreads - 1;
+	}
+	if (numHelpers > numItems - 1) {
+		numHelpers = numItems - 1;
+	}
+
+	for (size_t i = 0; i < numHelpers; i++) {
+		submit(work);
+	}
+
+	work();
+
+	std::unique_lock<std::mutex> lock(state->doneMutex);
+	state->doneCond.wait(lock,[&state] { return state->numDone == state->numItems; });
+
+}
+
+void ThreadPool::workerLoop () {
+
+	for (;;) {
+		std::function<void ()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(tasksMutex);
+			tasksCond.wait(lock,[this] { return stopping || !tasks.empty(); });
+
+			if (tasks.empty()) {
+				// stopping, and nothing left to do.
+				return;
+			}
+
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+
+		task();
+	}
+
+}
+
+} /* namespace Properties4CXX */
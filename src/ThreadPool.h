@@ -0,0 +1,100 @@
+/*
+ * ThreadPool.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SRC_THREADPOOL_H_
+#define SRC_THREADPOOL_H_
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Properties4CXX/Properties.h"
+
+namespace Properties4CXX {
+
+/** \brief Internal pool of worker threads for asynchronous and parallel reading of configurations
+ *
+ * The pool is created on first use with one thread per hardware thread.
+ * It is used when the caller does not provide an own executor.
+ */
+class PROPERTIES4CXX_LOCAL
+ThreadPool {
+public:
+
+	/** \brief Return the process wide thread pool. The pool is created on first use.
+	 *
+	 * @return Reference to the thread pool
+	 */
+	static ThreadPool &getInstance();
+
+	/** \brief Run a task in one of the worker threads of the pool
+	 *
+	 * @param task Function to run. It must not throw.
+	 */
+	void submit (std::function<void ()> const &task);
+
+	/** \brief Call \p func for all item numbers from 0 to \p numItems - 1 in parallel
+	 *
+	 * The items are not assigned to threads in advance. Each thread takes the next unprocessed item when it finished
+	 * the previous one. Thus threads which get small items do more of them.
+	 *
+	 * The calling thread processes items too. Therefore the function makes progress even when all threads of the pool are busy,
+	 * and it can safely be called from within a task of the pool.
+	 * The function returns when all items are processed.
+	 *
+	 * @param numItems Number of items
+	 * @param func Function which processes one item. It must not throw.
+	 * @param maxThreads Maximum number of threads working on the items including the calling thread. 0 means no limit.
+	 */
+	void parallelFor (size_t numItems,std::function<void (size_t item)> const &func,unsigned maxThreads = 0);
+
+	/// \return Number of worker threads
+	unsigned getNumThreads () const {
+		return (unsigned)workers.size();
+	}
+
+	~ThreadPool();
+
+private:
+
+	ThreadPool();
+
+	/// Main function of each worker thread
+	void workerLoop ();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void ()>> tasks;
+	std::mutex tasksMutex;
+	std::condition_variable tasksCond;
+	bool stopping = false;
+
+};
+
+} /* namespace Properties4CXX */
+
+#endif /* SRC_THREADPOOL_H_ */
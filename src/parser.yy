@@ -30,11 +30,16 @@
 /* --  The C++ interface and declaration section  ---------------------------- */
 /* ------------------------------------------------------------------------- */
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include <iostream>
 #include <sstream>
 #include <string>
 
 #include "parserTypes.h"
+#include "IncludeCache.h"
 #include "Properties4CXX/Properties.h"
 #include "Properties4CXX/Property.h"
 
@@ -47,6 +52,96 @@
 
 void yyerror (void *scanner, Properties4CXX::Properties *props, const char* parseMsg);
 
+#if PROPERTIES4CXX_PARSE_STATS
+/** Scanner wrapper which counts and times the tokens when statistics are collected
+ *
+ * The time for reading the input, which the scanner does on demand, is excluded.
+ */
+static int countingLex (YYSTYPE *lval, yyscan_t scanner) {
+	Properties4CXX::ParseStats *stats = yyget_extra(scanner)->parseStats;
+
+	if (!stats) {
+		return yylex(lval,scanner);
+	}
+
+	uint64_t const start = parseStatsNow();
+	uint64_t const ioBefore = stats->ioNanoseconds;
+	int const token = yylex(lval,scanner);
+
+	stats->scanNanoseconds += parseStatsNow() - start - (stats->ioNanoseconds - ioBefore);
+
+	switch (token) {
+	case LEX_IDENTIFIER:
+		stats->tokens[Properties4CXX::ParseStats::Identifier]++;
+		stats->allocations++;
+		break;
+	case LEX_STRING:
+		stats->tokens[Properties4CXX::ParseStats::QuotedString]++;
+		stats->allocations++;
+		break;
+	case LEX_INTEGER:
+		stats->tokens[Properties4CXX::ParseStats::Integer]++;
+		stats->allocations++;
+		break;
+	case LEX_DOUBLE:
+		stats->tokens[Properties4CXX::ParseStats::Double]++;
+		stats->allocations++;
+		break;
+	case LEX_BOOL:
+		stats->tokens[Properties4CXX::ParseStats::Bool]++;
+		stats->allocations++;
+		break;
+	case LEX_BRACKETOPEN:
+		stats->tokens[Properties4CXX::ParseStats::BracketOpen]++;
+		if (yyget_extra(scanner)->structDepth > stats->maxStructDepth) {
+			stats->maxStructDepth = yyget_extra(scanner)->structDepth;
+		}
+		break;
+	case LEX_BRACKETCLOSE:
+		stats->tokens[Properties4CXX::ParseStats::BracketClose]++;
+		break;
+	case LEX_COMMA:
+		stats->tokens[Properties4CXX::ParseStats::Comma]++;
+		break;
+	case LEX_ASSIGN:
+		stats->tokens[Properties4CXX::ParseStats::Assign]++;
+		break;
+	case LEX_END_OF_LINE:
+		stats->tokens[Properties4CXX::ParseStats::EndOfLine]++;
+		break;
+	default:
+		break;
+	}
+
+	return token;
+}
+
+#  define yylex countingLex
+
+/// Count objects created by the parser actions
+#  define PARSE_STATS_COUNT(member,n) do { \
+	Properties4CXX::ParseStats *stats = yyget_extra(scanner)->parseStats; \
+	if (stats) { \
+		stats->member += (n); \
+	} } while (0)
+#else
+#  define PARSE_STATS_COUNT(member,n) do { } while (0)
+#endif
+
+/// Return the interned name of a new property
+static inline Properties4CXX::InternedString internName (yyscan_t scanner, std::string const &name) {
+	return yyget_extra(scanner)->nameInterner->intern(name);
+}
+
+/// Intern the value of a new scalar property when values are interned
+static inline void internValue (yyscan_t scanner, Properties4CXX::Property *property) {
+	Properties4CXX::StringInterner *interner = yyget_extra(scanner)->valueInterner;
+
+	if (interner) {
+		property->internStringValue(*interner);
+	}
+}
+
 
 %}
 
@@ -73,16 +168,16 @@ tIntVal		*intVal;
 tBoolVal	*boolVal;
 Properties4CXX::Property	*property;
 Properties4CXX::Properties	*properties;
-Properties4CXX::PropertyValueList *propertyValueList;
+tListVal	*listVal;
 }
 
 %destructor { delete $$; } <string>
 %destructor { delete $$; } <numVal>
 %destructor { delete $$; } <intVal>
 %destructor { delete $$; } <boolVal>
-%destructor { delete $$; } <property>
+%destructor { Properties4CXX::Property::dispose($$); } <property>
 %destructor { delete $$; } <properties>
-%destructor { delete $$; } <propertyValueList>
+%destructor { delete $$; } <listVal>
 
 %token <string>           LEX_IDENTIFIER
 %token <string>           LEX_STRING
@@ -102,6 +197,7 @@ Properties4CXX::PropertyValueList *propertyValueList;
 
 /* The types of the the rules return */
 %type <properties>			properties
+%type <properties>			includeDirective
 %type <property>			singleProperty
 %type <property>			stringProperty
 %type <property>			numProperty
@@ -109,7 +205,7 @@ Properties4CXX::PropertyValueList *propertyValueList;
 %type <property>			boolProperty
 %type <property>			propertyList
 %type <property>			propertyStruct
-%type <propertyValueList>	propertyListList
+%type <listVal>				propertyListList
 %type <string>				stringVal
 
 %%
@@ -118,22 +214,48 @@ Properties4CXX::PropertyValueList *propertyValueList;
 /* ------------------------------------------------------------------------- */
 
 topLevelProperties : properties { 
-	props->getPropertyMap() = $1->getPropertyMap();
+	// Same memory resource. Thus the map is moved without copying the nodes.
+	props->takeContent(*$1);
+	props->updateContentHash();
 	delete $1; 
 	} 
 
-properties : emptyLine { $$ = new Properties4CXX::Properties; } 
+properties : emptyLine { $$ = new Properties4CXX::Properties(props->getMemoryResource()); PARSE_STATS_COUNT(allocations,1); } 
     | singleProperty 
-    { $$ = new Properties4CXX::Properties;
+    { $$ = new Properties4CXX::Properties(props->getMemoryResource());
+      PARSE_STATS_COUNT(allocations,1);
       if ($1) { // Error property returns NULL pointer
       	$$->addProperty($1);
       } }
+	| includeDirective { $$ = $1; }
 	| properties emptyLine { $$ = $1; }
 	| properties singleProperty 
 	{ $$ = $1; 
 	  if ($2) { // Error property returns NULL pointer
 	    $$->addProperty($2); 
 	  } }
+	| properties includeDirective
+	{ $$ = $1;
+	  $$->includeProperties(*$2);
+	  delete $2; $2 = 0; }
+	;
+
+/* include "fileName" shares the properties of the file. The file is loaded via the include cache. */
+includeDirective : LEX_IDENTIFIER stringVal LEX_END_OF_LINE
+	{ if ($1->str == "include") {
+	    tScanContext *scanContext = yyget_extra(scanner);
+	    auto fragment = Properties4CXX::IncludeCache::getInstance().load($2->str,scanContext->includeDir);
+
+	    $$ = new Properties4CXX::Properties(props->getMemoryResource());
+	    PARSE_STATS_COUNT(allocations,1);
+	    $$->includeProperties(*fragment);
+	    scanContext->hasIncludes = true;
+	  } else {
+	    yyerror (scanner, props, "Expected '=' after the property name, or the include directive");
+	    $$ = new Properties4CXX::Properties(props->getMemoryResource());
+	    PARSE_STATS_COUNT(allocations,1);
+	  }
+	  delete $1; $1 = 0; delete $2; $2 = 0; }
 	;
 
 emptyLine : LEX_END_OF_LINE
@@ -153,31 +275,60 @@ errorProperty :  error 	 LEX_END_OF_LINE
 	;
 
 stringProperty : LEX_IDENTIFIER LEX_ASSIGN stringVal LEX_END_OF_LINE
-	{ $$ = new Properties4CXX::Property ( $1->str.c_str(),$3->str.c_str(),$3->isQuotedString);
+	{ $$ = Properties4CXX::Property::create<Properties4CXX::Property>(props->getMemoryResource(),internName(scanner,$1->str),$3->str.c_str(),$3->isQuotedString);
+	  PARSE_STATS_COUNT(properties,1);
+	  PARSE_STATS_COUNT(allocations,1);
+	  $$->setSourceOffset($1->offset);
+	  $$->setSourceValueRange($3->offset,$3->length);
+	  internValue(scanner,$$);
 	  delete $1; $1 = 0; delete $3; $3 = 0; }
 	;
 
 numProperty : LEX_IDENTIFIER LEX_ASSIGN LEX_DOUBLE LEX_END_OF_LINE
-	{ $$ = new Properties4CXX::PropertyDouble ( $1->str.c_str(),$3->numStr.c_str(),$3->numVal); 
+	{ $$ = Properties4CXX::Property::create<Properties4CXX::PropertyDouble>(props->getMemoryResource(),internName(scanner,$1->str),$3->numStr.c_str(),$3->numVal);
+	  PARSE_STATS_COUNT(properties,1);
+	  PARSE_STATS_COUNT(allocations,1);
+	  $$->setSourceOffset($1->offset);
+	  $$->setSourceValueRange($3->offset,$3->numStr.size());
+	  internValue(scanner,$$);
 	  delete $1; $1 = 0; delete $3; $3 = 0; }
 	;
 
 intProperty : LEX_IDENTIFIER LEX_ASSIGN LEX_INTEGER LEX_END_OF_LINE
-	{ $$ = new Properties4CXX::PropertyInt ( $1->str.c_str(),$3->intStr.c_str(),$3->intVal);  
+	{ $$ = Properties4CXX::Property::create<Properties4CXX::PropertyInt>(props->getMemoryResource(),internName(scanner,$1->str),$3->intStr.c_str(),$3->intVal);
+	  PARSE_STATS_COUNT(properties,1);
+	  PARSE_STATS_COUNT(allocations,1);
+	  $$->setSourceOffset($1->offset);
+	  $$->setSourceValueRange($3->offset,$3->intStr.size());
+	  internValue(scanner,$$);
 	  delete $1; $1 = 0; delete $3; $3 = 0; }
 	;
 
 boolProperty : LEX_IDENTIFIER LEX_ASSIGN LEX_BOOL LEX_END_OF_LINE
-	{ $$ = new Properties4CXX::PropertyBool ( $1->str.c_str(),$3->boolStr.c_str(),$3->boolVal);   
+	{ $$ = Properties4CXX::Property::create<Properties4CXX::PropertyBool>(props->getMemoryResource(),internName(scanner,$1->str),$3->boolStr.c_str(),$3->boolVal);
+	  PARSE_STATS_COUNT(properties,1);
+	  PARSE_STATS_COUNT(allocations,1);
+	  $$->setSourceOffset($1->offset);
+	  $$->setSourceValueRange($3->offset,$3->boolStr.size());
+	  internValue(scanner,$$);
 	  delete $1; $1 = 0; delete $3; $3 = 0; }
 	;
 
 propertyList : LEX_IDENTIFIER LEX_ASSIGN propertyListList LEX_END_OF_LINE
-	{ $$ = new Properties4CXX::PropertyList ($1->str.c_str(),*$3);
+	{ $$ = Properties4CXX::Property::create<Properties4CXX::PropertyList>(props->getMemoryResource(),internName(scanner,$1->str),$3->values);
+	  PARSE_STATS_COUNT(properties,1);
+	  PARSE_STATS_COUNT(allocations,1);
+	  $$->setSourceOffset($1->offset);
+	  $$->setSourceValueRange($3->offset,$3->endOffset - $3->offset);
 	  delete $1; $1 = 0; delete $3; $3 = 0; }
 		
 propertyStruct : LEX_IDENTIFIER LEX_ASSIGN LEX_BRACKETOPEN properties LEX_BRACKETCLOSE LEX_END_OF_LINE
-	{ $$ = new Properties4CXX::PropertyStruct ($1->str.c_str(),*$4);
+	{ $$ = Properties4CXX::Property::create<Properties4CXX::PropertyStruct>(props->getMemoryResource(),internName(scanner,$1->str),std::move(*$4));
+	  PARSE_STATS_COUNT(properties,1);
+	  PARSE_STATS_COUNT(structs,1);
+	  // The structure and its property container
+	  PARSE_STATS_COUNT(allocations,2);
+	  $$->setSourceOffset($1->offset);
 	  delete $1; $1 = 0; delete $4; $4 = 0; }
 	| LEX_IDENTIFIER LEX_ASSIGN LEX_BRACKETOPEN error LEX_BRACKETCLOSE  LEX_END_OF_LINE
 	{ $$ = 0; // erroneous structure
@@ -185,7 +336,11 @@ propertyStruct : LEX_IDENTIFIER LEX_ASSIGN LEX_BRACKETOPEN properties LEX_BRACKE
 	}
 	| LEX_IDENTIFIER LEX_ASSIGN LEX_BRACKETOPEN properties
 	{
-	    $$ = new Properties4CXX::PropertyStruct ($1->str.c_str(),*$4);
+	    $$ = Properties4CXX::Property::create<Properties4CXX::PropertyStruct>(props->getMemoryResource(),internName(scanner,$1->str),std::move(*$4));
+	    PARSE_STATS_COUNT(properties,1);
+	    PARSE_STATS_COUNT(structs,1);
+	    PARSE_STATS_COUNT(allocations,2);
+	    $$->setSourceOffset($1->offset);
 	 	delete $1; $1 = 0; delete $4; $4 = 0; 
 		yyerror (scanner, props, "Found opening '{' without closing '}'");
 		YYERROR;
@@ -198,15 +353,19 @@ stringVal : LEX_IDENTIFIER | LEX_STRING
  
 propertyListList : 
 	stringVal LEX_COMMA stringVal { 
-		$$ = new Properties4CXX::PropertyValueList;
-		$$->push_back($1->str);
+		$$ = new tListVal;
+		PARSE_STATS_COUNT(allocations,1);
+		$$->offset = $1->offset;
+		$$->values.push_back($1->str);
 		delete $1; $1 = 0;
-		$$->push_back($3->str);
+		$$->values.push_back($3->str);
+		$$->endOffset = $3->offset + $3->length;
 		delete $3; $3 = 0;
 		}
 	| propertyListList LEX_COMMA stringVal {
 		$$ = $1;
-		$$->push_back($3->str);
+		$$->values.push_back($3->str);
+		$$->endOffset = $3->offset + $3->length;
 		delete $3; $3 = 0;
 		}
 	;
@@ -224,6 +383,8 @@ using namespace std;
 void yyerror (yyscan_t scanner, Properties4CXX::Properties *props, const char* parseMsg)
 {
 
+  PARSE_STATS_COUNT(errors,1);
+
   cerr << "Parse error in line " << yyget_lineno(scanner)
     << " in column " << yyget_column(scanner) << " is \"" << parseMsg << "\"" << endl;
 
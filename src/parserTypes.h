@@ -28,30 +28,102 @@
 #define SRC_PARSERTYPES_H_
 
 #include <string>
+#include <list>
+#include <cstddef>
+#include <cstdint>
+
+#if PROPERTIES4CXX_PARSE_STATS
+#  include <chrono>
+#endif
+
+namespace Properties4CXX {
+class Properties;
+struct ParseStats;
+class StringInterner;
+}
+
+/***************************************************************************/
+/* Collection of parse statistics. It is compiled out unless the library   */
+/* is configured with --enable-parse-stats.                                */
+
+#if PROPERTIES4CXX_PARSE_STATS
+#  define PROPERTIES4CXX_PARSE_STATS_ONLY(...) __VA_ARGS__
+
+/// Clock of the parse statistics in nanoseconds
+inline uint64_t parseStatsNow () {
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+#else
+#  define PROPERTIES4CXX_PARSE_STATS_ONLY(...)
+#endif
+
+/***************************************************************************/
+/* Context of one scanner instance. It is the "extra" data of the scanner. */
+
+typedef struct {
+	/// Configuration which provides the input via Properties::readConfigIntoBuffer
+	Properties4CXX::Properties *properties = nullptr;
+	/// Byte offset of the next token in the complete input
+	size_t offset = 0;
+	/// Byte offset of the current token in the complete input
+	size_t tokenOffset = 0;
+	/// Nesting depth of structures at the current token
+	int structDepth = 0;
+	/// Byte offset of the start of the last line on the top level, i.e. after the last line end outside of structures
+	size_t lineStartOffset = 0;
+	/// Line number of the line starting at lineStartOffset
+	int lineStartLineNo = 1;
+	/// Directory against which relative file names of include directives are resolved. Empty for the current directory
+	std::string includeDir;
+	/// An include directive was parsed
+	bool hasIncludes = false;
+	/// Statistics of the load. nullptr when they are not collected
+	Properties4CXX::ParseStats *parseStats = nullptr;
+	/// Interns the property names
+	Properties4CXX::StringInterner *nameInterner = nullptr;
+	/// Interns the values of scalar properties. nullptr when values are not interned
+	Properties4CXX::StringInterner *valueInterner = nullptr;
+	} tScanContext;
 
 /***************************************************************************/
 /* Structures to store non-string values together with the original string */
+/* The offset is the byte offset of the token in the complete input.       */
 
 typedef struct {
 	bool isQuotedString;
 	std::string str;
+	size_t offset;
+	/// Length of the token in the input. For quoted strings it includes the quotes and escapes.
+	size_t length;
 	} tStrVal;
 
 typedef struct {
 	long double numVal;
 	std::string numStr;
+	size_t offset;
 	} tNumVal;
 
 typedef struct {
 	long long intVal;
 	std::string intStr;
+	size_t offset;
 	} tIntVal;
 
 typedef struct {
 	bool  boolVal;
 	std::string boolStr;
+	size_t offset;
 	} tBoolVal;
 
 
 
+/* A list of values with the byte range from the start of the first to the end of the last value */
+
+typedef struct {
+	std::list<std::string> values;
+	size_t offset;
+	size_t endOffset;
+	} tListVal;
+
+
 #endif /* SRC_PARSERTYPES_H_ */
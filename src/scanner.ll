@@ -35,6 +35,7 @@
 #include <istream>
 
 #include "parserTypes.h"
+#include "StringKernels.h"
 #include "Properties4CXX/Properties.h"
 #include "Properties4CXX/Property.h"
 
@@ -42,16 +43,23 @@
 #include "parser.hh"
 
 static void yy_countlines (char const* text, yyscan_t yyscanner);
-std::string scanQuotedString (char const *quotedText);
+static void yy_markLineStart (yyscan_t yyscanner);
 
 // Overwrite the input macro to read from the configuration input stream.
 #if defined YY_INPUT
 #undef YY_INPUT
 #endif /* if defined YY_INPUT */
 #define YY_INPUT(buf,result,max_size) { \
-	result = yyget_extra(yyscanner)->readConfigIntoBuffer (buf, max_size); \
+	result = yyget_extra(yyscanner)->properties->readConfigIntoBuffer (buf, max_size); \
 	} \
 
+// Track the byte offset of each token in the input.
+#define YY_USER_ACTION { \
+	tScanContext *scanContext = yyget_extra(yyscanner); \
+	scanContext->tokenOffset = scanContext->offset; \
+	scanContext->offset += yyleng; \
+	}
+
 
 
 
@@ -66,7 +74,7 @@ std::string scanQuotedString (char const *quotedText);
 /* When the input stream ends, it ends... */
 %option noyywrap
 
-%option extra-type="Properties4CXX::Properties *"
+%option extra-type="tScanContext *"
 
 /* %option debug */
 %option verbose
@@ -95,6 +103,7 @@ exp      ([eE][+-]?[0-9]+)
 \r\n    {  /* CR-LF according to Windows and DOS custom */
              yyset_lineno(yyget_lineno(yyscanner)+1,yyscanner);
              yyset_column ( 0,yyscanner);
+             yy_markLineStart (yyscanner);
 
              return LEX_END_OF_LINE;
          }
@@ -103,6 +112,7 @@ exp      ([eE][+-]?[0-9]+)
 \n\r    { /* LF-CR reverse to Windows custom. Unusual, but who knows :) */
              yyset_lineno(yyget_lineno(yyscanner)+1,yyscanner);
              yyset_column ( 0,yyscanner);
+             yy_markLineStart (yyscanner);
 
              return LEX_END_OF_LINE;
          }
@@ -111,6 +121,7 @@ exp      ([eE][+-]?[0-9]+)
 \n       { /* Single LF as in UNIX, Linux, and text mode I/O channels in C and C++ */
              yyset_lineno(yyget_lineno(yyscanner)+1,yyscanner);
              yyset_column ( 0,yyscanner);
+             yy_markLineStart (yyscanner);
 
              return LEX_END_OF_LINE;
          }
@@ -119,17 +130,22 @@ exp      ([eE][+-]?[0-9]+)
 \r     { /* Single CR like some Windows multi-line edits return */
              yyset_lineno(yyget_lineno(yyscanner)+1,yyscanner);
              yyset_column ( 0,yyscanner);
+             yy_markLineStart (yyscanner);
 
              return LEX_END_OF_LINE;
          }
 
 "{"		{
             yyset_column ( yyget_column(yyscanner) + 1,yyscanner);
+            yyget_extra(yyscanner)->structDepth++;
 			return LEX_BRACKETOPEN;
 		}
 
 "}"		{
             yyset_column ( yyget_column(yyscanner) + 1,yyscanner);
+            if (yyget_extra(yyscanner)->structDepth > 0) {
+                yyget_extra(yyscanner)->structDepth--;
+            }
 			return LEX_BRACKETCLOSE;
 		}
 
@@ -152,6 +168,7 @@ exp      ([eE][+-]?[0-9]+)
 
 [+-]?{decnum}                         { /* Simple integer */
                                         yylval->intVal = new tIntVal;
+                                        yylval->intVal->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->intVal->intVal = Properties4CXX::strToLL(yytext);
                                         yylval->intVal->intStr = yytext;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
@@ -161,6 +178,7 @@ exp      ([eE][+-]?[0-9]+)
 
 0[0-7]*                               { /* Octal number (incl. 0) */
                                         yylval->intVal = new tIntVal;
+                                        yylval->intVal->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->intVal->intVal = Properties4CXX::strOctToLL(yytext);
                                         yylval->intVal->intStr = yytext;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
@@ -169,6 +187,7 @@ exp      ([eE][+-]?[0-9]+)
 
 0[bB][01]+                               { /* Binary number */
                                         yylval->intVal = new tIntVal;
+                                        yylval->intVal->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->intVal->intVal = Properties4CXX::strBinToLL(yytext);
                                         yylval->intVal->intStr = yytext;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
@@ -178,6 +197,7 @@ exp      ([eE][+-]?[0-9]+)
 
 {hexnum}                              { /* hexadecimal number */
                                         yylval->intVal = new tIntVal;
+                                        yylval->intVal->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->intVal->intVal = Properties4CXX::strHexToLL(yytext);
                                         yylval->intVal->intStr = yytext;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
@@ -190,6 +210,7 @@ exp      ([eE][+-]?[0-9]+)
 										 * Floats like 1e10, 1e-5L, +1e+10, -1e-5
 										 */
                                         yylval->numVal = new tNumVal;
+                                        yylval->numVal->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->numVal->numVal = Properties4CXX::strToLD(yytext);
                                         yylval->numVal->numStr = yytext;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
@@ -201,6 +222,7 @@ exp      ([eE][+-]?[0-9]+)
 										* floats like -123E12 or 123.23e.2 or +023E-1.1
 									    */
                                         yylval->numVal = new tNumVal;
+                                        yylval->numVal->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->numVal->numVal = Properties4CXX::strToLD(yytext);
                                         yylval->numVal->numStr = yytext;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
@@ -213,6 +235,7 @@ exp      ([eE][+-]?[0-9]+)
 										 * floats like 3.14, -.1, +0.1e-1
 									    */
                                         yylval->numVal = new tNumVal;
+                                        yylval->numVal->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->numVal->numVal = Properties4CXX::strToLD(yytext);
                                         yylval->numVal->numStr = yytext;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
@@ -222,6 +245,7 @@ exp      ([eE][+-]?[0-9]+)
 
 ([yY][eE][sS])|([tT][rR][uU][eE])|([oO][nN]) { /* yes, true, on case insensitive */
                                         yylval->boolVal = new tBoolVal;
+                                        yylval->boolVal->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->boolVal->boolVal = true;
                                         yylval->boolVal->boolStr = yytext;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
@@ -231,6 +255,7 @@ exp      ([eE][+-]?[0-9]+)
 
 ([nN][oO])|([fF][aA][lL][sS][eE])|([oO][fF][fF]) { /* no, false, off case insensitive */
                                         yylval->boolVal = new tBoolVal;
+                                        yylval->boolVal->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->boolVal->boolVal = false;
                                         yylval->boolVal->boolStr = yytext;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
@@ -238,9 +263,11 @@ exp      ([eE][+-]?[0-9]+)
                                       }
 
 
-\"([^\"]|(\\\"))*\"                    { /* A quoted string */
+\"([^\"\\]|(\\(.|\n)))*\"           { /* A quoted string. A backslash escapes the next character, also a backslash */
                                         yylval->string = new tStrVal;
-                                        yylval->string->str = scanQuotedString(yytext);
+                                        yylval->string->offset = yyget_extra(yyscanner)->tokenOffset;
+                                        Properties4CXX::appendUnescapedQuotedString(yylval->string->str,yytext,yyleng);
+                                        yylval->string->length = yyleng;
                                         yylval->string->isQuotedString = true;
 										yy_countlines (yytext,yyscanner);
 
@@ -252,8 +279,10 @@ exp      ([eE][+-]?[0-9]+)
 
 [^\r\n \xc\t\"\{\},=]+	              {
                                         yylval->string = new tStrVal;
+                                        yylval->string->offset = yyget_extra(yyscanner)->tokenOffset;
                                         yylval->string->str = yytext;
                                         yylval->string->isQuotedString = false;
+                                        yylval->string->length = yyleng;
                                         yyset_column ( yyget_column(yyscanner) + strlen(yytext),yyscanner);
                                         return (LEX_IDENTIFIER);
                                        }
@@ -293,60 +322,14 @@ static void yy_countlines (char const* text, yyscan_t yyscanner)
 
 }
 
-std::string scanQuotedString (char const *quotedText) {
-std::string rc;
-char* outString = new char[strlen(quotedText)];
-int k=0;
-char c;
-
-    // Run through the string from the 2nd character, i.e. leave the initial double-quote out
-	for (++quotedText; *quotedText != '"'; ++quotedText) {
-		if (*quotedText == '\\') {
-		  // Here is a masked character
-		  quotedText++;
-		  switch (*quotedText) {
-
-		  case '"' :
-		  	 c = '"';
-		  	 break;
-		  case '\\' :
-		  	 c = '\\';
-		  	 break;
-		  case 'f' :
-		  	 c = '\f';
-		  	 break;
-		  case 'n' :
-		  	 c = '\n';
-		  	 break;
-		  case 'r' :
-		  	 c = '\r';
-		  	 break;
-		  case 't' :
-		  	 c = '\t';
-		  	 break;
-		  case 'v' :
-		  	 c = '\v';
-		  	 break;
-
-		  default:
-			 c = *quotedText;
-		  }
-
-		  outString[k] = c;
-
-		} else {
-		  // copy the character
-		  outString[k] = *quotedText;
-		}
-
-		k++;
-
-	}
-
-	outString[k] = '\0';
+// Remember the start of the next line when it is on the top level, i.e. outside of structures.
+static void yy_markLineStart (yyscan_t yyscanner)
+{
+tScanContext *scanContext = yyget_extra(yyscanner);
 
-	rc = outString;
-	delete [] outString;
+   if (scanContext->structDepth == 0) {
+      scanContext->lineStartOffset = scanContext->offset;
+      scanContext->lineStartLineNo = yyget_lineno(yyscanner);
+   }
 
-	return rc;
 }
@@ -0,0 +1,566 @@
+/*
+ * PropertiesBench.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: hor
+ *
+ *   This file is part of Properties4CXX, a Java-inspired properties reader
+ *   Copyright (C) 2018  Kai Horstmann
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Benchmark of parsing, lookup, and writing of synthetic configurations.
+ *
+ * Run with "make bench" or directly:
+ *
+ *   benchProperties [-s shapes] [-b sizes] [-r repeats] [-t threads] [-d dir] [-o results] [-k]
+ *   benchProperties -g file [-s shape] [-b size]
+ *
+ * shapes: Comma separated list of flat, nested, list, quote, numeric, or all. Default all
+ * sizes: Comma separated list of sizes with the optional suffixes K, M, G. Default 64K,1M,16M
+ * repeats: Number of timed runs of each measurement. The best one is reported. Default 3
+ * threads: Maximum number of parse threads. \see Properties::setParseThreads(). Default 0
+ * dir: Directory of the generated configuration files. Default the current directory
+ * results: File to which the results are appended. Default standard output
+ * -k: Keep the generated configuration files
+ * -g: Only generate the configuration file for the first shape and size
+ *
+ * Each combination of shape and size produces one line of JSON in the results.
+ * The peak RSS is the peak of the process so far. Sizes should therefore be given in increasing order.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "Properties4CXX/Properties.h"
+#include "Properties4CXX/Property.h"
+
+// Count all allocations of the process including the library.
+static std::atomic<unsigned long long> allocationCount {0};
+
+void *operator new (size_t size) {
+	allocationCount.fetch_add(1,std::memory_order_relaxed);
+	void *rc = malloc(size ? size : 1);
+	if (!rc) {
+		throw std::bad_alloc();
+	}
+	return rc;
+}
+
+void *operator new[] (size_t size) {
+	return operator new (size);
+}
+
+void operator delete (void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[] (void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete (void *ptr,size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete[] (void *ptr,size_t) noexcept {
+	free(ptr);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/// Deterministic pseudo random numbers. The generated files are identical on all platforms.
+class Random {
+public:
+	explicit Random (uint64_t seed) :state{seed} {}
+
+	uint64_t next () {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return state >> 17;
+	}
+
+	unsigned below (unsigned limit) {
+		return unsigned(next() % limit);
+	}
+
+private:
+	uint64_t state;
+};
+
+/// Output buffer which only counts the written bytes
+class CountingBuffer :public std::streambuf {
+public:
+	size_t count = 0;
+
+protected:
+	virtual int_type overflow (int_type c) override {
+		if (c != traits_type::eof()) {
+			count++;
+		}
+		return traits_type::not_eof(c);
+	}
+
+	virtual std::streamsize xsputn (char const *, std::streamsize n) override {
+		count += size_t(n);
+		return n;
+	}
+};
+
+/// Generates the top-level entries of one shape until the requested size is reached
+class Generator {
+public:
+	Generator (std::string const &shape,uint64_t seed) :shape{shape},random{seed} {}
+
+	/// Append the next complete top-level entry to \p out
+	void appendEntry (std::string &out) {
+		if (shape == "flat") {
+			appendFlat(out);
+		} else if (shape == "nested") {
+			appendNested(out,0);
+		} else if (shape == "list") {
+			appendList(out);
+		} else if (shape == "quote") {
+			appendQuote(out);
+		} else {
+			appendNumeric(out);
+		}
+		entryNo++;
+	}
+
+private:
+	std::string shape;
+	Random random;
+	unsigned long long entryNo = 0;
+
+	static constexpr unsigned nestingDepth = 8;
+	static constexpr unsigned listLength = 16;
+
+	void appendName (std::string &out,char const *prefix) {
+		out.append(prefix).append(std::to_string(entryNo));
+	}
+
+	void appendWord (std::string &out) {
+		static char const letters[] = "abcdefghijklmnopqrstuvwxyz";
+		// No word may be a boolean like "yes" or "off". Lists only accept strings.
+		static char const firstLetters[] = "bcdghjkmpqrsvwxz";
+		unsigned const length = 3 + random.below(10);
+
+		out.push_back(firstLetters[random.below(sizeof(firstLetters) - 1)]);
+		for (unsigned i = 1; i < length; i++) {
+			out.push_back(letters[random.below(26)]);
+		}
+	}
+
+	void appendFlat (std::string &out) {
+		appendName(out,"key");
+		out.append(" = ");
+		appendWord(out);
+		out.push_back('\n');
+	}
+
+	void appendNested (std::string &out,unsigned depth) {
+		out.append(depth,'\t');
+		out.append("level").append(std::to_string(depth)).append("_").append(std::to_string(entryNo)).append(" = {\n");
+		out.append(depth + 1,'\t').append("name = ");
+		appendWord(out);
+		out.append("\n");
+		out.append(depth + 1,'\t').append("value = ").append(std::to_string(random.below(100000) + 1)).append("\n");
+		if (depth + 1 < nestingDepth) {
+			appendNested(out,depth + 1);
+		}
+		out.append(depth + 1,'\t').append("}\n");
+	}
+
+	void appendList (std::string &out) {
+		appendName(out,"list");
+		out.append(" = ");
+		for (unsigned i = 0; i < listLength; i++) {
+			if (i > 0) {
+				out.append(" , ");
+			}
+			if (i % 4 == 3) {
+				out.append("\"");
+				appendWord(out);
+				out.append(" ");
+				appendWord(out);
+				out.append("\"");
+			} else {
+				appendWord(out);
+			}
+		}
+		out.push_back('\n');
+	}
+
+	void appendQuote (std::string &out) {
+		appendName(out,"text");
+		out.append(" = \"");
+		unsigned const words = 8 + random.below(24);
+		for (unsigned i = 0; i < words; i++) {
+			switch (random.below(8)) {
+			case 0:
+				out.append("\\\"");
+				break;
+			case 1:
+				out.append("\\\\");
+				break;
+			case 2:
+				out.append("\\t");
+				break;
+			case 3:
+				out.append("\\n");
+				break;
+			default:
+				out.push_back(' ');
+			}
+			appendWord(out);
+		}
+		out.append("\"\n");
+	}
+
+	void appendNumeric (std::string &out) {
+		appendName(out,"num");
+		out.append(" = ");
+		switch (entryNo % 5) {
+		case 0:
+			out.append(std::to_string(random.below(1000000000) + 1));
+			break;
+		case 1:
+			out.append("-").append(std::to_string(random.below(1000000) + 1)).append(".").append(std::to_string(random.below(1000)));
+			break;
+		case 2: {
+			char hex[24];
+			snprintf(hex,sizeof hex,"0x%llx",static_cast<unsigned long long>(random.next() & 0xffffffffffULL));
+			out.append(hex);
+			break;
+		}
+		case 3:
+			out.append(std::to_string(random.below(1000) + 1)).append("e").append(std::to_string(random.below(20)));
+			break;
+		default:
+			out.append(random.below(2) ? "true" : "off");
+		}
+		out.push_back('\n');
+	}
+};
+
+/// Write a configuration of \p shape with at least \p size bytes into \p fileName
+void generateFile (std::string const &fileName,std::string const &shape,uint64_t size) {
+
+	std::ofstream file(fileName,std::ios::binary | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Cannot create " + fileName);
+	}
+
+	Generator generator(shape,size);
+	std::string chunk;
+	uint64_t written = 0;
+
+	// Large files are generated in chunks. They never exist in memory as a whole.
+	while (written < size) {
+		chunk.clear();
+		while (chunk.size() < 1024 * 1024 && written + chunk.size() < size) {
+			generator.appendEntry(chunk);
+		}
+		file.write(chunk.data(),std::streamsize(chunk.size()));
+		written += chunk.size();
+	}
+
+	if (!file.flush()) {
+		throw std::runtime_error("Cannot write " + fileName);
+	}
+}
+
+uint64_t parseSize (std::string const &str) {
+
+	char *end = nullptr;
+	uint64_t size = strtoull(str.c_str(),&end,10);
+
+	switch (*end) {
+	case 'k':
+	case 'K':
+		size <<= 10;
+		break;
+	case 'm':
+	case 'M':
+		size <<= 20;
+		break;
+	case 'g':
+	case 'G':
+		size <<= 30;
+		break;
+	default:
+		break;
+	}
+
+	return size;
+}
+
+std::vector<std::string> splitList (std::string const &str) {
+
+	std::vector<std::string> rc;
+	std::istringstream is(str);
+	std::string item;
+
+	while (std::getline(is,item,',')) {
+		if (!item.empty()) {
+			rc.push_back(item);
+		}
+	}
+
+	return rc;
+}
+
+/// Collect the paths of all properties which are no structures
+void collectPaths (Properties4CXX::Properties const &props,std::string const &prefix,std::vector<std::string> &paths) {
+
+	for (auto const &it : props.getCPropertyMap()) {
+		std::string path = prefix.empty() ? it.first : prefix + "." + it.first;
+
+		if (it.second->isStruct()) {
+			collectPaths(it.second->getPropertiesStructure(),path,paths);
+		} else {
+			paths.push_back(std::move(path));
+		}
+	}
+}
+
+double secondsSince (Clock::time_point start) {
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+long peakRssKB () {
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF,&usage);
+
+	return usage.ru_maxrss;
+}
+
+/// Return the best time of \p repeats runs of \p func in nanoseconds per \p opsPerRun
+template <typename F> double bestNsPerOp (unsigned repeats,size_t opsPerRun,F const &func) {
+
+	double best = 0.0;
+
+	for (unsigned i = 0; i < repeats; i++) {
+		Clock::time_point const start = Clock::now();
+		func();
+		double const seconds = secondsSince(start);
+
+		if (i == 0 || seconds < best) {
+			best = seconds;
+		}
+	}
+
+	return best * 1e9 / double(opsPerRun ? opsPerRun : 1);
+}
+
+struct Options {
+	std::vector<std::string> shapes {"flat","nested","list","quote","numeric"};
+	std::vector<uint64_t> sizes {64 << 10,1 << 20,16 << 20};
+	unsigned repeats = 3;
+	unsigned threads = 0;
+	std::string directory = ".";
+	std::string resultsFile;
+	std::string generateOnly;
+	bool keepFiles = false;
+};
+
+/// Run all measurements for one shape and size, and append the result as a line of JSON to \p results
+void runCase (Options const &options,std::string const &shape,uint64_t size,std::ostream &results) {
+
+	static constexpr size_t lookupsPerRun = 200000;
+
+	std::string const fileName = options.directory + "/bench-" + shape + "-" + std::to_string(size) + ".cfg";
+	generateFile(fileName,shape,size);
+
+	struct stat fileStat;
+	stat(fileName.c_str(),&fileStat);
+	double const fileMB = double(fileStat.st_size) / (1024.0 * 1024.0);
+
+	// Parse. The last parsed configuration is kept for the other measurements.
+	Properties4CXX::Properties props(fileName);
+	props.setParseThreads(options.threads);
+
+	unsigned long long allocations = 0;
+	double const parseNs = bestNsPerOp(options.repeats,1,[&] {
+		unsigned long long const before = allocationCount.load(std::memory_order_relaxed);
+		props.readConfiguration();
+		allocations = allocationCount.load(std::memory_order_relaxed) - before;
+	});
+	long const rssKB = peakRssKB();
+
+	std::vector<std::string> paths;
+	collectPaths(props,std::string(),paths);
+
+	// Lookups of existing and missing paths in a fixed pseudo random order
+	std::vector<std::string> hitPaths;
+	std::vector<std::string> missPaths;
+	Random random(42);
+
+	for (size_t i = 0; i < lookupsPerRun && !paths.empty(); i++) {
+		std::string const &path = paths[random.next() % paths.size()];
+		hitPaths.push_back(path);
+		missPaths.push_back(path + "_missing");
+	}
+
+	size_t found = 0;
+	double const hitNs = bestNsPerOp(options.repeats,hitPaths.size(),[&] {
+		for (auto const &it : hitPaths) {
+			found += props.findPropertyPath(it) != nullptr;
+		}
+	});
+	double const missNs = bestNsPerOp(options.repeats,missPaths.size(),[&] {
+		for (auto const &it : missPaths) {
+			found += props.findPropertyPath(it) != nullptr;
+		}
+	});
+
+	// Write into a sink which only counts the bytes
+	CountingBuffer countingBuffer;
+	std::ostream sink(&countingBuffer);
+	double const writeNs = bestNsPerOp(options.repeats,1,[&] {
+		countingBuffer.count = 0;
+		props.writeOut(sink);
+	});
+	double const writeMB = double(countingBuffer.count) / (1024.0 * 1024.0);
+
+	if (!options.keepFiles) {
+		unlink(fileName.c_str());
+	}
+
+	results << "{\"shape\":\"" << shape << "\""
+			<< ",\"bytes\":" << fileStat.st_size
+			<< ",\"properties\":" << paths.size()
+			<< ",\"parse_threads\":" << options.threads
+			<< ",\"parse_mb_s\":" << fileMB * 1e9 / parseNs
+			<< ",\"lookup_hit_ns\":" << hitNs
+			<< ",\"lookup_miss_ns\":" << missNs
+			<< ",\"lookups_found\":" << found / options.repeats
+			<< ",\"write_mb_s\":" << writeMB * 1e9 / writeNs
+			<< ",\"allocs_per_property\":" << double(allocations) / double(paths.empty() ? 1 : paths.size())
+			<< ",\"peak_rss_kb\":" << rssKB
+			<< "}" << std::endl;
+}
+
+} // namespace
+
+int main (int argc,char **argv) {
+
+	Options options;
+	int opt;
+
+	while ((opt = getopt(argc,argv,"s:b:r:t:d:o:g:k")) != -1) {
+		switch (opt) {
+		case 's':
+			if (strcmp(optarg,"all") != 0) {
+				options.shapes = splitList(optarg);
+			}
+			break;
+		case 'b':
+			options.sizes.clear();
+			for (auto const &it : splitList(optarg)) {
+				options.sizes.push_back(parseSize(it));
+			}
+			break;
+		case 'r':
+			options.repeats = unsigned(std::max(1,atoi(optarg)));
+			break;
+		case 't':
+			options.threads = unsigned(std::max(0,atoi(optarg)));
+			break;
+		case 'd':
+			options.directory = optarg;
+			break;
+		case 'o':
+			options.resultsFile = optarg;
+			break;
+		case 'g':
+			options.generateOnly = optarg;
+			break;
+		case 'k':
+			options.keepFiles = true;
+			break;
+		default:
+			std::cerr << "Usage: " << argv[0] << " [-s shapes] [-b sizes] [-r repeats] [-t threads] [-d dir] [-o results] [-k]\n"
+					<< "       " << argv[0] << " -g file [-s shape] [-b size]" << std::endl;
+			return 2;
+		}
+	}
+
+	for (auto const &it : options.shapes) {
+		if (it != "flat" && it != "nested" && it != "list" && it != "quote" && it != "numeric") {
+			std::cerr << "Unknown shape " << it << std::endl;
+			return 2;
+		}
+	}
+
+	if (options.shapes.empty() || options.sizes.empty()) {
+		std::cerr << "No shape or size given" << std::endl;
+		return 2;
+	}
+
+	try {
+		if (!options.generateOnly.empty()) {
+			generateFile(options.generateOnly,options.shapes.front(),options.sizes.front());
+			return 0;
+		}
+
+		std::ofstream resultsFile;
+		if (!options.resultsFile.empty()) {
+			resultsFile.open(options.resultsFile,std::ios::app);
+			if (!resultsFile) {
+				std::cerr << "Cannot open " << options.resultsFile << std::endl;
+				return 1;
+			}
+		}
+		std::ostream &results = options.resultsFile.empty() ? std::cout : resultsFile;
+
+		for (auto size : options.sizes) {
+			for (auto const &shape : options.shapes) {
+				runCase(options,shape,size,results);
+			}
+		}
+	} catch (std::exception const &e) {
+		std::cerr << "Benchmark failed: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -30,9 +30,20 @@
 #include <iostream>
 #include <cstring>
 #include <clocale>
+#include <sstream>
+#include <thread>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
 
 #include "Properties4CXX/Properties.h"
 #include "Properties4CXX/Property.h"
+#include "Properties4CXX/PropertiesWriter.h"
+#include "Properties4CXX/LayeredProperties.h"
 
 static void testString (Properties4CXX::Properties const &props,const char* propName,char const *compVal) {
 
@@ -145,6 +156,32 @@ static void testList (Properties4CXX::Properties const &props,const char* propNa
 	}
 }
 
+/// Memory resource which counts the allocations and the bytes which are not released.
+class CountingResource: public std::pmr::memory_resource {
+public:
+	size_t allocations = 0;
+	size_t blocksInUse = 0;
+	size_t bytesInUse = 0;
+
+private:
+	void *do_allocate (size_t bytes,size_t alignment) override {
+		allocations++;
+		blocksInUse++;
+		bytesInUse += bytes;
+		return std::pmr::new_delete_resource()->allocate(bytes,alignment);
+	}
+
+	void do_deallocate (void *p,size_t bytes,size_t alignment) override {
+		blocksInUse--;
+		bytesInUse -= bytes;
+		std::pmr::new_delete_resource()->deallocate(p,bytes,alignment);
+	}
+
+	bool do_is_equal (std::pmr::memory_resource const &other) const noexcept override {
+		return this == &other;
+	}
+};
+
 
 int main(int argc,char**argv) {
 
@@ -305,6 +342,1363 @@ int main(int argc,char**argv) {
 	props.writeOut(outStream);
 	outStream.close();
 
+	// Content fingerprints
+	try {
+		Properties4CXX::Properties props2("PropertiesTest.properties");
+		props2.readConfiguration();
+		props2.addProperty(new Properties4CXX::PropertyDouble("newProp01",123.456));
+		props2.addProperty(new Properties4CXX::PropertyDouble("newProp02",-12345.678E+2));
+
+		if (props.getContentHash() == props2.getContentHash()) {
+			std::cout << "contentHash equal OK" << std::endl;
+		} else {
+			std::cout << "contentHash equal NOK: fingerprints of equal configurations differ" << std::endl;
+		}
+
+		if (props.searchProperty("prop24")->getContentHash() == props2.searchProperty("prop24")->getContentHash()) {
+			std::cout << "contentHash struct OK" << std::endl;
+		} else {
+			std::cout << "contentHash struct NOK: fingerprints of equal structures differ" << std::endl;
+		}
+
+		props2.deletePropery("prop01");
+		if (props.getContentHash() != props2.getContentHash()) {
+			std::cout << "contentHash delete OK" << std::endl;
+		} else {
+			std::cout << "contentHash delete NOK: fingerprint did not change" << std::endl;
+		}
+
+		props2.addProperty(new Properties4CXX::Property("prop01","aProperty",false));
+		if (props.getContentHash() == props2.getContentHash()) {
+			std::cout << "contentHash add OK" << std::endl;
+		} else {
+			std::cout << "contentHash add NOK: fingerprint not restored" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in contentHash test: " << e.what() << std::endl;
+	}
+
+	// Change subscriptions
+	try {
+		Properties4CXX::PropertyChangeList structChanges;
+		Properties4CXX::PropertyChangeList leafChanges;
+		int numStructCalls = 0;
+
+		outStream.open("PropertiesTestSubscribe.properties",outStream.out|outStream.trunc);
+		outStream << "a = 1\n b = { c = 2\n d = 3\n}\n e = x\n";
+		outStream.close();
+
+		Properties4CXX::Properties subscrProps("PropertiesTestSubscribe.properties");
+		subscrProps.readConfiguration();
+
+		subscrProps.subscribe("b.*",[&] (Properties4CXX::Properties const &,Properties4CXX::PropertyChangeList const &changes) {
+			structChanges = changes;
+			numStructCalls++;
+		});
+		Properties4CXX::Properties::SubscriptionId leafId =
+		subscrProps.subscribe("a",[&] (Properties4CXX::Properties const &,Properties4CXX::PropertyChangeList const &changes) {
+			leafChanges.insert(leafChanges.end(),changes.cbegin(),changes.cend());
+		});
+
+		outStream.open("PropertiesTestSubscribe.properties",outStream.out|outStream.trunc);
+		outStream << "a = 1\n b = { c = 2\n d = 4\n f = 5\n}\n e = y\n";
+		outStream.close();
+		subscrProps.readConfiguration();
+
+		if (numStructCalls == 1 && structChanges.size() == 2 &&
+				structChanges[0].propertyPath == "b.d" && structChanges[0].changeType == Properties4CXX::PropertyChange::Modified &&
+				structChanges[1].propertyPath == "b.f" && structChanges[1].changeType == Properties4CXX::PropertyChange::Added) {
+			std::cout << "subscribe reload OK" << std::endl;
+		} else {
+			std::cout << "subscribe reload NOK: " << numStructCalls << " calls, " << structChanges.size() << " changes" << std::endl;
+		}
+
+		if (leafChanges.empty()) {
+			std::cout << "subscribe unchanged OK" << std::endl;
+		} else {
+			std::cout << "subscribe unchanged NOK: unchanged property reported" << std::endl;
+		}
+
+		subscrProps.deletePropery("a");
+		subscrProps.unsubscribe(leafId);
+		subscrProps.addProperty(new Properties4CXX::PropertyInt("a",2LL));
+
+		if (leafChanges.size() == 1 && leafChanges[0].changeType == Properties4CXX::PropertyChange::Removed) {
+			std::cout << "subscribe modification OK" << std::endl;
+		} else {
+			std::cout << "subscribe modification NOK: " << leafChanges.size() << " changes" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in subscription test: " << e.what() << std::endl;
+	}
+
+	// Asynchronous reading
+	try {
+		Properties4CXX::Properties asyncProps("PropertiesTest.properties");
+		std::future<void> asyncRead = asyncProps.readConfigurationAsync();
+
+		asyncRead.get();
+		testString (asyncProps,"prop01","aProperty");
+
+		std::istringstream asyncStream(configFileContent);
+		Properties4CXX::Properties asyncStreamProps(&asyncStream);
+		std::thread asyncThread;
+
+		asyncRead = asyncStreamProps.readConfigurationAsync([&asyncThread] (std::function<void ()> const &task) {
+			asyncThread = std::thread(task);
+		});
+		asyncRead.get();
+		asyncThread.join();
+		testInt (asyncStreamProps,"prop03",112233);
+
+		// A second read while the first one is still scheduled is rejected
+		std::function<void ()> deferredTask;
+		asyncRead = asyncProps.readConfigurationAsync([&deferredTask] (std::function<void ()> const &task) {
+			deferredTask = task;
+		});
+		try {
+			asyncProps.readConfigurationAsync();
+			std::cout << "asynchronous read overlapping NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionConfigReadError const &e) {
+			std::cout << "asynchronous read overlapping OK" << std::endl;
+		}
+		deferredTask();
+		asyncRead.get();
+		asyncProps.readConfigurationAsync().get();
+		testString (asyncProps,"prop01","aProperty");
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in asynchronous read test: " << e.what() << std::endl;
+	}
+
+	// Parallel loading of a conf.d directory
+	try {
+		std::filesystem::remove_all("PropertiesTest.d");
+		std::filesystem::create_directory("PropertiesTest.d");
+
+		for (int i = 0; i < 20; i++) {
+			std::string fileName = "PropertiesTest.d/" + std::to_string(i) + ".conf";
+			outStream.open(fileName,outStream.out|outStream.trunc);
+			outStream << "dirProp" << i << " = " << i << "\n dirStruct" << i << " = {\n  a = \"" << i << "\"\n }\n";
+			outStream.close();
+		}
+		outStream.open("PropertiesTest.d/README",outStream.out|outStream.trunc);
+		outStream << "This file is not read\n";
+		outStream.close();
+
+		Properties4CXX::Properties dirProps;
+		dirProps.loadDirectory("PropertiesTest.d",".conf");
+
+		if (dirProps.numProperties() == 40) {
+			std::cout << "loadDirectory OK" << std::endl;
+		} else {
+			std::cout << "loadDirectory NOK: " << dirProps.numProperties() << " properties" << std::endl;
+		}
+		testInt(dirProps,"dirProp7",7);
+		testString(dirProps.searchProperty("dirStruct13")->getPropertiesStructure(),"a","13");
+
+		outStream.open("PropertiesTest.d/99.conf",outStream.out|outStream.trunc);
+		outStream << "dirProp3 = 3\n";
+		outStream.close();
+
+		try {
+			dirProps.loadDirectory("PropertiesTest.d",".conf");
+			std::cout << "loadDirectory duplicate NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionPropertyDuplicate const &e) {
+			std::cout << "loadDirectory duplicate OK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in directory test: " << e.what() << std::endl;
+	}
+
+	// Parallel parsing of a large configuration
+	try {
+		outStream.open("PropertiesTestLarge.properties",outStream.out|outStream.trunc);
+		for (int i = 0; i < 40000; i++) {
+			outStream << "large" << i << " = \"multi\nline { \\\" # value\" # comment \"\n"
+					<< "# column 0 comment with \"quotes\" and {brackets}\n"
+					<< "largeStruct" << i << " = {\n# closing } here\n  a = " << i << "\n  b = x, \"y}\"\n}\n";
+		}
+		outStream.close();
+
+		Properties4CXX::Properties seqProps("PropertiesTestLarge.properties");
+		seqProps.readConfiguration();
+
+		Properties4CXX::Properties parProps("PropertiesTestLarge.properties");
+		parProps.setParseThreads(4);
+		parProps.readConfiguration();
+
+		if (parProps.numProperties() == 80000 && parProps.getContentHash() == seqProps.getContentHash()) {
+			std::cout << "parallel parse OK" << std::endl;
+		} else {
+			std::cout << "parallel parse NOK: " << parProps.numProperties() << " properties" << std::endl;
+		}
+		testInt(parProps.searchProperty("largeStruct39999")->getPropertiesStructure(),"a",39999);
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in parallel parse test: " << e.what() << std::endl;
+	}
+
+	// Parallel parsing of quoted strings which end with an escaped backslash
+	try {
+		outStream.open("PropertiesTestEscaped.properties",outStream.out|outStream.trunc);
+		for (int i = 0; i < 40000; i++) {
+			outStream << "escaped" << i << " = \"abc\\\\\"\n"
+					<< "afterEscaped" << i << " = \"multi\nline\"\n";
+		}
+		outStream.close();
+
+		Properties4CXX::Properties seqProps("PropertiesTestEscaped.properties");
+		seqProps.readConfiguration();
+
+		Properties4CXX::Properties parProps("PropertiesTestEscaped.properties");
+		parProps.setParseThreads(4);
+		parProps.readConfiguration();
+
+		if (parProps.numProperties() == 80000 && parProps.getContentHash() == seqProps.getContentHash()) {
+			std::cout << "parallel parse escaped backslash OK" << std::endl;
+		} else {
+			std::cout << "parallel parse escaped backslash NOK: " << parProps.numProperties() << " properties" << std::endl;
+		}
+		testString(parProps,"escaped39999","abc\\");
+		testString(parProps,"afterEscaped39999","multi\nline");
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in parallel parse escaped backslash test: " << e.what() << std::endl;
+	}
+
+	// Incremental reload
+	try {
+		Properties4CXX::PropertyChangeList incrChanges;
+
+		outStream.open("PropertiesTestIncremental.properties",outStream.out|outStream.trunc);
+		outStream << "a = 1\nb = {\n c = 2\n d = 3\n}\n# comment\ne = x\nf = y\n";
+		outStream.close();
+
+		Properties4CXX::Properties incrProps("PropertiesTestIncremental.properties");
+		incrProps.setIncrementalReload(true);
+		incrProps.readConfiguration();
+		incrProps.subscribe("*",[&] (Properties4CXX::Properties const &,Properties4CXX::PropertyChangeList const &changes) {
+			incrChanges = changes;
+		});
+
+		std::string const newContent = "new = 0\na = 1\nb = {\n c = 2\n d = 4\n}\n# comment\nf = y\n";
+		outStream.open("PropertiesTestIncremental.properties",outStream.out|outStream.trunc);
+		outStream << newContent;
+		outStream.close();
+		incrProps.readConfiguration();
+
+		Properties4CXX::Properties fullProps("PropertiesTestIncremental.properties");
+		fullProps.readConfiguration();
+
+		if (incrProps.numProperties() == 4 && incrProps.getContentHash() == fullProps.getContentHash()) {
+			std::cout << "incremental reload OK" << std::endl;
+		} else {
+			std::cout << "incremental reload NOK: " << incrProps.numProperties() << " properties" << std::endl;
+		}
+
+		if (incrChanges.size() == 3 &&
+				incrChanges[0].propertyPath == "b.d" && incrChanges[0].changeType == Properties4CXX::PropertyChange::Modified &&
+				incrChanges[1].propertyPath == "e" && incrChanges[1].changeType == Properties4CXX::PropertyChange::Removed &&
+				incrChanges[2].propertyPath == "new" && incrChanges[2].changeType == Properties4CXX::PropertyChange::Added) {
+			std::cout << "incremental reload changes OK" << std::endl;
+		} else {
+			std::cout << "incremental reload changes NOK: " << incrChanges.size() << " changes" << std::endl;
+		}
+
+		if (incrProps.searchProperty("f")->getSourceOffset() == newContent.find("f = y")) {
+			std::cout << "incremental reload offsets OK" << std::endl;
+		} else {
+			std::cout << "incremental reload offsets NOK: " << incrProps.searchProperty("f")->getSourceOffset() << std::endl;
+		}
+
+		outStream.open("PropertiesTestIncremental.properties",outStream.out|outStream.trunc);
+		outStream << newContent << "a = 2\n";
+		outStream.close();
+
+		try {
+			incrProps.readConfiguration();
+			std::cout << "incremental reload duplicate NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionPropertyDuplicate const &e) {
+			std::cout << "incremental reload duplicate OK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in incremental reload test: " << e.what() << std::endl;
+	}
+
+	// Reading appended overrides
+	try {
+		Properties4CXX::PropertyChangeList appendChanges;
+
+		outStream.open("PropertiesTestAppend.properties",outStream.out|outStream.trunc);
+		outStream << "a = 1\nb = 2\n";
+		outStream.close();
+
+		Properties4CXX::Properties appendProps("PropertiesTestAppend.properties");
+		appendProps.readConfiguration();
+		appendProps.subscribe("*",[&] (Properties4CXX::Properties const &,Properties4CXX::PropertyChangeList const &changes) {
+			appendChanges = changes;
+		});
+
+		outStream.open("PropertiesTestAppend.properties",outStream.out|outStream.app);
+		outStream << "a = 3\nc = 4\nc = 5\nd = 6";
+		outStream.close();
+		appendProps.readAppended();
+
+		if (appendProps.numProperties() == 3 && appendChanges.size() == 2 &&
+				appendChanges[0].propertyPath == "a" && appendChanges[0].changeType == Properties4CXX::PropertyChange::Modified &&
+				appendChanges[1].propertyPath == "c" && appendChanges[1].changeType == Properties4CXX::PropertyChange::Added) {
+			std::cout << "readAppended OK" << std::endl;
+		} else {
+			std::cout << "readAppended NOK: " << appendProps.numProperties() << " properties, " << appendChanges.size() << " changes" << std::endl;
+		}
+		testInt(appendProps,"a",3);
+		testInt(appendProps,"c",5);
+
+		outStream.open("PropertiesTestAppend.properties",outStream.out|outStream.app);
+		outStream << "\n";
+		outStream.close();
+		appendProps.readAppended();
+		testInt(appendProps,"d",6);
+
+		outStream.open("PropertiesTestAppend.properties",outStream.out|outStream.trunc);
+		outStream << "x = 1\n";
+		outStream.close();
+		appendProps.readAppended();
+
+		if (appendProps.numProperties() == 1) {
+			std::cout << "readAppended truncated OK" << std::endl;
+		} else {
+			std::cout << "readAppended truncated NOK: " << appendProps.numProperties() << " properties" << std::endl;
+		}
+
+		// Brackets and quotes in comments at the start of a line must not hold back later lines
+		outStream.open("PropertiesTestAppend.properties",outStream.out|outStream.app);
+		outStream << "z = 3\n# note { \"\ny = 2\n";
+		outStream.close();
+		appendProps.readAppended();
+		testInt(appendProps,"z",3);
+		testInt(appendProps,"y",2);
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in readAppended test: " << e.what() << std::endl;
+	}
+
+	// Buffered writer
+	try {
+		std::ostringstream streamOut;
+		props.writeOut(streamOut);
+
+		Properties4CXX::PropertiesWriter prettyWriter;
+		prettyWriter.write(props);
+
+		if (prettyWriter.str() == streamOut.str()) {
+			std::cout << "writer pretty OK" << std::endl;
+		} else {
+			std::cout << "writer pretty NOK: output differs from writeOut" << std::endl;
+		}
+
+		Properties4CXX::PropertiesWriter compactWriter(Properties4CXX::PropertiesWriter::Compact);
+		compactWriter.write(props);
+
+		std::istringstream compactStream(compactWriter.str());
+		Properties4CXX::Properties compactProps(&compactStream);
+		compactProps.readConfiguration();
+
+		if (compactWriter.size() < prettyWriter.size() && compactProps.getContentHash() == props.getContentHash()) {
+			std::cout << "writer compact OK" << std::endl;
+		} else {
+			std::cout << "writer compact NOK: " << compactWriter.size() << " bytes" << std::endl;
+		}
+
+		FILE *writerFile = fopen("PropertiesTestWriter.properties","w");
+		bool flushedWhileWriting;
+		{
+			Properties4CXX::PropertiesWriter fdWriter(fileno(writerFile),Properties4CXX::PropertiesWriter::Pretty,256);
+			fdWriter.write(props);
+			// The buffer is flushed while writing, not only at the end
+			flushedWhileWriting = prettyWriter.size() > 1024 && fdWriter.size() < 1024;
+			fdWriter.flush();
+		}
+		fclose(writerFile);
+
+		Properties4CXX::Properties fdProps("PropertiesTestWriter.properties");
+		fdProps.readConfiguration();
+
+		if (flushedWhileWriting && fdProps.getContentHash() == props.getContentHash()) {
+			std::cout << "writer file descriptor OK" << std::endl;
+		} else {
+			std::cout << "writer file descriptor NOK: configuration differs" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in writer test: " << e.what() << std::endl;
+	}
+
+	// Escaping and unescaping of long quoted strings across block boundaries
+	try {
+		Properties4CXX::Properties escapeProps;
+		std::vector<std::string> values;
+
+		for (int i = 0; i < 70; i++) {
+			std::string value(i,'x');
+			value.append("\"quoted\" back\\slash\ttab\nnewline\rreturn\fff\vvt\x01");
+			value.append(70 - i,'y');
+			value.append(i % 3 == 0 ? "\\end" : "\"");
+			values.push_back(value);
+			escapeProps.addProperty(new Properties4CXX::Property(("esc" + std::to_string(100 + i)).c_str(),value.c_str(),true));
+		}
+
+		Properties4CXX::PropertiesWriter escapeWriter(Properties4CXX::PropertiesWriter::Compact);
+		escapeWriter.write(escapeProps);
+
+		std::istringstream escapeStream(escapeWriter.str());
+		Properties4CXX::Properties escapeReadProps(&escapeStream);
+		escapeReadProps.readConfiguration();
+
+		int numEscapeErrors = 0;
+		for (int i = 0; i < 70; i++) {
+			if (escapeReadProps.searchProperty("esc" + std::to_string(100 + i))->getStringValue() != values[i]) {
+				numEscapeErrors++;
+			}
+		}
+
+		if (numEscapeErrors == 0) {
+			std::cout << "escape round trip OK" << std::endl;
+		} else {
+			std::cout << "escape round trip NOK: " << numEscapeErrors << " strings differ" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in escape test: " << e.what() << std::endl;
+	}
+
+	// Atomic save
+	try {
+		std::filesystem::remove_all("PropertiesTestSave.d");
+		std::filesystem::create_directory("PropertiesTestSave.d");
+
+		outStream.open("PropertiesTestSave.d/save.properties",outStream.out|outStream.trunc);
+		outStream << "old = 1\n";
+		outStream.close();
+
+		props.saveToFile("PropertiesTestSave.d/save.properties");
+
+		Properties4CXX::Properties savedProps("PropertiesTestSave.d/save.properties");
+		savedProps.readConfiguration();
+
+		int numFiles = 0;
+		for (auto const &it : std::filesystem::directory_iterator("PropertiesTestSave.d")) {
+			(void)it;
+			numFiles++;
+		}
+
+		if (savedProps.getContentHash() == props.getContentHash() && numFiles == 1) {
+			std::cout << "saveToFile OK" << std::endl;
+		} else {
+			std::cout << "saveToFile NOK: " << numFiles << " files in the directory" << std::endl;
+		}
+
+		try {
+			props.saveToFile("PropertiesTestSave.d/missing/save.properties");
+			std::cout << "saveToFile error NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionConfigWriteError const &e) {
+			std::cout << "saveToFile error OK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in save test: " << e.what() << std::endl;
+	}
+
+	// Formatting-preserving patches
+	try {
+		char const *patchText =
+				"# Comment before\n"
+				"a   =   1   # keep this comment\n"
+				"b = {\n"
+				"\t# Nested comment\n"
+				"\td = \"old value\"\n"
+				"\te = on\n"
+				"\t}\n"
+				"list = x , y , z\n";
+
+		outStream.open("PropertiesTestPatch.properties",outStream.out|outStream.trunc);
+		outStream << patchText;
+		outStream.close();
+
+		Properties4CXX::Properties patchProps("PropertiesTestPatch.properties");
+		patchProps.setIncrementalReload(true);
+		patchProps.readConfiguration();
+
+		Properties4CXX::PropertyPatchList patches {
+			{"a","4711",false},
+			{"b.d","new \"value\"",true},
+			{"list","p,q",false}
+		};
+		patchProps.applyPatches("PropertiesTestPatch.properties",patches);
+
+		std::ifstream patchedStream("PropertiesTestPatch.properties");
+		std::string patchedText((std::istreambuf_iterator<char>(patchedStream)),std::istreambuf_iterator<char>());
+
+		std::string expectedText (patchText);
+		expectedText.replace(expectedText.find("1   #"),1,"4711");
+		expectedText.replace(expectedText.find("\"old value\""),11,"\"new \\\"value\\\"\"");
+		expectedText.replace(expectedText.find("x , y , z"),9,"p,q");
+
+		patchProps.readConfiguration();
+
+		if (patchedText == expectedText
+				&& patchProps.getPropertyValue("a",0LL) == 4711
+				&& patchProps.searchPropertyPath("b.d")->getStringValue() == "new \"value\""
+				&& patchProps.searchPropertyPath("b.e")->getBoolValue()
+				&& patchProps.searchProperty("list")->getPropertyValueList().size() == 2) {
+			std::cout << "applyPatches OK" << std::endl;
+		} else {
+			std::cout << "applyPatches NOK: " << patchedText << std::endl;
+		}
+
+		try {
+			patchProps.applyPatches("PropertiesTestPatch.properties",{{"b.missing","1",false}});
+			std::cout << "applyPatches unknown property NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionPropertyNotFound const &e) {
+			std::cout << "applyPatches unknown property OK" << std::endl;
+		}
+
+		outStream.open("PropertiesTestPatch.properties",outStream.out|outStream.app);
+		outStream << "appended = 1\n";
+		outStream.close();
+
+		try {
+			patchProps.applyPatches("PropertiesTestPatch.properties",{{"a","5",false}});
+			std::cout << "applyPatches modified file NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionConfigWriteError const &e) {
+			std::cout << "applyPatches modified file OK" << std::endl;
+		}
+
+		// An edit of the same length since the load
+		patchProps.readConfiguration();
+		std::ifstream sameLengthStream("PropertiesTestPatch.properties");
+		std::string sameLengthText((std::istreambuf_iterator<char>(sameLengthStream)),std::istreambuf_iterator<char>());
+		sameLengthStream.close();
+		sameLengthText.replace(sameLengthText.find("4711"),4,"4712");
+		outStream.open("PropertiesTestPatch.properties",outStream.out|outStream.trunc);
+		outStream << sameLengthText;
+		outStream.close();
+
+		try {
+			patchProps.applyPatches("PropertiesTestPatch.properties",{{"a","5",false}});
+			std::cout << "applyPatches same length edit NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionConfigWriteError const &e) {
+			std::cout << "applyPatches same length edit OK" << std::endl;
+		}
+
+		// Parsed from the stream, and appended afterwards
+		Properties4CXX::Properties appendPatchProps("PropertiesTestPatch.properties");
+		appendPatchProps.readConfiguration();
+		outStream.open("PropertiesTestPatch.properties",outStream.out|outStream.app);
+		outStream << "appended2 = 2\n";
+		outStream.close();
+		appendPatchProps.readAppended();
+		appendPatchProps.applyPatches("PropertiesTestPatch.properties",{{"appended2","3",false}});
+		appendPatchProps.readConfiguration();
+		testInt(appendPatchProps,"appended2",3);
+		testInt(appendPatchProps,"a",4712);
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in patch test: " << e.what() << std::endl;
+	}
+
+	// Include directive
+	try {
+		std::filesystem::remove_all("PropertiesTestInclude.d");
+		std::filesystem::create_directories("PropertiesTestInclude.d/shared");
+
+		outStream.open("PropertiesTestInclude.d/shared/db.properties",outStream.out|outStream.trunc);
+		outStream << "host = dbhost\nport = 5432\ninclude \"pool.properties\"\n";
+		outStream.close();
+
+		outStream.open("PropertiesTestInclude.d/shared/pool.properties",outStream.out|outStream.trunc);
+		outStream << "poolSize = 8\n";
+		outStream.close();
+
+		outStream.open("PropertiesTestInclude.d/a.properties",outStream.out|outStream.trunc);
+		outStream << "name = a\ndb = {\n\tinclude \"shared/db.properties\"\n\t}\n";
+		outStream.close();
+
+		outStream.open("PropertiesTestInclude.d/b.properties",outStream.out|outStream.trunc);
+		outStream << "# Top level include\ninclude shared/db.properties\nname = b\n";
+		outStream.close();
+
+		Properties4CXX::Properties includeA("PropertiesTestInclude.d/a.properties");
+		Properties4CXX::Properties includeB("PropertiesTestInclude.d/b.properties");
+		Properties4CXX::Properties includeB2("PropertiesTestInclude.d/b.properties");
+		includeA.setIncrementalReload(true);
+		includeA.readConfiguration();
+		includeB.readConfiguration();
+		includeB2.readConfiguration();
+
+		Properties4CXX::Property const *portA = includeA.searchPropertyPath("db.port");
+		Properties4CXX::Property const *portB = includeB.searchProperty("port");
+
+		// Shared on the same level. Inside the structure of a the fragment is copied to level 1.
+		if (portB == includeB2.searchProperty("port") && portB->getIntVal() == 5432
+				&& portA->getStructLevel() == 1 && portB->getStructLevel() == 0
+				&& includeA.searchPropertyPath("db.poolSize")->getStructLevel() == 1
+				&& includeA.searchPropertyPath("db.poolSize")->getIntVal() == 8
+				&& includeB.searchProperty("name")->getStringValue() == "b") {
+			std::cout << "include shared OK" << std::endl;
+		} else {
+			std::cout << "include shared NOK" << std::endl;
+		}
+
+		outStream.open("PropertiesTestInclude.d/shared/pool.properties",outStream.out|outStream.trunc);
+		outStream << "poolSize = 16\n";
+		outStream.close();
+
+		includeA.readConfiguration();
+
+		if (includeA.searchPropertyPath("db.poolSize")->getIntVal() == 16
+				&& includeA.searchPropertyPath("db.port")->getIntVal() == 5432) {
+			std::cout << "include reload OK" << std::endl;
+		} else {
+			std::cout << "include reload NOK" << std::endl;
+		}
+
+		outStream.open("PropertiesTestInclude.d/shared/pool.properties",outStream.out|outStream.trunc);
+		outStream << "include \"db.properties\"\n";
+		outStream.close();
+
+		try {
+			includeB.readConfiguration();
+			std::cout << "include cycle NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionConfigReadError const &e) {
+			std::cout << "include cycle OK" << std::endl;
+		}
+
+		// Parallel parsers which include the same file
+		std::filesystem::create_directories("PropertiesTestInclude.d/parallel");
+		outStream.open("PropertiesTestInclude.d/parallelShared.properties",outStream.out|outStream.trunc);
+		outStream << "shared = 1\n";
+		outStream.close();
+		for (int i = 0; i < 16; i++) {
+			outStream.open("PropertiesTestInclude.d/parallel/" + std::to_string(i) + ".conf",outStream.out|outStream.trunc);
+			outStream << "s" << i << " = {\n\tinclude \"../parallelShared.properties\"\n\t}\n";
+			outStream.close();
+		}
+
+		Properties4CXX::Properties parallelIncludes;
+		parallelIncludes.loadDirectory("PropertiesTestInclude.d/parallel",".conf");
+
+		if (parallelIncludes.numProperties() == 16 && parallelIncludes.searchPropertyPath("s15.shared")->getIntVal() == 1) {
+			std::cout << "include parallel OK" << std::endl;
+		} else {
+			std::cout << "include parallel NOK" << std::endl;
+		}
+
+		Properties4CXX::Properties::clearIncludeCache();
+
+		// A property which is not shared is moved to the level of the structure in place.
+		Properties4CXX::PropertyStruct levelStruct("levels");
+		Properties4CXX::Property *levelProperty = new Properties4CXX::Property("a","b");
+		levelStruct.addProperty(levelProperty);
+
+		if (levelStruct.getPropertiesStructure().searchProperty("a") == levelProperty && levelProperty->getStructLevel() == 1) {
+			std::cout << "include level in place OK" << std::endl;
+		} else {
+			std::cout << "include level in place NOK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in include test: " << e.what() << std::endl;
+	}
+
+	// Layered configurations
+	try {
+		std::istringstream defaultsStream("name = defaults\nport = 80\ndb = {\n\thost = localhost\n\tport = 5432\n\t}\nlist = a,b\n");
+		std::istringstream hostStream("port = 8080\ndb = {\n\thost = dbhost\n\t}\n");
+		std::istringstream overrideStream("list = single\nextra = yes\n");
+
+		Properties4CXX::Properties defaultsLayer(&defaultsStream);
+		Properties4CXX::Properties hostLayer(&hostStream);
+		Properties4CXX::Properties overrideLayer(&overrideStream);
+		defaultsLayer.readConfiguration();
+		hostLayer.readConfiguration();
+		overrideLayer.readConfiguration();
+
+		Properties4CXX::LayeredProperties layered;
+		layered.pushLayer(defaultsLayer);
+		layered.pushLayer(hostLayer);
+		layered.pushLayer(overrideLayer);
+
+		if (layered.getPropertyValue("port",0LL) == 8080
+				&& std::string(layered.getPropertyValue("db.host","")) == "dbhost"
+				&& layered.getPropertyValue("db.port",0LL) == 5432
+				&& std::string(layered.getPropertyValue("list","")) == "single"
+				&& layered.getPropertyValue("extra",false)
+				&& layered.findPropertyPath("missing") == nullptr) {
+			std::cout << "layered lookup OK" << std::endl;
+		} else {
+			std::cout << "layered lookup NOK" << std::endl;
+		}
+
+		std::string mergedPaths;
+		for (auto const &it : layered) {
+			mergedPaths.append(it.path).append("=").append(it.property->getStringValue()).append(";");
+		}
+
+		if (mergedPaths == "db.host=dbhost;db.port=5432;extra=yes;list=single;name=defaults;port=8080;") {
+			std::cout << "layered iteration OK" << std::endl;
+		} else {
+			std::cout << "layered iteration NOK: " << mergedPaths << std::endl;
+		}
+
+		hostLayer.addProperty(new Properties4CXX::Property("added","1"));
+		bool const foundBeforeRefresh = layered.findPropertyPath("added") != nullptr;
+		layered.refresh();
+
+		if (foundBeforeRefresh && layered.findPropertyPath("added") != nullptr) {
+			std::cout << "layered refresh OK" << std::endl;
+		} else {
+			std::cout << "layered refresh NOK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in layered test: " << e.what() << std::endl;
+	}
+
+	// Interpolation of references
+	try {
+		setenv("PROPERTIESTEST_USER","tester",1);
+
+		std::istringstream interpolationStream(
+				"host = example.com\n"
+				"port = 8080\n"
+				"db = {\n\tname = \"${env:PROPERTIESTEST_USER}db\"\n\t}\n"
+				"url = \"http://${host}:${port}/${db.name}?user=${PROPERTIESTEST_USER}&cost=$5&lit=$${x}\"\n"
+				"cycleA = \"${cycleB}\"\n"
+				"cycleB = \"x${cycleA}\"\n"
+				"unknown = \"${noSuchPropertyOrVariable}\"\n");
+		Properties4CXX::Properties interpolationProps(&interpolationStream);
+		interpolationProps.readConfiguration();
+
+		std::string const &url = interpolationProps.getInterpolatedValue("url");
+		std::string const &urlAgain = interpolationProps.getInterpolatedValue("url");
+
+		if (url == "http://example.com:8080/testerdb?user=tester&cost=$5&lit=${x}" && &url == &urlAgain) {
+			std::cout << "interpolation OK" << std::endl;
+		} else {
+			std::cout << "interpolation NOK: " << url << std::endl;
+		}
+
+		try {
+			interpolationProps.getInterpolatedValue("cycleA");
+			std::cout << "interpolation cycle NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionInterpolationCycle const &e) {
+			std::cout << "interpolation cycle OK" << std::endl;
+		}
+
+		try {
+			interpolationProps.getInterpolatedValue("unknown");
+			std::cout << "interpolation unknown NOK: no exception" << std::endl;
+		} catch (Properties4CXX::ExceptionPropertyNotFound const &e) {
+			std::cout << "interpolation unknown OK" << std::endl;
+		}
+
+		interpolationProps.deletePropery("port");
+		interpolationProps.addProperty(new Properties4CXX::PropertyInt("port","9090",9090));
+
+		if (interpolationProps.getInterpolatedValue("url") == "http://example.com:9090/testerdb?user=tester&cost=$5&lit=${x}") {
+			std::cout << "interpolation invalidation OK" << std::endl;
+		} else {
+			std::cout << "interpolation invalidation NOK: " << interpolationProps.getInterpolatedValue("url") << std::endl;
+		}
+
+		// The copy shares the property url, but resolves it with its own host.
+		Properties4CXX::Properties interpolationCopy(interpolationProps);
+		std::string const &urlOriginal = interpolationProps.getInterpolatedValue("url");
+
+		interpolationCopy.deletePropery("host");
+		interpolationCopy.addProperty(new Properties4CXX::Property("host","other.org"));
+
+		if (interpolationCopy.getInterpolatedValue("url") == "http://other.org:9090/testerdb?user=tester&cost=$5&lit=${x}"
+				&& urlOriginal == "http://example.com:9090/testerdb?user=tester&cost=$5&lit=${x}"
+				&& &urlOriginal == &interpolationProps.getInterpolatedValue("url")) {
+			std::cout << "interpolation per configuration OK" << std::endl;
+		} else {
+			std::cout << "interpolation per configuration NOK: " << urlOriginal << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in interpolation test: " << e.what() << std::endl;
+	}
+
+	// Overrides from the environment
+	try {
+		setenv("PROPERTIESTEST_DB__PORT","5433",1);
+		setenv("PROPERTIESTEST_DB__HOST","db.internal",1);
+		setenv("PROPERTIESTEST_DB__POOL__SIZE","8",1);
+		setenv("PROPERTIESTEST_RATIO","0.5",1);
+		setenv("PROPERTIESTEST_DEBUG","on",1);
+		setenv("PROPERTIESTEST_GREETING","hello world",1);
+		setenv("PROPERTIESTEST_NAME","unchanged",1);
+
+		for (bool incremental : {false,true}) {
+			std::istringstream overrideStream(
+					"name = unchanged\n"
+					"db = {\n\thost = localhost\n\tport = 5432\n\tuser = app\n\t}\n"
+					"debug = off\n");
+			Properties4CXX::Properties overrideProps(&overrideStream);
+
+			overrideProps.setIncrementalReload(incremental);
+			overrideProps.setEnvironmentOverrides("PROPERTIESTEST_");
+			overrideProps.readConfiguration();
+
+			Properties4CXX::Property const *port = overrideProps.searchPropertyPath("db.port");
+			Properties4CXX::Property const *ratio = overrideProps.searchPropertyPath("ratio");
+
+			if (port->isInteger() && port->getIntVal() == 5433 &&
+					overrideProps.searchPropertyPath("db.host")->getStringValue() == "db.internal" &&
+					overrideProps.searchPropertyPath("db.user")->getStringValue() == "app" &&
+					overrideProps.searchPropertyPath("db.pool.size")->getIntVal() == 8 &&
+					ratio->isDouble() && ratio->getDoubleValue() == 0.5 &&
+					overrideProps.getPropertyValue("debug",false) == true &&
+					overrideProps.searchPropertyPath("greeting")->getStringValue() == "hello world" &&
+					overrideProps.searchPropertyPath("name")->getSourceValueLength() != 0) {
+				std::cout << "environment overrides " << (incremental ? "incremental " : "") << "OK" << std::endl;
+			} else {
+				std::cout << "environment overrides " << (incremental ? "incremental " : "") << "NOK" << std::endl;
+			}
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in environment override test: " << e.what() << std::endl;
+	}
+
+	// Statistics of a load
+	try {
+		std::istringstream statsStream(
+				"name = value\n"
+				"count = 42\n"
+				"outer = {\n\tinner = {\n\t\tflag = yes\n\t\t}\n\tlist = a , \"b c\"\n\t}\n");
+		Properties4CXX::Properties statsProps(&statsStream);
+
+		statsProps.setCollectParseStats(true);
+		statsProps.readConfiguration();
+
+		Properties4CXX::ParseStats const &stats = statsProps.getParseStats();
+
+		if (!Properties4CXX::Properties::isParseStatsAvailable()) {
+			if (stats.properties == 0 && stats.bytesRead == 0) {
+				std::cout << "parse statistics (not configured) OK" << std::endl;
+			} else {
+				std::cout << "parse statistics (not configured) NOK" << std::endl;
+			}
+		} else if (stats.properties == 6 && stats.structs == 2 && stats.maxStructDepth == 2 &&
+				stats.tokens[Properties4CXX::ParseStats::Assign] == 6 &&
+				stats.tokens[Properties4CXX::ParseStats::QuotedString] == 1 &&
+				stats.bytesRead == statsStream.str().size() && stats.errors == 0) {
+			std::cout << "parse statistics OK" << std::endl;
+		} else {
+			std::cout << "parse statistics NOK: " << stats.properties << " properties, " << stats.structs << " structures, depth "
+					<< stats.maxStructDepth << ", " << stats.bytesRead << " bytes" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in parse statistics test: " << e.what() << std::endl;
+	}
+
+	// Profiling of accesses
+	try {
+		std::istringstream profileStream(
+				"hot = 1\n"
+				"cold = 2\n"
+				"db = {\n\thost = localhost\n\tport = 5432\n\t}\n"
+				"cache = {\n\tsize = 10\n\t}\n");
+		Properties4CXX::Properties profileProps(&profileStream);
+
+		profileProps.readConfiguration();
+		profileProps.setAccessProfiling(true);
+
+		auto lookups = [&profileProps] {
+			for (int i = 0; i < 1000; i++) {
+				profileProps.getPropertyValue("hot",0LL);
+			}
+			profileProps.getPropertyValue("missing",0LL);
+			profileProps.searchPropertyPath("db.port");
+			profileProps.searchProperty("cache");
+		};
+
+		std::thread otherThread(lookups);
+		lookups();
+		otherThread.join();
+
+		Properties4CXX::PropertyAccessProfile const profile = profileProps.getAccessProfile();
+		std::vector<std::string> const unaccessed = profileProps.getUnaccessedProperties();
+		uint64_t histogramSum = 0;
+
+		for (auto it : profile.front().latencyHistogram) {
+			histogramSum += it;
+		}
+
+		if (profile.size() == 4 && profile.front().key == "hot" && profile.front().hits == 2000 && histogramSum == 2000 &&
+				profile[1].key == "cache" && profile[3].key == "missing" && profile[3].misses == 2 && profile[3].defaulted == 2 &&
+				unaccessed == std::vector<std::string>{"cold","db.host"}) {
+			std::cout << "access profile OK" << std::endl;
+		} else {
+			std::cout << "access profile NOK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in access profile test: " << e.what() << std::endl;
+	}
+
+	// Property tree in a memory resource
+	try {
+		CountingResource resource;
+
+		{
+			std::istringstream resourceStream(
+					"name = value\n"
+					"count = 42\n"
+					"outer = {\n\tinner = {\n\t\tflag = yes\n\t\t}\n\tlist = a , b\n\t}\n");
+			Properties4CXX::Properties resourceProps(&resourceStream,&resource);
+
+			resourceProps.readConfiguration();
+			size_t const allocationsAfterRead = resource.allocations;
+			Properties4CXX::Property const *outer = resourceProps.searchProperty("outer");
+
+			resourceProps.addProperty(Properties4CXX::Property::create<Properties4CXX::PropertyInt>(resourceProps.getMemoryResource(),"added","7",7LL));
+
+			if (allocationsAfterRead > 0 && resource.allocations > allocationsAfterRead && resource.bytesInUse > 0 &&
+					outer && outer->getPropertiesStructure().getMemoryResource() == &resource &&
+					resourceProps.searchPropertyPath("outer.inner.flag")->getBoolValue() == true &&
+					resourceProps.getPropertyValue("added",0LL) == 7) {
+				std::cout << "memory resource OK" << std::endl;
+			} else {
+				std::cout << "memory resource NOK" << std::endl;
+			}
+		}
+
+		if (resource.bytesInUse == 0) {
+			std::cout << "memory resource release OK" << std::endl;
+		} else {
+			std::cout << "memory resource release NOK: " << resource.bytesInUse << " bytes" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in memory resource test: " << e.what() << std::endl;
+	}
+
+	// Compaction into one arena
+	try {
+		CountingResource resource;
+		Properties4CXX::Properties::PropertyPtr sharedProperty;
+
+		{
+			std::istringstream compactStream(
+					"name = \"a value which does not fit into the small string buffer\"\n"
+					"count = 42\n"
+					"ratio = 0.5\n"
+					"outer = {\n\tinner = {\n\t\tflag = yes\n\t\t}\n\tlist = a , b\n\t}\n");
+			Properties4CXX::Properties compactProps(&compactStream,&resource);
+
+			compactProps.readConfiguration();
+
+			std::ostringstream before;
+			compactProps.writeOut(before);
+			uint64_t const hashBefore = compactProps.getContentHash();
+
+			compactProps.compact();
+			size_t const blocksAfterCompact = resource.blocksInUse;
+
+			std::ostringstream after;
+			compactProps.writeOut(after);
+			sharedProperty = compactProps.getPropertyMap().at("outer");
+			compactProps.addProperty(new Properties4CXX::PropertyInt("added",7));
+
+			if (blocksAfterCompact == 1 && before.str() == after.str() && compactProps.getContentHash() == hashBefore + compactProps.searchProperty("added")->getContentHash() &&
+					compactProps.getMemoryResource() == &resource &&
+					compactProps.searchProperty("outer")->getPropertiesStructure().getMemoryResource() == &resource &&
+					compactProps.searchPropertyPath("outer.inner.flag")->getBoolValue() == true &&
+					compactProps.searchPropertyPath("outer.inner.flag")->getSourceOffset() != 0 &&
+					compactProps.getPropertyValue("count",0LL) == 42) {
+				std::cout << "compact OK" << std::endl;
+			} else {
+				std::cout << "compact NOK: " << blocksAfterCompact << " blocks" << std::endl;
+			}
+		}
+
+		// The shared property keeps the arena alive
+		bool const sharedValid = resource.blocksInUse == 1 &&
+				sharedProperty->getPropertiesStructure().searchProperty("list")->getPropertyValueList().size() == 2;
+		sharedProperty.reset();
+
+		if (sharedValid && resource.blocksInUse == 0) {
+			std::cout << "compact release OK" << std::endl;
+		} else {
+			std::cout << "compact release NOK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in compact test: " << e.what() << std::endl;
+	}
+
+	// Memory footprint
+	try {
+		std::istringstream usageStream(
+				"aPropertyNameLongerThanTheSmallStringBuffer = 1\n"
+				"list = \"first long list element\" , \"second long list element\"\n"
+				"outer = {\n\tinner = \"a value which does not fit into the small string buffer\"\n\t}\n");
+		Properties4CXX::Properties usageProps(&usageStream);
+
+		usageProps.readConfiguration();
+
+		Properties4CXX::MemoryUsage const before = usageProps.memoryUsage();
+		usageProps.searchProperty("list")->getStringValue();
+		Properties4CXX::MemoryUsage const after = usageProps.memoryUsage();
+
+		if (before.names > 0 && before.values > 0 && before.lazyStrings == 0 && after.lazyStrings > 0 &&
+				// Four properties on two levels
+				before.mapNodes > 0 && before.mapNodes % 4 == 0 && before.controlBlocks > 0 && before.controlBlocks % 4 == 0 &&
+				// One structure, and the maps of both levels
+				before.structContainers > sizeof(Properties4CXX::Properties) &&
+				before.listNodes > 0 && before.properties > 0 &&
+				after.total() == before.total() + after.lazyStrings) {
+			std::cout << "memory usage OK" << std::endl;
+		} else {
+			std::cout << "memory usage NOK: " << before.total() << " bytes" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in memory usage test: " << e.what() << std::endl;
+	}
+
+	// Interned names and values shared by two configurations
+	try {
+		auto interner = std::make_shared<Properties4CXX::StringInterner>();
+
+		{
+			std::istringstream internStreamA(
+					"server = {\n\thost = \"a host name longer than the buffer\"\n\tport = 80\n\t}\n"
+					"backup = {\n\thost = \"a host name longer than the buffer\"\n\tport = 80\n\t}\n");
+			std::istringstream internStreamB("host = other\n");
+			Properties4CXX::Properties internPropsA(&internStreamA);
+			Properties4CXX::Properties internPropsB(&internStreamB);
+
+			internPropsA.setStringInterner(interner);
+			internPropsA.setInternValues(true);
+			internPropsB.setStringInterner(interner);
+			internPropsA.readConfiguration();
+			internPropsB.readConfiguration();
+
+			Properties4CXX::Property const *serverHost = internPropsA.searchPropertyPath("server.host");
+			Properties4CXX::Property const *backupHost = internPropsA.searchPropertyPath("backup.host");
+			Properties4CXX::Property const *otherHost = internPropsB.searchProperty("host");
+
+			if (serverHost->getInternedName() == backupHost->getInternedName() &&
+					serverHost->getInternedName() == otherHost->getInternedName() &&
+					serverHost->getInternedName() == interner->find("host") &&
+					&serverHost->getStringValue() == &backupHost->getStringValue() &&
+					backupHost->getStringValue() == "a host name longer than the buffer" &&
+					otherHost->getStringValue() == "other" && !interner->find("other") &&
+					internPropsA.searchPropertyPath("backup.port")->getIntVal() == 80) {
+				std::cout << "string interning OK" << std::endl;
+			} else {
+				std::cout << "string interning NOK" << std::endl;
+			}
+
+			// A property created with a plain name gets the interned name when it is added.
+			internPropsB.addProperty(new Properties4CXX::PropertyInt("port",8080));
+			if (internPropsB.searchProperty("port")->getInternedName() == interner->find("port")) {
+				std::cout << "string interning added property OK" << std::endl;
+			} else {
+				std::cout << "string interning added property NOK" << std::endl;
+			}
+		}
+
+		if (interner->purge() > 0 && interner->size() == 0) {
+			std::cout << "string interning purge OK" << std::endl;
+		} else {
+			std::cout << "string interning purge NOK: " << interner->size() << " strings left" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in string interning test: " << e.what() << std::endl;
+	}
+
+	// The map keys refer to the names within the properties, also after replacing properties
+	try {
+		outStream.open("PropertiesTestKeys.properties",outStream.out|outStream.trunc);
+		outStream << "a_rather_long_property_name_beyond_sso = 1\nanother_rather_long_property_name = {\n\tx = 1\n\t}\n";
+		outStream.close();
+
+		setenv("PROPERTIESKEYS_A_RATHER_LONG_PROPERTY_NAME_BEYOND_SSO","7",1);
+
+		Properties4CXX::Properties keyProps("PropertiesTestKeys.properties");
+		keyProps.setEnvironmentOverrides("PROPERTIESKEYS_");
+		keyProps.readConfiguration();
+
+		outStream.open("PropertiesTestKeys.properties",outStream.out|outStream.app);
+		outStream << "another_rather_long_property_name = 2\nanother_rather_long_property_name = 3\n";
+		outStream.close();
+		keyProps.readAppended();
+
+		// The map takes the name from the property, not from the temporary key.
+		Properties4CXX::Properties::PropertyPtr insertedProperty (new Properties4CXX::PropertyInt("inserted_property_with_a_long_name",5));
+		keyProps.getPropertyMap().insert(Properties4CXX::Properties::PropertyPair(std::string(insertedProperty->getPropertyName()),insertedProperty));
+		insertedProperty.reset();
+
+		bool keysOk = keyProps.numProperties() == 3 && keyProps.getPropertyValue("inserted_property_with_a_long_name",0LL) == 5;
+		for (auto it = keyProps.getFirstProperty(); it != keyProps.getListEnd(); ++it) {
+			std::string const &name = it->first;
+			keysOk = keysOk && name.data() == it->second->getPropertyName().data();
+		}
+		keyProps.getPropertyMap().erase("inserted_property_with_a_long_name");
+
+		// The iterators refer to the entries like the ones of std::map, and the name of an inserted pair must match.
+		auto const &keyMap = keyProps.getCPropertyMap();
+		auto const lastEntry = std::prev(keyMap.end());
+		keysOk = keysOk && &*lastEntry == &*keyMap.find("another_rather_long_property_name") &&
+				std::find_if(keyMap.begin(),keyMap.end(),[] (auto const &entry) { return entry.first == "a_rather_long_property_name_beyond_sso"; }) == keyMap.begin();
+		try {
+			Properties4CXX::Properties::PropertyPtr misnamedProperty (new Properties4CXX::PropertyInt("misnamed",5));
+			keyProps.getPropertyMap().insert(Properties4CXX::Properties::PropertyPair("other_name",misnamedProperty));
+			keysOk = false;
+		} catch (std::invalid_argument const &) {
+		}
+
+		if (keysOk && keyProps.getPropertyValue("a_rather_long_property_name_beyond_sso",0LL) == 7 &&
+				keyProps.getPropertyValue("another_rather_long_property_name",0LL) == 3) {
+			std::cout << "single copy property names OK" << std::endl;
+		} else {
+			std::cout << "single copy property names NOK" << std::endl;
+		}
+
+		unsetenv("PROPERTIESKEYS_A_RATHER_LONG_PROPERTY_NAME_BEYOND_SSO");
+	} catch (std::exception const &e) {
+		std::cout << "Exception in single copy property names test: " << e.what() << std::endl;
+	}
+
+	// Copies share the property tree, and modifications copy only the path
+	try {
+		CountingResource resource;
+		std::istringstream baseStream(
+				"name = base\n"
+				"db = {\n\thost = localhost\n\tpool = {\n\t\tsize = 4\n\t\t}\n\t}\n"
+				"cache = {\n\tsize = 100\n\t}\n");
+		Properties4CXX::Properties baseProps(&baseStream,&resource);
+
+		baseProps.readConfiguration();
+
+		size_t const allocationsBefore = resource.allocations;
+		Properties4CXX::Properties tenantProps(baseProps);
+		bool const cloneIsFree = resource.allocations == allocationsBefore &&
+				&tenantProps.getCPropertyMap() == &baseProps.getCPropertyMap();
+
+		tenantProps.setProperty({"db","pool"},new Properties4CXX::PropertyInt("size","8",8));
+		tenantProps.setProperty({},new Properties4CXX::Property("name","tenant"));
+
+		bool wrongTypeThrown = false;
+		try {
+			tenantProps.setProperty({"name"},new Properties4CXX::Property("x","y"));
+		} catch (Properties4CXX::ExceptionWrongPropertyType const &) {
+			wrongTypeThrown = true;
+		}
+
+		auto const &baseMap = baseProps.getCPropertyMap();
+		auto const &tenantMap = tenantProps.getCPropertyMap();
+
+		if (cloneIsFree && wrongTypeThrown &&
+				baseProps.searchPropertyPath("db.pool.size")->getIntVal() == 4 &&
+				baseProps.searchProperty("name")->getStringValue() == "base" &&
+				tenantProps.searchPropertyPath("db.pool.size")->getIntVal() == 8 &&
+				tenantProps.searchPropertyPath("db.host")->getStringValue() == "localhost" &&
+				tenantProps.searchProperty("name")->getStringValue() == "tenant" &&
+				// Untouched structures and properties are shared
+				tenantMap.at("cache") == baseMap.at("cache") &&
+				tenantProps.searchPropertyPath("db.host") == baseProps.searchPropertyPath("db.host") &&
+				tenantMap.at("db") != baseMap.at("db") &&
+				tenantProps.getContentHash() != baseProps.getContentHash()) {
+			std::cout << "copy on write OK" << std::endl;
+		} else {
+			std::cout << "copy on write NOK" << std::endl;
+		}
+
+		// Setting the original values again restores the content
+		tenantProps.setProperty({"db","pool"},new Properties4CXX::PropertyInt("size","4",4));
+		tenantProps.setProperty({},new Properties4CXX::Property("name","base"));
+		tenantProps.setProperty({"extra","deep"},new Properties4CXX::Property("value","1"));
+		tenantProps.deletePropery("extra");
+
+		if (tenantProps.getContentHash() == baseProps.getContentHash() &&
+				tenantProps.searchPropertyPath("db.pool.size")->getIntVal() == 4) {
+			std::cout << "copy on write content hash OK" << std::endl;
+		} else {
+			std::cout << "copy on write content hash NOK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in copy on write test: " << e.what() << std::endl;
+	}
+
+	// An incremental reload does not move the properties which a copy shares within a structure
+	try {
+		outStream.open("PropertiesTestCopyReload.properties",outStream.out|outStream.trunc);
+		outStream << "x = 1\ns = {\n\ta = 1\n\tb = 2\n\t}\n";
+		outStream.close();
+
+		Properties4CXX::Properties reloadProps("PropertiesTestCopyReload.properties");
+		reloadProps.setIncrementalReload(true);
+		reloadProps.readConfiguration();
+
+		Properties4CXX::Properties reloadCopy(reloadProps);
+		reloadCopy.setProperty({"s"},new Properties4CXX::Property("c","3"));
+		size_t const copyOffset = reloadCopy.searchPropertyPath("s.a")->getSourceOffset();
+
+		std::string const newContent = "x = 100000\ns = {\n\ta = 1\n\tb = 2\n\t}\n";
+		outStream.open("PropertiesTestCopyReload.properties",outStream.out|outStream.trunc);
+		outStream << newContent;
+		outStream.close();
+		reloadProps.readConfiguration();
+
+		if (reloadCopy.searchPropertyPath("s.a")->getSourceOffset() == copyOffset &&
+				reloadProps.searchPropertyPath("s.a")->getSourceOffset() == newContent.find("a = 1") &&
+				reloadProps.searchProperty("x")->getIntVal() == 100000) {
+			std::cout << "copy on write incremental reload OK" << std::endl;
+		} else {
+			std::cout << "copy on write incremental reload NOK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in copy on write incremental reload test: " << e.what() << std::endl;
+	}
+
+	// A structure which is modified via the property map of a copy is not the structure of the original
+	try {
+		std::istringstream nestedStream("s = {\n\ta = 1\n\tinner = {\n\t\tb = 2\n\t\t}\n\t}\n");
+		Properties4CXX::Properties nestedProps(&nestedStream);
+
+		nestedProps.readConfiguration();
+		uint64_t const hashBefore = nestedProps.getContentHash();
+
+		Properties4CXX::Properties nestedCopy(nestedProps);
+		auto &copyStruct = static_cast<Properties4CXX::PropertyStruct&>(*nestedCopy.getPropertyMap().at("s"));
+		copyStruct.addProperty(new Properties4CXX::PropertyInt("x","1",1));
+
+		if (!nestedProps.findPropertyPath("s.x") && nestedProps.getContentHash() == hashBefore &&
+				nestedProps.searchProperty("s") != &copyStruct &&
+				nestedCopy.searchPropertyPath("s.x")->getIntVal() == 1 &&
+				nestedCopy.searchPropertyPath("s.a")->getIntVal() == 1 &&
+				nestedCopy.searchPropertyPath("s.inner.b")->getIntVal() == 2) {
+			std::cout << "copy on write nested structure OK" << std::endl;
+		} else {
+			std::cout << "copy on write nested structure NOK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in copy on write nested structure test: " << e.what() << std::endl;
+	}
+
+	// Frozen configuration
+	try {
+		std::istringstream frozenStream(
+				"name = frozen\n"
+				"list = a , b , c\n"
+				"db = {\n\thost = localhost\n\tport = 5432\n\tpool = {\n\t\tsize = 4\n\t\t}\n\t}\n");
+		Properties4CXX::Properties frozenProps(&frozenStream);
+
+		frozenProps.readConfiguration();
+		uint64_t const hashBefore = frozenProps.getContentHash();
+		frozenProps.freeze();
+
+		// Concurrent readers without synchronization
+		bool readsOk[2] = {true,true};
+		auto reads = [&] (bool &ok) {
+			for (int i = 0; i < 1000; i++) {
+				ok = ok && frozenProps.searchPropertyPath("db.pool.size")->getIntVal() == 4 &&
+						frozenProps.getPropertyValue("name","") == std::string("frozen") &&
+						frozenProps.searchProperty("list")->getStringValue() == "\"a\" , \"b\" , \"c\"" &&
+						frozenProps.searchProperty("db")->getPropertiesStructure().searchProperty("port")->getIntVal() == 5432 &&
+						!frozenProps.findPropertyPath("db.missing");
+			}
+		};
+		std::thread otherThread(reads,std::ref(readsOk[1]));
+		reads(readsOk[0]);
+		otherThread.join();
+
+		int rejected = 0;
+		auto expectFrozen = [&] (std::function<void ()> const &modification) {
+			try {
+				modification();
+			} catch (Properties4CXX::ExceptionPropertiesFrozen const &) {
+				rejected++;
+			}
+		};
+		expectFrozen([&] { frozenProps.addProperty(new Properties4CXX::Property("other","x")); });
+		expectFrozen([&] { frozenProps.deletePropery("name"); });
+		expectFrozen([&] { frozenProps.setProperty({"db"},new Properties4CXX::Property("host","x")); });
+		expectFrozen([&] { frozenProps.getPropertyMap(); });
+		expectFrozen([&] { frozenProps.readConfiguration(); });
+		expectFrozen([&] { frozenProps.compact(); });
+
+		// A copy can be modified. The frozen structures are copied on the path.
+		Properties4CXX::Properties thawedProps(frozenProps);
+		thawedProps.setProperty({"db","pool"},new Properties4CXX::PropertyInt("size","8",8));
+
+		if (readsOk[0] && readsOk[1] && rejected == 6 && frozenProps.isFrozen() &&
+				frozenProps.searchProperty("db")->getPropertiesStructure().isFrozen() &&
+				frozenProps.getContentHash() == hashBefore &&
+				frozenProps.searchPropertyPath("db.pool.size")->getIntVal() == 4 &&
+				!thawedProps.isFrozen() && thawedProps.searchPropertyPath("db.pool.size")->getIntVal() == 8) {
+			std::cout << "frozen configuration OK" << std::endl;
+		} else {
+			std::cout << "frozen configuration NOK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in frozen configuration test: " << e.what() << std::endl;
+	}
+
+	// Freezing a copy does not freeze the structures of the original
+	try {
+		std::istringstream sharedStream("name = original\ndb = {\n\tport = 5432\n\tpool = {\n\t\tsize = 4\n\t\t}\n\t}\n");
+		Properties4CXX::Properties originalProps(&sharedStream);
+
+		originalProps.readConfiguration();
+
+		Properties4CXX::Properties frozenCopy(originalProps);
+		frozenCopy.freeze();
+		bool const originalModifiable = !originalProps.searchProperty("db")->getPropertiesStructure().isFrozen() &&
+				!originalProps.searchPropertyPath("db.pool")->getPropertiesStructure().isFrozen();
+
+		originalProps.addProperty(new Properties4CXX::Property("other","x"));
+		originalProps.setProperty({"db","pool"},new Properties4CXX::PropertyInt("size","8",8));
+		originalProps.setProperty({"db"},new Properties4CXX::PropertyInt("port","1234",1234));
+		static_cast<Properties4CXX::PropertyStruct&>(*originalProps.getPropertyMap().at("db")).addProperty(
+				new Properties4CXX::Property("host","localhost"));
+
+		if (originalModifiable && frozenCopy.isFrozen() && frozenCopy.searchProperty("db")->getPropertiesStructure().isFrozen() &&
+				frozenCopy.searchPropertyPath("db.pool")->getPropertiesStructure().isFrozen() &&
+				!originalProps.isFrozen() && !originalProps.searchProperty("db")->getPropertiesStructure().isFrozen() &&
+				originalProps.searchPropertyPath("db.pool.size")->getIntVal() == 8 &&
+				originalProps.searchPropertyPath("db.port")->getIntVal() == 1234 &&
+				originalProps.searchPropertyPath("db.host")->getStringValue() == "localhost" &&
+				frozenCopy.searchPropertyPath("db.pool.size")->getIntVal() == 4 &&
+				frozenCopy.searchPropertyPath("db.port")->getIntVal() == 5432 &&
+				!frozenCopy.findPropertyPath("db.host") && !frozenCopy.findPropertyPath("other")) {
+			std::cout << "freeze copy OK" << std::endl;
+		} else {
+			std::cout << "freeze copy NOK" << std::endl;
+		}
+
+	} catch (std::exception const &e) {
+		std::cout << "Exception in freeze copy test: " << e.what() << std::endl;
+	}
+
 
 }
 